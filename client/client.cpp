@@ -169,8 +169,16 @@ void Client::messageReceived(const Message& msg)
       case Protocol::ServerInfo:
       {
         QString label;
-        msg.payload() >> label;
+        quint32 serverCapabilities;
+        msg.payload() >> label >> serverCapabilities;
         setLabel(label);
+
+        // accept everything we support of what the server offers
+        const quint32 capabilities = serverCapabilities & Protocol::MessageCompression;
+        Message reply(endpointAddress(), Protocol::ClientInfo);
+        reply.payload() << capabilities;
+        send(reply);
+        setCompressionEnabled(capabilities & Protocol::MessageCompression);
         m_initState |= ServerInfoReceived;
         break;
       }
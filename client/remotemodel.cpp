@@ -37,6 +37,8 @@
 #include <QStyle>
 #include <QStyleOptionViewItem>
 
+#include <algorithm>
+
 using namespace GammaRay;
 
 void (*RemoteModel::s_registerClientCallback)() = 0;
@@ -50,9 +52,7 @@ void RemoteModel::Node::clearChildrenData()
 {
   foreach (auto child, children) {
     child->clearChildrenStructure();
-    child->data.clear();
-    child->flags.clear();
-    child->state.clear();
+    child->clearColumnData();
   }
 }
 
@@ -64,28 +64,75 @@ void RemoteModel::Node::clearChildrenStructure()
   columnCount = -1;
 }
 
-void RemoteModel::Node::allocateColumns()
+void RemoteModel::Node::allocateColumns(int column)
 {
-  if (hasColumnData() || !parent || parent->columnCount < 0)
+  if (!parent || column >= parent->columnCount || column < cells.size())
       return;
-  data.resize(parent->columnCount);
-  flags.resize(parent->columnCount);
-  flags.fill(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
-  state.resize(parent->columnCount);
-  state.fill(RemoteModel::Empty | RemoteModel::Outdated);
+  cells.resize(column + 1);
 }
 
 bool RemoteModel::Node::hasColumnData() const
 {
   if (!parent)
     return false;
-  Q_ASSERT(data.size() == flags.size());
-  Q_ASSERT(data.size() == state.size());
-  Q_ASSERT(data.isEmpty() || data.size() == parent->columnCount || parent->columnCount < 0);
+  Q_ASSERT(cells.size() <= parent->columnCount || cells.isEmpty());
+  return !cells.isEmpty();
+}
 
-  return data.size() == parent->columnCount && parent->columnCount > 0;
+RemoteModel::Cell* RemoteModel::Node::cell(int column)
+{
+  if (column < 0 || column >= cells.size())
+    return 0;
+  return &cells[column];
 }
 
+const RemoteModel::Cell* RemoteModel::Node::cell(int column) const
+{
+  if (column < 0 || column >= cells.size())
+    return 0;
+  return &cells.at(column);
+}
+
+void RemoteModel::Node::clearColumnData()
+{
+  cells.clear();
+}
+
+RemoteModel::Cell::Cell() :
+  flags(Qt::ItemIsSelectable | Qt::ItemIsEnabled),
+  state(RemoteModel::Empty | RemoteModel::Outdated)
+{
+  for (int i = 0; i < InlineRoleCount; ++i)
+    roles[i] = -1;
+}
+
+QVariant RemoteModel::Cell::value(int role) const
+{
+  for (int i = 0; i < InlineRoleCount; ++i) {
+    if (roles[i] == role)
+      return values[i];
+  }
+  return extraRoles.value(role);
+}
+
+void RemoteModel::Cell::setItemData(const QHash<int, QVariant> &itemData)
+{
+  extraRoles.clear();
+  int i = 0;
+  for (auto it = itemData.constBegin(); it != itemData.constEnd(); ++it) {
+    if (i < InlineRoleCount) {
+      roles[i] = it.key();
+      values[i] = it.value();
+      ++i;
+    } else {
+      extraRoles.insert(it.key(), it.value());
+    }
+  }
+  for (; i < InlineRoleCount; ++i) {
+    roles[i] = -1;
+    values[i] = QVariant();
+  }
+}
 
 QVariant RemoteModel::s_emptyDisplayValue;
 QVariant RemoteModel::s_emptySizeHintValue;
@@ -93,6 +140,10 @@ QVariant RemoteModel::s_emptySizeHintValue;
 RemoteModel::RemoteModel(const QString &serverObject, QObject *parent) :
   QAbstractItemModel(parent),
   m_pendingDataRequestsTimer(new QTimer(this)),
+  m_prefetchWindow(32),
+  m_maxCachedRows(20000),
+  m_cachedRowCount(0),
+  m_accessCounter(0),
   m_serverObject(serverObject),
   m_myAddress(Protocol::InvalidObjectAddress),
   m_currentSyncBarrier(0),
@@ -209,7 +260,9 @@ QVariant RemoteModel::data(const QModelIndex &index, int role) const
 
   if ((state & Outdated) && ((state & Loading) == 0)) {
     requestDataAndFlags(index);
+    prefetchDataAndFlags(index);
   }
+  node->lastAccess = ++m_accessCounter;
 
   if (state & Empty) { // still waiting for data
     if (role == Qt::DisplayRole)
@@ -218,8 +271,9 @@ QVariant RemoteModel::data(const QModelIndex &index, int role) const
   }
 
   // note .value returns good defaults otherwise
-  Q_ASSERT(node->data.size() > index.column());
-  return node->data.at(index.column()).value(role);
+  const Cell *cell = node->cell(index.column());
+  Q_ASSERT(cell);
+  return cell->value(role);
 }
 
 bool RemoteModel::setData(const QModelIndex& index, const QVariant& value, int role)
@@ -240,10 +294,10 @@ Qt::ItemFlags RemoteModel::flags(const QModelIndex& index) const
 
   Node* node = nodeForIndex(index);
   Q_ASSERT(node);
-  if (!node->hasColumnData())
+  const Cell *cell = node->cell(index.column());
+  if (!cell)
     return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
-  Q_ASSERT(node->flags.size() > index.column());
-  return node->flags.at(index.column());
+  return cell->flags;
 }
 
 QVariant RemoteModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -272,16 +326,52 @@ void RemoteModel::sort(int column, Qt::SortOrder order)
   sendMessage(msg);
 }
 
+int RemoteModel::prefetchWindow() const
+{
+  return m_prefetchWindow;
+}
+
+void RemoteModel::setPrefetchWindow(int rows)
+{
+  m_prefetchWindow = qMax(0, rows);
+}
+
+int RemoteModel::maximumCachedRows() const
+{
+  return m_maxCachedRows;
+}
+
+void RemoteModel::setMaximumCachedRows(int rows)
+{
+  m_maxCachedRows = qMax(0, rows);
+  evictCachedData();
+}
+
 void RemoteModel::newMessage(const GammaRay::Message& msg)
 {
   if (!checkSyncBarrier(msg))
     return;
 
-  switch (msg.type()) {
+  if (msg.type() == Protocol::ModelChangeBatch) {
+    quint32 count;
+    msg.payload() >> count;
+    for (quint32 i = 0; i < count; ++i) {
+      Protocol::MessageType type;
+      msg.payload() >> type;
+      processMessage(type, msg.payload());
+    }
+  } else {
+    processMessage(msg.type(), msg.payload());
+  }
+}
+
+void RemoteModel::processMessage(Protocol::MessageType type, QDataStream& stream)
+{
+  switch (type) {
     case Protocol::ModelRowColumnCountReply:
     {
       Protocol::ModelIndex index;
-      msg.payload() >> index;
+      stream >> index;
       Node *node = nodeForIndex(index);
       if (!node) {
         // This can happen e.g. when we called a blocking operation from the remote client
@@ -293,7 +383,7 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
         break;
       }
       qint32 rowCount, columnCount;
-      msg.payload() >> rowCount >> columnCount;
+      stream >> rowCount >> columnCount;
       // we get -1/-1 if we requested for an invalid index, e.g. due to not having processed
       // all structure changes yet. This will automatically trigger a retry.
       Q_ASSERT((rowCount >= 0 && columnCount >= 0) || (rowCount == -1 && columnCount == -1));
@@ -339,30 +429,32 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
     case Protocol::ModelContentReply:
     {
       quint32 size;
-      msg.payload() >> size;
+      stream >> size;
       Q_ASSERT(size > 0);
       for (quint32 i = 0; i < size; ++i) {
         Protocol::ModelIndex index;
-        msg.payload() >> index;
+        stream >> index;
         Node *node = nodeForIndex(index);
         const auto column = index.last().second;
         const NodeStates state = node ? stateForColumn(node, column) : NoState;
         typedef QHash<int, QVariant> ItemData;
         ItemData itemData;
         qint32 flags;
-        msg.payload() >> itemData >> flags;
+        stream >> itemData >> flags;
         if ((state & Loading) == 0)
           continue; // we didn't ask for this, probably outdated response for a moved cell
 
-        node->allocateColumns();
-        Q_ASSERT(node->data.size() > column);
-        node->data[column] = itemData;
-        node->flags[column] = static_cast<Qt::ItemFlags>(flags);
-        node->state[column] = state & ~(Loading | Empty | Outdated);
+        node->allocateColumns(column);
+        Cell *cell = node->cell(column);
+        Q_ASSERT(cell);
+        cell->setItemData(itemData);
+        cell->flags = static_cast<Qt::ItemFlags>(flags);
+        cell->state = state & ~(Loading | Empty | Outdated);
         // TODO we could do some range compression here
         const QModelIndex qmi = modelIndexForNode(node, column);
         emit dataChanged(qmi, qmi);
       }
+      evictCachedData();
       break;
     }
 
@@ -371,7 +463,7 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
       qint8 orientation;
       qint32 section;
       QHash<qint32, QVariant> data;
-      msg.payload() >> orientation >> section >> data;
+      stream >> orientation >> section >> data;
       Q_ASSERT(orientation == Qt::Horizontal || orientation == Qt::Vertical);
       Q_ASSERT(section >= 0);
       auto &headers = orientation == Qt::Horizontal ? m_horizontalHeaders : m_verticalHeaders;
@@ -388,7 +480,7 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
     {
       Protocol::ModelIndex beginIndex, endIndex;
       QVector<int> roles;
-      msg.payload() >> beginIndex >> endIndex >> roles;
+      stream >> beginIndex >> endIndex >> roles;
       Node *node = nodeForIndex(beginIndex);
       if (!node || node == m_root)
         break;
@@ -402,11 +494,9 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
         if (!currentRow->hasColumnData())
           continue;
         for (int col = beginIndex.last().second; col <= endIndex.last().second; ++col) {
-          const NodeStates state = stateForColumn(currentRow, col);
-          if ((state & Outdated) == 0) {
-            Q_ASSERT(currentRow->state.size() > col);
-            currentRow->state[col] = state | Outdated;
-          }
+          Cell *cell = currentRow->cell(col);
+          if (cell) // unallocated cells are outdated anyway
+            cell->state |= Outdated;
         }
       }
 
@@ -425,7 +515,7 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
     {
       qint8 ori;
       int first, last;
-      msg.payload() >> ori >> first >> last;
+      stream >> ori >> first >> last;
       const Qt::Orientation orientation = static_cast<Qt::Orientation>(ori);
       auto &headers = orientation == Qt::Horizontal ? m_horizontalHeaders : m_verticalHeaders;
 
@@ -440,12 +530,12 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
     {
       Protocol::ModelIndex parentIndex;
       int first, last;
-      msg.payload() >> parentIndex >> first >> last;
+      stream >> parentIndex >> first >> last;
       Q_ASSERT(last >= first);
 
       Node *parentNode = nodeForIndex(parentIndex);
       if (!parentNode || parentNode->rowCount < 0)
-        return; // we don't know the parent yet, so we don't care about changes to it either
+        break; // we don't know the parent yet, so we don't care about changes to it either
       doInsertRows(parentNode, first, last);
       break;
     }
@@ -454,12 +544,12 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
     {
       Protocol::ModelIndex parentIndex;
       int first, last;
-      msg.payload() >> parentIndex >> first >> last;
+      stream >> parentIndex >> first >> last;
       Q_ASSERT(last >= first);
 
       Node *parentNode = nodeForIndex(parentIndex);
       if (!parentNode || parentNode->rowCount < 0)
-        return; // we don't know the parent yet, so we don't care about changes to it either
+        break; // we don't know the parent yet, so we don't care about changes to it either
       doRemoveRows(parentNode, first, last);
       break;
     }
@@ -468,7 +558,7 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
     {
       Protocol::ModelIndex sourceParentIndex, destParentIndex;
       int sourceFirst, sourceLast, destChild;
-      msg.payload() >> sourceParentIndex >> sourceFirst >> sourceLast >> destParentIndex >> destChild;
+      stream >> sourceParentIndex >> sourceFirst >> sourceLast >> destParentIndex >> destChild;
       Q_ASSERT(sourceLast >= sourceFirst);
 
       Node *sourceParent = nodeForIndex(sourceParentIndex);
@@ -504,12 +594,12 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
     {
       Protocol::ModelIndex parentIndex;
       int first, last;
-      msg.payload() >> parentIndex >> first >> last;
+      stream >> parentIndex >> first >> last;
       Q_ASSERT(last >= first);
 
       Node *parentNode = nodeForIndex(parentIndex);
       if (!parentNode || parentNode->rowCount < 0)
-        return; // we don't know the parent yet, so we don't care about changes to it either
+        break; // we don't know the parent yet, so we don't care about changes to it either
 
       doInsertColumns(parentNode, first, last);
       break;
@@ -520,12 +610,12 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
     {
       Protocol::ModelIndex parentIndex;
       int first, last;
-      msg.payload() >> parentIndex >> first >> last;
+      stream >> parentIndex >> first >> last;
       Q_ASSERT(last >= first);
 
       Node *parentNode = nodeForIndex(parentIndex);
       if (!parentNode || parentNode->rowCount < 0)
-        return; // we don't know the parent yet, so we don't care about changes to it either
+        break; // we don't know the parent yet, so we don't care about changes to it either
 
       doRemoveColumns(parentNode, first, last);
       break;
@@ -534,7 +624,7 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
     case Protocol::ModelColumnsMoved:
     {
       // TODO
-      qWarning() << Q_FUNC_INFO << "not implemented yet" << msg.type() << m_serverObject;
+      qWarning() << Q_FUNC_INFO << "not implemented yet" << type << m_serverObject;
       clear();
       break;
     }
@@ -543,7 +633,7 @@ void RemoteModel::newMessage(const GammaRay::Message& msg)
     {
       QVector<Protocol::ModelIndex> parents;
       quint32 hint;
-      msg.payload() >> parents >> hint;
+      stream >> parents >> hint;
 
       if (parents.isEmpty()) { // everything changed (or Qt4)
         emit layoutAboutToBeChanged();
@@ -658,10 +748,10 @@ bool RemoteModel::isAncestor(RemoteModel::Node* ancestor, RemoteModel::Node* chi
 RemoteModel::NodeStates RemoteModel::stateForColumn(RemoteModel::Node* node, int columnIndex) const
 {
   Q_ASSERT(node);
-  if (!node->hasColumnData())
+  const Cell *cell = node->cell(columnIndex);
+  if (!cell)
     return Empty | Outdated;
-  Q_ASSERT(node->state.size() > columnIndex);
-  return node->state.at(columnIndex);
+  return cell->state;
 }
 
 void RemoteModel::requestRowColumnCount(const QModelIndex &index) const
@@ -687,9 +777,12 @@ void RemoteModel::requestDataAndFlags(const QModelIndex& index) const
   const NodeStates state = stateForColumn(node, index.column());
   Q_ASSERT((state & Loading) == 0);
 
-  node->allocateColumns();
-  Q_ASSERT(node->state.size() > index.column());
-  node->state[index.column()] = state | Loading; // mark pending request
+  if (!node->hasColumnData())
+    ++m_cachedRowCount;
+  node->allocateColumns(index.column());
+  Cell *cell = node->cell(index.column());
+  Q_ASSERT(cell);
+  cell->state = state | Loading; // mark pending request
 
   m_pendingDataRequests.push_back(Protocol::fromQModelIndex(index));
   if (m_pendingDataRequests.size() > 100) {
@@ -700,6 +793,62 @@ void RemoteModel::requestDataAndFlags(const QModelIndex& index) const
   }
 }
 
+void RemoteModel::prefetchDataAndFlags(const QModelIndex& index) const
+{
+  if (m_prefetchWindow <= 0)
+    return;
+
+  Node *parentNode = nodeForIndex(index)->parent;
+  Q_ASSERT(parentNode);
+  if (parentNode->rowCount != parentNode->children.size())
+    return; // in the middle of an insertion or removal
+
+  const int first = qMax(0, index.row() - m_prefetchWindow);
+  const int last = qMin(parentNode->rowCount - 1, index.row() + m_prefetchWindow);
+  for (int row = first; row <= last; ++row) {
+    Node *node = parentNode->children.at(row);
+    for (int column = 0; column < parentNode->columnCount; ++column) {
+      const NodeStates state = stateForColumn(node, column);
+      if ((state & Outdated) && ((state & Loading) == 0))
+        requestDataAndFlags(createIndex(row, column, node));
+    }
+  }
+}
+
+void RemoteModel::evictCachedData()
+{
+  if (m_cachedRowCount <= m_maxCachedRows)
+    return;
+
+  QVector<Node*> nodes;
+  collectCachedNodes(m_root, nodes);
+  m_cachedRowCount = nodes.size();
+  if (m_cachedRowCount <= m_maxCachedRows)
+    return;
+
+  // evict a bit more than necessary, so we don't have to do this again on the next reply
+  std::sort(nodes.begin(), nodes.end(), [](Node *lhs, Node *rhs) { return lhs->lastAccess < rhs->lastAccess; });
+  const int evictCount = m_cachedRowCount - m_maxCachedRows * 3 / 4;
+  for (int i = 0; i < evictCount; ++i) {
+    nodes.at(i)->clearColumnData();
+    --m_cachedRowCount;
+  }
+}
+
+void RemoteModel::collectCachedNodes(Node* node, QVector<Node*>& nodes) const
+{
+  foreach (auto child, node->children) {
+    if (child->hasColumnData()) {
+      bool loading = false;
+      foreach (const auto &cell, child->cells)
+        loading |= (cell.state & Loading) != 0;
+      if (!loading) // pending requests would be dropped otherwise
+        nodes.push_back(child);
+    }
+    collectCachedNodes(child, nodes);
+  }
+}
+
 void RemoteModel::doRequestDataAndFlags() const
 {
   Q_ASSERT(!m_pendingDataRequests.isEmpty());
@@ -770,10 +919,8 @@ void RemoteModel::resetLoadingState(RemoteModel::Node* node, int startRow) const
   Q_ASSERT(node->children.size() == node->rowCount);
   for (int row = startRow; row < node->rowCount; ++row) {
     Node *child = node->children.at(row);
-    for (auto it = child->state.begin(); it != child->state.end(); ++it) {
-      if ((*it) & Loading)
-        (*it) = (*it) & ~Loading;
-    }
+    for (auto it = child->cells.begin(); it != child->cells.end(); ++it)
+      it->state &= ~Loading;
     resetLoadingState(child, 0);
   }
 }
@@ -889,13 +1036,11 @@ void RemoteModel::doInsertColumns(RemoteModel::Node* parentNode, int first, int
 
   // adjust column data in all child nodes, if available
   foreach (auto node, parentNode->children) {
-    if (!node->hasColumnData())
-      continue;
+    if (first >= node->cells.size())
+      continue; // nothing allocated right of the new columns
 
     // allocate new columns
-    node->data.insert(first, newColCount, QHash<int, QVariant>());
-    node->flags.insert(first, newColCount, Qt::ItemIsSelectable | Qt::ItemIsEnabled);
-    node->state.insert(first, newColCount, Empty | Outdated);
+    node->cells.insert(first, newColCount, Cell());
   }
 
   // adjust column count
@@ -917,11 +1062,9 @@ void RemoteModel::doRemoveColumns(RemoteModel::Node* parentNode, int first, int
 
   // adjust column data in all child nodes, if available
   foreach (auto node, parentNode->children) {
-    if (!node->hasColumnData())
+    if (first >= node->cells.size())
       continue;
-    node->data.remove(first, delColCount);
-    node->flags.remove(first, delColCount);
-    node->state.remove(first, delColCount);
+    node->cells.remove(first, qMin(delColCount, node->cells.size() - first));
   }
 
   // adjust column count
@@ -39,6 +39,8 @@
 #include <QTimer>
 #include <QVector>
 
+class QDataStream;
+
 namespace GammaRay {
 
 class Message;
@@ -68,6 +70,14 @@ class GAMMARAY_CLIENT_EXPORT RemoteModel : public QAbstractItemModel
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
     void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) Q_DECL_OVERRIDE;
 
+    /** Number of rows above and below a requested row whose data is fetched along with it. */
+    int prefetchWindow() const;
+    void setPrefetchWindow(int rows);
+
+    /** Maximum number of rows for which data is kept, data of the least recently used rows is discarded beyond that. */
+    int maximumCachedRows() const;
+    void setMaximumCachedRows(int rows);
+
   public slots:
     void newMessage(const GammaRay::Message &msg);
     void serverRegistered(const QString &objectName, Protocol::ObjectAddress objectAddress);
@@ -92,8 +102,22 @@ class GAMMARAY_CLIENT_EXPORT RemoteModel : public QAbstractItemModel
     void proxyFilterRegExpChanged();
 
   private:
+    /** Cached data of a single cell. Cells usually only have very few roles set, those are stored inline. */
+    struct Cell {
+      Cell();
+      QVariant value(int role) const;
+      void setItemData(const QHash<int, QVariant> &itemData);
+
+      enum { InlineRoleCount = 3 };
+      qint32 roles[InlineRoleCount];   // role of the corresponding entry in values, -1 if unused
+      QVariant values[InlineRoleCount];
+      QHash<int, QVariant> extraRoles; // only allocated if a cell has more than InlineRoleCount roles
+      Qt::ItemFlags flags;
+      NodeStates state;                // cache outdated, waiting for data, etc
+    };
+
     struct Node { // represents one row
-      Node() : parent(0), rowCount(-1), columnCount(-1) {}
+      Node() : parent(0), rowCount(-1), columnCount(-1), lastAccess(0) {}
       ~Node();
       Q_DISABLE_COPY(Node)
       // delete all cached children data, but assume row/column count on this level is still accurate
@@ -101,24 +125,30 @@ class GAMMARAY_CLIENT_EXPORT RemoteModel : public QAbstractItemModel
       // forget everything we know about our children, including row/column counts
       void clearChildrenStructure();
 
-      // resize the initialize the column vectors
-      void allocateColumns();
-      // returns whether columns are allocated
+      // make sure there is a cell for @p column, cells are only allocated up to the highest column accessed so far
+      void allocateColumns(int column);
+      // returns whether any columns are allocated
       bool hasColumnData() const;
+      // returns the cell for @p column if allocated, @c 0 otherwise
+      Cell* cell(int column);
+      const Cell* cell(int column) const;
+      // discard all cached data and flags of this row
+      void clearColumnData();
 
       Node* parent;
       QVector<Node*> children;
+      QVector<Cell> cells;                 // column -> cell, possibly shorter than the column count
       qint32 rowCount;
       qint32 columnCount;
-      QVector<QHash<int, QVariant> > data; // column -> role -> data
-      QVector<Qt::ItemFlags> flags;        // column -> flags
-      QVector<NodeStates> state;           // column -> state (cache outdated, waiting for data, etc)
+      quint32 lastAccess;                  // value of m_accessCounter when data of this row was last read
     };
 
     void clear();
     void connectToServer();
 
     bool checkSyncBarrier(const Message &msg);
+    /** Handles a single message of type @p type, either received on its own or as part of a ModelChangeBatch. */
+    void processMessage(Protocol::MessageType type, QDataStream &stream);
 
     Node* nodeForIndex(const QModelIndex &index) const;
     Node* nodeForIndex(const Protocol::ModelIndex &index) const;
@@ -131,6 +161,12 @@ class GAMMARAY_CLIENT_EXPORT RemoteModel : public QAbstractItemModel
 
     void requestRowColumnCount(const QModelIndex &index) const;
     void requestDataAndFlags(const QModelIndex &index) const;
+    /// request data for the rows around @p index that the view will likely need next
+    void prefetchDataAndFlags(const QModelIndex &index) const;
+    /// discard data of the least recently used rows if we hold more than m_maxCachedRows
+    void evictCachedData();
+    /// collect all nodes below @p node that hold data
+    void collectCachedNodes(Node *node, QVector<Node*> &nodes) const;
     void requestHeaderData(Qt::Orientation orientation, int section) const;
     /// Reset the loading state for all rows at @p startRow or later.
     /// This is needed when rows have been added or removed before @p startRow, since
@@ -171,6 +207,12 @@ private:
     mutable QVector<Protocol::ModelIndex> m_pendingDataRequests;
     QTimer* m_pendingDataRequestsTimer;
 
+    int m_prefetchWindow;
+    int m_maxCachedRows;
+    // upper bound for the number of rows holding data, exact after evictCachedData()
+    mutable int m_cachedRowCount;
+    mutable quint32 m_accessCounter;
+
     QString m_serverObject;
     Protocol::ObjectAddress m_myAddress;
 
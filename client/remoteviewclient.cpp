@@ -82,3 +82,13 @@ void RemoteViewClient::clientViewUpdated()
 {
     Endpoint::instance()->invokeObject(name(), "clientViewUpdated");
 }
+
+void RemoteViewClient::setTileEncodingEnabled(bool enabled)
+{
+    Endpoint::instance()->invokeObject(name(), "setTileEncodingEnabled", QVariantList() << enabled);
+}
+
+void RemoteViewClient::requestKeyFrame()
+{
+    Endpoint::instance()->invokeObject(name(), "requestKeyFrame");
+}
@@ -45,6 +45,8 @@ public:
     void sendWheelEvent(const QPoint& localPos, QPoint pixelDelta, QPoint angleDelta, int buttons, int modifiers) Q_DECL_OVERRIDE;
     void setViewActive(bool active) Q_DECL_OVERRIDE;
     void clientViewUpdated() Q_DECL_OVERRIDE;
+    void setTileEncodingEnabled(bool enabled) Q_DECL_OVERRIDE;
+    void requestKeyFrame() Q_DECL_OVERRIDE;
 };
 
 }
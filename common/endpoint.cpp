@@ -32,17 +32,31 @@
 #include "propertysyncer.h"
 
 #include <iostream>
+#include <limits>
 
 using namespace GammaRay;
 using namespace std;
 
 Endpoint* Endpoint::s_instance = 0;
 
+// payloads compressed to more than this (in percent) are not worth the effort
+static const int MaximumCompressionRatio = 90;
+// how often we retry compression for objects whose payloads did not compress well
+static const int CompressionRetryInterval = 16;
+// initial capacity of the read buffer, avoids reallocations for typical messages
+static const int ReadBufferSize = 64 * 1024;
+
 Endpoint::Endpoint(QObject* parent):
   QObject(parent),
   m_propertySyncer(new PropertySyncer(this)),
   m_socket(0),
-  m_myAddress(Protocol::InvalidObjectAddress +1)
+  m_myAddress(Protocol::InvalidObjectAddress +1),
+  m_readOffset(0),
+  m_compressionInfo(std::numeric_limits<Protocol::ObjectAddress>::max() + 1),
+  m_compressionEnabled(false),
+  m_payloadBytesSent(0),
+  m_payloadBytesWritten(0),
+  m_compressedMessageCount(0)
 {
   if (s_instance)
     qCritical("Found existing GammaRay::Endpoint instance - trying to attach to a GammaRay client?");
@@ -75,7 +89,30 @@ void Endpoint::send(const Message& msg)
 {
   Q_ASSERT(s_instance);
   Q_ASSERT(msg.address() != Protocol::InvalidObjectAddress);
-  msg.write(s_instance->m_socket);
+  s_instance->writeMessage(msg);
+}
+
+void Endpoint::writeMessage(const Message& msg)
+{
+  const Protocol::PayloadSize payloadSize = msg.payloadSize();
+  bool compress = m_compressionEnabled && payloadSize >= Message::MinimumCompressionSize;
+
+  CompressionInfo &info = m_compressionInfo[msg.address()];
+  if (compress && info.ratio > MaximumCompressionRatio) {
+    // recent payloads for this object did not compress (such as images), only try occasionally
+    compress = ++info.skipped >= CompressionRetryInterval;
+  }
+
+  const Protocol::PayloadSize written = msg.write(m_socket, compress);
+  m_payloadBytesSent += payloadSize;
+  m_payloadBytesWritten += written;
+  if (!compress)
+    return;
+
+  if (written < payloadSize)
+    ++m_compressedMessageCount;
+  info.skipped = 0;
+  info.ratio = (info.ratio + static_cast<int>(qint64(written) * 100 / payloadSize)) / 2;
 }
 
 void Endpoint::sendMessage(const Message& msg)
@@ -93,6 +130,31 @@ bool Endpoint::isConnected()
   return s_instance && s_instance->m_socket;
 }
 
+bool Endpoint::isCompressionEnabled() const
+{
+  return m_compressionEnabled;
+}
+
+void Endpoint::setCompressionEnabled(bool enabled)
+{
+  m_compressionEnabled = enabled;
+}
+
+quint64 Endpoint::payloadBytesSent() const
+{
+  return m_payloadBytesSent;
+}
+
+quint64 Endpoint::payloadBytesWritten() const
+{
+  return m_payloadBytesWritten;
+}
+
+quint64 Endpoint::compressedMessageCount() const
+{
+  return m_compressedMessageCount;
+}
+
 quint16 Endpoint::defaultPort()
 {
   return 11732;
@@ -108,6 +170,9 @@ void Endpoint::setDevice(QIODevice* device)
   Q_ASSERT(!m_socket);
   Q_ASSERT(device);
   m_socket = device;
+  m_readBuffer.clear();
+  m_readBuffer.reserve(ReadBufferSize);
+  m_readOffset = 0;
   connect(m_socket.data(), SIGNAL(readyRead()), SLOT(readyRead()));
   connect(m_socket.data(), SIGNAL(disconnected()), SLOT(connectionClosed()));
   if (m_socket->bytesAvailable())
@@ -121,15 +186,60 @@ Protocol::ObjectAddress Endpoint::endpointAddress() const
 
 void Endpoint::readyRead()
 {
-  while (Message::canReadMessage(m_socket.data())) {
-    messageReceived(Message::readMessage(m_socket.data()));
+  while (m_socket) {
+    const int size = Message::messageSize(m_readBuffer.constData() + m_readOffset, m_readBuffer.size() - m_readOffset);
+    if (size == Message::InvalidMessageSize) {
+      cerr << "Received a malformed message, closing the connection." << endl;
+      m_socket->close();
+      return;
+    }
+    if (size < 0) {
+      if (!fillReadBuffer())
+        return;
+      continue;
+    }
+    // advance before dispatching, message handlers might re-enter the event loop and thus this method
+    const int offset = m_readOffset;
+    m_readOffset += size;
+    messageReceived(Message::fromBuffer(m_readBuffer, offset));
+  }
+}
+
+bool Endpoint::fillReadBuffer()
+{
+  const qint64 available = m_socket->bytesAvailable();
+  if (available <= 0)
+    return false;
+
+  // drop what has been processed already, if a message still shares the buffer this detaches
+  // and leaves the message with the old data
+  if (m_readOffset > 0) {
+    const int pendingSize = m_readBuffer.size() - m_readOffset;
+    if (m_readBuffer.capacity() > ReadBufferSize) {
+      // don't hold on to the memory of a past large message
+      QByteArray buffer;
+      buffer.reserve(qMax<qint64>(ReadBufferSize, pendingSize + available));
+      buffer.append(m_readBuffer.constData() + m_readOffset, pendingSize);
+      m_readBuffer = buffer;
+    } else {
+      m_readBuffer.remove(0, m_readOffset);
+    }
+    m_readOffset = 0;
   }
+
+  const int oldSize = m_readBuffer.size();
+  m_readBuffer.resize(oldSize + static_cast<int>(available));
+  const qint64 readSize = m_socket->read(m_readBuffer.data() + oldSize, available);
+  m_readBuffer.resize(oldSize + qMax<qint64>(0, readSize));
+  return readSize > 0;
 }
 
 void Endpoint::connectionClosed()
 {
   m_socket->deleteLater();
   m_socket = 0;
+  m_compressionEnabled = false;
+  m_compressionInfo.fill(CompressionInfo());
   emit disconnected();
 }
 
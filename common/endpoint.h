@@ -94,6 +94,19 @@ public:
    */
   void waitForMessagesWritten();
 
+  /**
+   * Returns @c true if sent messages are compressed where that is worthwhile,
+   * as negotiated with the other endpoint during the connection handshake.
+   */
+  bool isCompressionEnabled() const;
+
+  /** Total payload size of all messages sent so far, before compression. */
+  quint64 payloadBytesSent() const;
+  /** Total payload size of all messages sent so far, as actually written to the connection. */
+  quint64 payloadBytesWritten() const;
+  /** Number of messages sent so far with a compressed payload. */
+  quint64 compressedMessageCount() const;
+
   /**
    * Returns a human-readable string describing the host program.
    */
@@ -140,6 +153,9 @@ protected:
   /** Call with the socket once you have established a connection to another endpoint, takes ownership of @p device. */
   void setDevice(QIODevice* device);
 
+  /** Enable compression of sent messages, only call this once the other endpoint confirmed it supports that. */
+  void setCompressionEnabled(bool enabled);
+
   /** The object address of the other endpoint. */
   Protocol::ObjectAddress endpointAddress() const;
 
@@ -202,6 +218,25 @@ private:
     QMetaMethod messageHandler;
   };
 
+  struct CompressionInfo
+  {
+    CompressionInfo()
+      : ratio(0)
+      , skipped(0)
+    {
+    }
+    // moving average of the compressed payload size in percent of the uncompressed size
+    quint8 ratio;
+    // messages sent uncompressed since compression was last tried
+    quint8 skipped;
+  };
+
+  /** Appends all data available on the connection to m_readBuffer, returns @c false if there was none. */
+  bool fillReadBuffer();
+
+  /** Writes @p msg to the connection, compressed if enabled and worthwhile for its receiver. */
+  void writeMessage(const Message &msg);
+
   /** Inserts @p oi into all maps. */
   void insertObjectInfo(ObjectInfo *oi);
   /** Removes @p oi from all maps and destroys it. */
@@ -215,6 +250,17 @@ private:
   QPointer<QIODevice> m_socket;
   Protocol::ObjectAddress m_myAddress;
 
+  // received data not processed yet starts at m_readOffset, received messages share this buffer
+  QByteArray m_readBuffer;
+  int m_readOffset;
+
+  // indexed by object address, messages for the same object tend to compress similarly
+  QVector<CompressionInfo> m_compressionInfo;
+  bool m_compressionEnabled;
+  quint64 m_payloadBytesSent;
+  quint64 m_payloadBytesWritten;
+  quint64 m_compressedMessageCount;
+
   QString m_label;
 };
 
@@ -33,25 +33,35 @@
 #include <QDebug>
 #include <qendian.h>
 
-inline QByteArray compress(const QByteArray &src)
+#include <cstring>
+
+static QByteArray compress(const QByteArray &src)
 {
     const qint32 srcSz = src.size();
 
     QByteArray dst;
-    dst.resize(LZ4_compressBound(srcSz + sizeof(srcSz)));
-    *(qint32*)dst.data() = srcSz; // save the source size
+    dst.resize(LZ4_compressBound(srcSz) + sizeof(srcSz));
+    qToBigEndian(srcSz, reinterpret_cast<uchar*>(dst.data())); // save the source size
 
-    const int sz = LZ4_compress_default(src.constData(), dst.data() + sizeof(int), srcSz, dst.size());
+    const int sz = LZ4_compress_default(src.constData(), dst.data() + sizeof(srcSz), srcSz, dst.size() - sizeof(srcSz));
+    if (sz <= 0)
+        return QByteArray();
     dst.resize(sz + sizeof(srcSz));
     return dst;
 }
 
-inline QByteArray uncompress(const QByteArray &src)
+static QByteArray uncompress(const QByteArray &src)
 {
-    const qint32 dstSz = *(const qint32*)src.constData(); // get the dest size
+    qint32 dstSz = 0;
+    if (src.size() < (int)sizeof(dstSz))
+        return QByteArray();
+    dstSz = qFromBigEndian<qint32>(reinterpret_cast<const uchar*>(src.constData())); // get the dest size
+    if (dstSz <= 0 || dstSz > GammaRay::Message::MaximumPayloadSize)
+        return QByteArray();
+
     QByteArray dst;
     dst.resize(dstSz);
-    const int sz = LZ4_decompress_safe(src.constData() + sizeof(dstSz), dst.data(), src.size()- sizeof(dstSz), dstSz);
+    const int sz = LZ4_decompress_safe(src.constData() + sizeof(dstSz), dst.data(), src.size() - sizeof(dstSz), dstSz);
     if (sz <= 0)
         dst.resize(0);
     else
@@ -60,9 +70,9 @@ inline QByteArray uncompress(const QByteArray &src)
 }
 
 static const QDataStream::Version StreamVersion = QDataStream::Qt_4_7;
-#ifdef ENABLE_MESSAGE_COMPRESSSION
-static const int minimumUncompressedSize = 32;
-#endif
+
+// size of the fixed fields preceding the payload
+static const int HeaderSize = sizeof(Protocol::PayloadSize) + sizeof(Protocol::ObjectAddress) + sizeof(Protocol::MessageType);
 
 #if QT_VERSION < 0x040800
 // This template-specialization is missing in qendian.h, required for qFromBigEndian
@@ -72,15 +82,6 @@ template<> inline quint8 qbswap<quint8>(quint8 source)
 }
 #endif
 
-template<typename T> static T readNumber(QIODevice *device)
-{
-  T buffer;
-  const int readSize = device->read((char*)&buffer, sizeof(T));
-  Q_UNUSED(readSize);
-  Q_ASSERT(readSize == sizeof(T));
-  return qFromBigEndian(buffer);
-}
-
 template<typename T> static void writeNumber(QIODevice *device, T value)
 {
   value = qToBigEndian(value);
@@ -89,15 +90,41 @@ template<typename T> static void writeNumber(QIODevice *device, T value)
   Q_ASSERT(writeSize == sizeof(T));
 }
 
+static Protocol::PayloadSize readPayloadSize(const char *data)
+{
+  return qFromBigEndian<Protocol::PayloadSize>(reinterpret_cast<const uchar*>(data));
+}
+
+static Protocol::ObjectAddress readObjectAddress(const char *data)
+{
+  return qFromBigEndian<Protocol::ObjectAddress>(reinterpret_cast<const uchar*>(data + sizeof(Protocol::PayloadSize)));
+}
+
+static Protocol::MessageType readMessageType(const char *data)
+{
+  return qFromBigEndian<Protocol::MessageType>(reinterpret_cast<const uchar*>(data + sizeof(Protocol::PayloadSize) + sizeof(Protocol::ObjectAddress)));
+}
+
+/// number of payload bytes on the wire, negative sizes denote compressed payloads
+static qint64 payloadBytes(Protocol::PayloadSize payloadSize)
+{
+  // not abs(), that is undefined for the smallest negative value
+  return payloadSize < 0 ? -static_cast<qint64>(payloadSize) : payloadSize;
+}
+
 using namespace GammaRay;
 
 Message::Message() :
+  m_payloadOffset(0),
+  m_payloadSize(-1),
   m_objectAddress(Protocol::InvalidObjectAddress),
   m_messageType(Protocol::InvalidMessageType)
 {
 }
 
 Message::Message(Protocol::ObjectAddress objectAddress, Protocol::MessageType type) :
+  m_payloadOffset(0),
+  m_payloadSize(-1),
   m_objectAddress(objectAddress),
   m_messageType(type)
 {
@@ -106,6 +133,8 @@ Message::Message(Protocol::ObjectAddress objectAddress, Protocol::MessageType ty
 #ifdef Q_COMPILER_RVALUE_REFS
 Message::Message(Message&& other) :
   m_buffer(std::move(other.m_buffer)),
+  m_payloadOffset(other.m_payloadOffset),
+  m_payloadSize(other.m_payloadSize),
   m_objectAddress(other.m_objectAddress),
   m_messageType(other.m_messageType)
 {
@@ -133,8 +162,11 @@ QDataStream& Message::payload() const
   if (!m_stream) {
     if (m_buffer.isEmpty())
       m_stream.reset(new QDataStream(&m_buffer, QIODevice::WriteOnly));
-    else
-      m_stream.reset(new QDataStream(m_buffer));
+    else {
+      // limit the stream to our payload, in case m_buffer is shared with the following messages
+      const QByteArray payload = m_payloadSize >= 0 ? QByteArray::fromRawData(m_buffer.constData() + m_payloadOffset, m_payloadSize) : m_buffer;
+      m_stream.reset(new QDataStream(payload));
+    }
     m_stream->setVersion(StreamVersion);
   }
   return *m_stream;
@@ -154,66 +186,103 @@ bool Message::canReadMessage(QIODevice* device)
   if (payloadSize == -1 && !device->isSequential()) // input end on shared memory
     return false;
 
-  payloadSize = abs(qFromBigEndian(payloadSize));
-  return device->bytesAvailable() >= payloadSize + minimumSize;
+  const qint64 size = payloadBytes(qFromBigEndian(payloadSize));
+  if (size > MaximumPayloadSize)
+    return false;
+  return device->bytesAvailable() >= size + minimumSize;
 }
 
 Message Message::readMessage(QIODevice* device)
 {
-  Message msg;
+  char header[HeaderSize];
+  const int headerSize = device->read(header, HeaderSize);
+  Q_UNUSED(headerSize);
+  Q_ASSERT(headerSize == HeaderSize);
+
+  const qint64 payloadSize = payloadBytes(readPayloadSize(header));
+  if (payloadSize > MaximumPayloadSize)
+    return Message();
+  QByteArray buffer;
+  buffer.resize(HeaderSize + payloadSize);
+  memcpy(buffer.data(), header, HeaderSize);
+  if (payloadSize > 0) {
+    const int readSize = device->read(buffer.data() + HeaderSize, payloadSize);
+    Q_UNUSED(readSize);
+    Q_ASSERT(readSize == payloadSize);
+  }
+  return fromBuffer(buffer, 0);
+}
 
-  Protocol::PayloadSize payloadSize = readNumber<qint32>(device);
+int Message::messageSize(const char* data, int size)
+{
+  if (size < HeaderSize)
+    return -1;
+  const qint64 payloadSize = payloadBytes(readPayloadSize(data));
+  if (payloadSize > MaximumPayloadSize)
+    return InvalidMessageSize;
+  const int messageSize = HeaderSize + static_cast<int>(payloadSize);
+  return size >= messageSize ? messageSize : -1;
+}
 
-  msg.m_objectAddress = readNumber<Protocol::ObjectAddress>(device);
-  msg.m_messageType = readNumber<Protocol::MessageType>(device);
+Message Message::fromBuffer(const QByteArray& buffer, int offset)
+{
+  Q_ASSERT(messageSize(buffer.constData() + offset, buffer.size() - offset) > 0);
+  const char *data = buffer.constData() + offset;
+
+  Message msg;
+  const Protocol::PayloadSize payloadSize = readPayloadSize(data);
+  msg.m_objectAddress = readObjectAddress(data);
+  msg.m_messageType = readMessageType(data);
   Q_ASSERT(msg.m_messageType != Protocol::InvalidMessageType);
   Q_ASSERT(msg.m_objectAddress != Protocol::InvalidObjectAddress);
+
   if (payloadSize < 0) {
-    payloadSize = abs(payloadSize);
-    QByteArray buff = device->read(payloadSize);
-    msg.m_buffer = uncompress(buff);
-    Q_ASSERT(payloadSize == buff.size());
-  } else {
-      if (payloadSize > 0) {
-          msg.m_buffer = device->read(payloadSize);
-          Q_ASSERT(payloadSize == msg.m_buffer.size());
-      }
+    msg.m_buffer = uncompress(QByteArray::fromRawData(data + HeaderSize, static_cast<int>(payloadBytes(payloadSize))));
+  } else if (payloadSize > 0) {
+    // share buffer and read the payload in place, rather than copying it out
+    msg.m_buffer = buffer;
+    msg.m_payloadOffset = offset + HeaderSize;
+    msg.m_payloadSize = payloadSize;
   }
   return msg;
 }
 
+Protocol::PayloadSize Message::payloadSize() const
+{
+  return m_payloadSize >= 0 ? m_payloadSize : m_buffer.size();
+}
+
 void Message::write(QIODevice* device) const
+{
+  write(device, false);
+}
+
+Protocol::PayloadSize Message::write(QIODevice* device, bool allowCompression) const
 {
   Q_ASSERT(m_objectAddress != Protocol::InvalidObjectAddress);
   Q_ASSERT(m_messageType != Protocol::InvalidMessageType);
-  const int buffSize = m_buffer.size();
-#ifdef ENABLE_MESSAGE_COMPRESSSION
+  const QByteArray payload = m_payloadSize >= 0 ? QByteArray::fromRawData(m_buffer.constData() + m_payloadOffset, m_payloadSize) : m_buffer;
+  const int buffSize = payload.size();
+
   QByteArray buff;
-  if (buffSize > minimumUncompressedSize)
-    buff = compress(m_buffer);
+  if (allowCompression && buffSize >= MinimumCompressionSize)
+    buff = compress(payload);
+  const bool compressed = !buff.isEmpty() && buff.size() < buffSize;
 
-  if (buff.size() && buff.size() <  buffSize)
-      writeNumber<Protocol::PayloadSize>(device, -buff.size()); // send compressed Buffer
+  if (compressed)
+    writeNumber<Protocol::PayloadSize>(device, -buff.size()); // send compressed buffer
   else
-#endif
-      writeNumber<Protocol::PayloadSize>(device, buffSize); // send uncompressed Buffer
+    writeNumber<Protocol::PayloadSize>(device, buffSize); // send uncompressed buffer
 
   writeNumber(device, m_objectAddress);
   writeNumber(device, m_messageType);
 
-#ifdef ENABLE_MESSAGE_COMPRESSSION
-  if (buffSize) {
-      if (buff.size() && buff.size() <  buffSize) {
-        const int s = device->write(buff);
-        Q_ASSERT(s == buff.size());
-        Q_UNUSED(s);
-      } else {
-#endif
-        const int s = device->write(m_buffer);
-        Q_ASSERT(s == m_buffer.size());
-        Q_UNUSED(s);
-#ifdef ENABLE_MESSAGE_COMPRESSSION
-      }
-  }
-#endif
+  if (!buffSize)
+    return 0;
+
+  const QByteArray &data = compressed ? buff : payload;
+  const int s = device->write(data);
+  Q_ASSERT(s == data.size());
+  Q_UNUSED(s);
+  return data.size();
 }
@@ -40,10 +40,12 @@ namespace GammaRay {
 /**
  * Single message send between client and server.
  * Binary format:
- * - sizeof(Protocol::PayloadSize) byte size of the message payload (not including the size and other fixed fields itself) in netowork byte order (big endian)
+ * - sizeof(Protocol::PayloadSize) byte size of the message payload (not including the size and other fixed fields itself) in netowork byte order (big endian),
+ *   negative if the payload is LZ4 compressed
  * - sizeof(Protocol::ObjectAddress) server object address (big endian)
  * - sizeof(Protocol::MessageType) command type (big endian)
- * - size bytes message payload (encoding is user defined, QDataStream provided for convenience)
+ * - size bytes message payload (encoding is user defined, QDataStream provided for convenience),
+ *   compressed payloads are prefixed with the uncompressed size (big endian)
  */
 class GAMMARAY_COMMON_EXPORT Message
 {
@@ -74,13 +76,42 @@ class GAMMARAY_COMMON_EXPORT Message
     /** Read the next message from @p device. */
     static Message readMessage(QIODevice *device);
 
+    /** Returns the size of the message at the start of the @p size bytes at @p data,
+     *  -1 if they do not contain a complete message yet, or InvalidMessageSize if the
+     *  header announces a payload larger than MaximumPayloadSize.
+     */
+    static int messageSize(const char *data, int size);
+    /** Returns the message starting at @p offset in @p buffer, which must be complete (see messageSize()).
+     *  The payload is not copied, the message shares @p buffer instead.
+     */
+    static Message fromBuffer(const QByteArray &buffer, int offset);
+
+    /** Size of the uncompressed message payload. */
+    Protocol::PayloadSize payloadSize() const;
+
     /** Write this message to @p device. */
     void write(QIODevice *device) const;
+    /** Write this message to @p device, with the payload compressed if @p allowCompression is set,
+     *  the payload is at least MinimumCompressionSize bytes large and compression actually reduces its size.
+     *  Only use this if the receiving side announced support for compressed messages.
+     *  @return The number of payload bytes written.
+     */
+    Protocol::PayloadSize write(QIODevice *device, bool allowCompression) const;
+
+    /** Payloads smaller than this are never compressed, the gain is not worth the effort there. */
+    enum { MinimumCompressionSize = 256 };
+    /** Upper bound for the (compressed or uncompressed) payload size of received messages. */
+    enum { MaximumPayloadSize = 256 * 1024 * 1024 };
+    /** Returned by messageSize() for malformed input. */
+    enum { InvalidMessageSize = -2 };
 
   private:
     Message();
 
     mutable QByteArray m_buffer;
+    // location of the payload in m_buffer for received messages sharing a larger buffer, m_payloadSize is -1 otherwise
+    int m_payloadOffset;
+    Protocol::PayloadSize m_payloadSize;
     mutable QScopedPointer<QDataStream> m_stream;
 
     Protocol::ObjectAddress m_objectAddress;
@@ -30,6 +30,7 @@
 #define GAMMARAY_MODELINSPECTORINTERFACE_H
 
 #include <QObject>
+#include <QStringList>
 
 namespace GammaRay {
 
@@ -40,8 +41,20 @@ class ModelInspectorInterface : public QObject
     explicit ModelInspectorInterface(QObject *parent = 0);
     virtual ~ModelInspectorInterface();
 
+  public slots:
+    /**
+     * Enable consistency checks of the currently selected model.
+     * @since 2.5
+     */
+    virtual void setModelTestEnabled(bool enabled) = 0;
+
   signals:
     void cellSelected(int row, int col, const QString &internalId, const QString &internalPtr);
+    /**
+     * State of the consistency checks of the currently selected model.
+     * @since 2.5
+     */
+    void modelTestResult(bool enabled, const QString &summary, const QStringList &failures);
 };
 
 }
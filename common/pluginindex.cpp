@@ -0,0 +1,156 @@
+/*
+  pluginindex.cpp
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pluginindex.h"
+#include "paths.h"
+
+#include <QFileInfo>
+#include <QLibrary>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QPluginLoader>
+#include <QSaveFile>
+#endif
+
+using namespace GammaRay;
+
+static const int IndexVersion = 1;
+
+PluginIndex::PluginIndex(const QString &pluginPath) :
+    m_dir(pluginPath),
+    m_modified(false)
+{
+    load();
+}
+
+QString PluginIndex::fileName()
+{
+    return QStringLiteral("gammaray-plugins.index");
+}
+
+bool PluginIndex::isModified() const
+{
+    return m_modified;
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+static bool isPluginFile(const QString &path)
+{
+    // OSX has broken QLibrary::isLibrary() - QTBUG-50446
+    return QLibrary::isLibrary(path) || path.endsWith(Paths::pluginExtension(), Qt::CaseInsensitive);
+}
+
+static bool isUpToDate(const QJsonObject &entry, const QFileInfo &fi)
+{
+    return !entry.isEmpty()
+        && static_cast<qint64>(entry.value(QStringLiteral("size")).toDouble()) == fi.size()
+        && static_cast<qint64>(entry.value(QStringLiteral("lastModified")).toDouble()) == fi.lastModified().toMSecsSinceEpoch();
+}
+
+void PluginIndex::load()
+{
+    QFile file(m_dir.absoluteFilePath(fileName()));
+    if (!file.open(QFile::ReadOnly))
+        return;
+
+    const QJsonObject index = QJsonDocument::fromJson(file.readAll()).object();
+    if (index.value(QStringLiteral("version")).toInt() != IndexVersion)
+        return;
+    m_plugins = index.value(QStringLiteral("plugins")).toObject();
+}
+
+PluginInfo PluginIndex::pluginInfo(const QString &path)
+{
+    if (!isPluginFile(path))
+        return PluginInfo(path);
+
+    const QFileInfo fi(path);
+    QJsonObject entry = m_plugins.value(fi.fileName()).toObject();
+    if (!isUpToDate(entry, fi)) {
+        entry = QJsonObject();
+        entry.insert(QStringLiteral("size"), static_cast<double>(fi.size()));
+        entry.insert(QStringLiteral("lastModified"), static_cast<double>(fi.lastModified().toMSecsSinceEpoch()));
+        entry.insert(QStringLiteral("metaData"), QPluginLoader(path).metaData());
+        m_plugins.insert(fi.fileName(), entry);
+        m_modified = true;
+    }
+
+    PluginInfo info;
+    info.initFromMetaData(path, entry.value(QStringLiteral("metaData")).toObject());
+    return info;
+}
+
+void PluginIndex::update()
+{
+    m_plugins = QJsonObject();
+    m_modified = true;
+    foreach (const QString &entry, m_dir.entryList(QStringList(QLatin1Char('*') + Paths::pluginExtension()), QDir::Files))
+        pluginInfo(m_dir.absoluteFilePath(entry));
+}
+
+bool PluginIndex::save()
+{
+    // avoid pointless attempts on every startup from a read-only installation
+    if (!QFileInfo(m_dir.absolutePath()).isWritable())
+        return false;
+
+    QJsonObject index;
+    index.insert(QStringLiteral("version"), IndexVersion);
+    index.insert(QStringLiteral("plugins"), m_plugins);
+
+    QSaveFile file(m_dir.absoluteFilePath(fileName()));
+    if (!file.open(QFile::WriteOnly))
+        return false;
+    file.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+    if (!file.commit())
+        return false;
+    m_modified = false;
+    return true;
+}
+#else
+void PluginIndex::load()
+{
+}
+
+PluginInfo PluginIndex::pluginInfo(const QString &path)
+{
+    return PluginInfo(path);
+}
+
+void PluginIndex::update()
+{
+}
+
+bool PluginIndex::save()
+{
+    return false;
+}
+#endif
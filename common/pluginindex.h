@@ -0,0 +1,82 @@
+/*
+  pluginindex.h
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMMARAY_PLUGININDEX_H
+#define GAMMARAY_PLUGININDEX_H
+
+#include "plugininfo.h"
+
+#include <QDir>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QJsonObject>
+#endif
+
+namespace GammaRay {
+
+/** Cache of the meta-data of all plugins in one plugin directory.
+ *  This allows to discover plugins without opening every plugin file, which is
+ *  noticeably slow on network file systems. Entries are validated against size and
+ *  modification time of the plugin file, and re-read from the plugin if outdated.
+ *  Without Qt5-style embedded plugin meta-data, this directly falls back to PluginInfo.
+ *  @since 2.5
+ */
+class PluginIndex
+{
+public:
+    /** Loads the index of @p pluginPath, if there is one. */
+    explicit PluginIndex(const QString &pluginPath);
+
+    /** Meta-data of the plugin @p path, from the index if it is up to date. */
+    PluginInfo pluginInfo(const QString &path);
+
+    /** Re-reads the meta-data of all plugins in the plugin directory. */
+    void update();
+
+    /** Returns @c true if entries have been added or updated since loading. */
+    bool isModified() const;
+
+    /** Writes the index into the plugin directory.
+     *  @returns @c false if that is not possible, e.g. because the directory is read-only.
+     */
+    bool save();
+
+    /** File name of the index inside a plugin directory. */
+    static QString fileName();
+
+private:
+    void load();
+
+    QDir m_dir;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    QJsonObject m_plugins;
+#endif
+    bool m_modified;
+};
+}
+
+#endif // GAMMARAY_PLUGININDEX_H
@@ -108,8 +108,15 @@ void PluginInfo::initFromJSON(const QString& path)
 {
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
     const QPluginLoader loader(path);
-    const QJsonObject metaData = loader.metaData();
+    initFromMetaData(path, loader.metaData());
+#else
+    Q_UNUSED(path);
+#endif
+}
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+void PluginInfo::initFromMetaData(const QString &path, const QJsonObject &metaData)
+{
     m_interface = metaData.value(QStringLiteral("IID")).toString();
     const QJsonObject customData = metaData.value(QStringLiteral("MetaData")).toObject();
 
@@ -124,10 +131,8 @@ void PluginInfo::initFromJSON(const QString& path)
       m_supportedTypes.push_back((*it).toString());
 
     m_path = path;
-#else
-    Q_UNUSED(path);
-#endif
 }
+#endif
 
 void PluginInfo::initFromDesktopFile(const QString& path)
 {
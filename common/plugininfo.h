@@ -32,6 +32,10 @@
 #include <QString>
 #include <QStringList>
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+class QJsonObject;
+#endif
+
 namespace GammaRay {
 
 /** Meta-data about a specific plugin.
@@ -54,7 +58,11 @@ public:
     bool isValid() const;
 
 private:
+    friend class PluginIndex;
     void initFromJSON(const QString &path);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    void initFromMetaData(const QString &path, const QJsonObject &metaData);
+#endif
     void initFromDesktopFile(const QString &path);
 
     QString m_path;
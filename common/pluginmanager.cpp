@@ -28,6 +28,7 @@
 
 #include "config-gammaray.h"
 #include "pluginmanager.h"
+#include "pluginindex.h"
 #include "paths.h"
 
 #include <QCoreApplication>
@@ -83,9 +84,10 @@ void PluginManagerBase::scan(const QString &serviceType)
   foreach (const QString &pluginPath, pluginPaths()) {
     const QDir dir(pluginPath);
     IF_DEBUG(cout << "checking plugin path: " << qPrintable(dir.absolutePath()) << endl);
+    PluginIndex index(dir.absolutePath());
     foreach (const QString &plugin, dir.entryList(pluginFilter(), QDir::Files)) {
       const QString pluginFile = dir.absoluteFilePath(plugin);
-      const PluginInfo pluginInfo(pluginFile);
+      const PluginInfo pluginInfo = index.pluginInfo(pluginFile);
 
       if (!pluginInfo.isValid() || loadedPluginNames.contains(pluginInfo.id())) {
         continue;
@@ -99,5 +101,7 @@ void PluginManagerBase::scan(const QString &serviceType)
       if (createProxyFactory(pluginInfo, m_parent))
         loadedPluginNames.push_back(pluginInfo.id());
     }
+    if (index.isModified())
+      index.save();
   }
 }
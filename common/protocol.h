@@ -84,6 +84,7 @@ enum BuildInMessageType {
   ModelColumnsRemoved,
   ModelReset,
   ModelLayoutChanged,
+  ModelChangeBatch,
 
   // server <-> client
   SelectionModelSelect,
@@ -97,7 +98,16 @@ enum BuildInMessageType {
 
   // probe settings provided by the launcher
   ProbeSettings,
-  ServerAddress
+  ServerAddress,
+
+  // client -> server, answer to ServerInfo
+  ClientInfo
+};
+
+/** Optional protocol features, offered by the server in ServerInfo and accepted by the client in ClientInfo. */
+enum Capability {
+  NoCapabilities = 0,
+  MessageCompression = 1 ///< message payloads may be LZ4 compressed, see Message::write()
 };
 
 typedef QVector<QPair<qint32, qint32> > ModelIndex;
@@ -79,6 +79,32 @@ void RemoteViewFrame::setImage(const QImage& image)
     m_image.setImage(image);
 }
 
+void RemoteViewFrame::setDirtyTiles(const QVector<QRect>& tiles)
+{
+    m_image.setDirtyTiles(tiles);
+}
+
+bool RemoteViewFrame::isDelta() const
+{
+    return m_image.isDelta();
+}
+
+qint64 RemoteViewFrame::encodedImageSize() const
+{
+    return m_image.encodedSize();
+}
+
+bool RemoteViewFrame::applyDelta(const RemoteViewFrame& previous)
+{
+    if (!m_image.isDelta() || !previous.isValid())
+        return false;
+    QImage img = previous.image();
+    if (!m_image.applyDelta(img))
+        return false;
+    m_image.setImage(img);
+    return true;
+}
+
 QVariant RemoteViewFrame::data() const
 {
     return m_data;
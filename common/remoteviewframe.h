@@ -63,6 +63,18 @@ public:
     QImage image() const;
     void setImage(const QImage &image);
 
+    /// only transfer the given tiles of the image, relative to the previously sent frame
+    void setDirtyTiles(const QVector<QRect> &tiles);
+    /// returns @c true if this frame has been encoded relative to the previous one
+    bool isDelta() const;
+    /// number of image bytes this frame puts on the wire
+    qint64 encodedImageSize() const;
+    /**
+     * Completes a received delta frame with the image content of @p previous.
+     * Returns @c false if that is not possible and a new key frame is needed.
+     */
+    bool applyDelta(const RemoteViewFrame &previous);
+
     /// tool specific frame data
     QVariant data() const;
     void setData(const QVariant &data);
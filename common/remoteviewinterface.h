@@ -65,6 +65,12 @@ public slots:
     /// Tell the server we are ready for the next frame.
     virtual void clientViewUpdated() = 0;
 
+    /// Tell the server we are able to apply delta frames containing only changed tiles.
+    virtual void setTileEncodingEnabled(bool enabled) = 0;
+
+    /// Ask the server to send the next frame in full, e.g. because a delta frame could not be applied.
+    virtual void requestKeyFrame() = 0;
+
 signals:
     void reset();
     void frameUpdated(const GammaRay::RemoteViewFrame &frame);
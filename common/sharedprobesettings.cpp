@@ -0,0 +1,175 @@
+/*
+  sharedprobesettings.cpp
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sharedprobesettings.h"
+#include "protocol.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QSharedMemory>
+#include <QString>
+#include <QUuid>
+
+#include <cstring>
+
+#if defined(Q_OS_UNIX) && !defined(QT_POSIX_IPC)
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <unistd.h>
+#endif
+
+using namespace GammaRay;
+
+// same as used for messages
+static const QDataStream::Version StreamVersion = QDataStream::Qt_4_7;
+
+#ifndef QT_NO_SHAREDMEMORY
+/** Checks that the segment attached to @p memory was created by and belongs to our user. */
+static bool isOwnedByCurrentUser(const QSharedMemory &memory)
+{
+#if defined(Q_OS_UNIX) && !defined(QT_POSIX_IPC)
+  // QSharedMemory derives the System V key from a file named after the native key, the same way
+  const key_t ipcKey = ftok(QFile::encodeName(memory.nativeKey()).constData(), 'Q');
+  if (ipcKey == -1)
+    return false;
+  const int id = shmget(ipcKey, 0, 0400);
+  if (id == -1)
+    return false;
+  struct shmid_ds info;
+  if (shmctl(id, IPC_STAT, &info) == -1)
+    return false;
+  return info.shm_perm.uid == geteuid() && info.shm_perm.cuid == geteuid();
+#elif defined(Q_OS_WIN)
+  // named objects are local to the session, the nonce has to suffice here
+  Q_UNUSED(memory);
+  return true;
+#else
+  // nothing we know how to verify
+  Q_UNUSED(memory);
+  return false;
+#endif
+}
+#endif
+
+QString SharedProbeSettings::key(qint64 launcherId)
+{
+  return QStringLiteral("gammaray-settings-") + QString::number(launcherId);
+}
+
+QByteArray SharedProbeSettings::createNonce()
+{
+  // random based, from /dev/urandom or the system's GUID generator where available
+  return QUuid::createUuid().toRfc4122().toHex();
+}
+
+bool SharedProbeSettings::publish(QSharedMemory *memory, const QByteArray &nonce,
+                                  const QHash<QByteArray, QByteArray> &settings)
+{
+#ifndef QT_NO_SHAREDMEMORY
+  if (nonce.isEmpty())
+    return false;
+
+  QByteArray data;
+  {
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(StreamVersion);
+    stream << Protocol::version() << nonce << settings;
+  }
+
+  // an existing segment might have been planted by someone else, never reuse that
+  const qint32 size = data.size();
+  if (!memory->create(sizeof(size) + size))
+    return false;
+
+  memory->lock();
+  char *dest = static_cast<char*>(memory->data());
+  memcpy(dest, &size, sizeof(size));
+  memcpy(dest + sizeof(size), data.constData(), size);
+  memory->unlock();
+  return true;
+#else
+  Q_UNUSED(memory);
+  Q_UNUSED(nonce);
+  Q_UNUSED(settings);
+  return false;
+#endif
+}
+
+bool SharedProbeSettings::read(qint64 launcherId, const QByteArray &nonce,
+                               QHash<QByteArray, QByteArray> *settings)
+{
+#ifndef QT_NO_SHAREDMEMORY
+  if (nonce.isEmpty())
+    return false;
+
+  QSharedMemory memory(key(launcherId));
+  if (!memory.attach(QSharedMemory::ReadOnly))
+    return false;
+  if (!isOwnedByCurrentUser(memory)) {
+    memory.detach();
+    return false;
+  }
+
+  QByteArray data;
+  memory.lock();
+  qint32 size = 0;
+  if (memory.size() >= static_cast<int>(sizeof(size))) {
+    const char *src = static_cast<const char*>(memory.constData());
+    memcpy(&size, src, sizeof(size));
+    if (size > 0 && size <= memory.size() - static_cast<int>(sizeof(size)))
+      data = QByteArray(src + sizeof(size), size);
+  }
+  memory.unlock();
+  memory.detach();
+
+  if (data.isEmpty())
+    return false;
+
+  QDataStream stream(data);
+  stream.setVersion(StreamVersion);
+  qint32 version;
+  stream >> version;
+  if (version != Protocol::version())
+    return false;
+  QByteArray publishedNonce;
+  stream >> publishedNonce;
+  if (stream.status() != QDataStream::Ok || publishedNonce != nonce)
+    return false;
+  QHash<QByteArray, QByteArray> result;
+  stream >> result;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+  *settings = result;
+  return true;
+#else
+  Q_UNUSED(launcherId);
+  Q_UNUSED(nonce);
+  Q_UNUSED(settings);
+  return false;
+#endif
+}
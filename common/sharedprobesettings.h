@@ -0,0 +1,80 @@
+/*
+  sharedprobesettings.h
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMMARAY_SHAREDPROBESETTINGS_H
+#define GAMMARAY_SHAREDPROBESETTINGS_H
+
+#include "gammaray_common_export.h"
+
+#include <QHash>
+
+class QByteArray;
+class QSharedMemory;
+class QString;
+
+namespace GammaRay {
+
+/** @brief Probe settings handed from the launcher to the probe via shared memory.
+ *  Unlike the local socket connection to the launcher, this requires no round-trip
+ *  and thus doesn't block the startup of the target.
+ *
+ *  Anyone can create a segment with the well-known key, so the settings are only
+ *  trusted if the segment contains a random nonce the launcher passed to the target
+ *  in its environment, and if it is owned by the same user. Without that nonce, i.e.
+ *  when attaching to a running process, the probe has to use the socket instead.
+ *  @since 2.5
+ */
+namespace SharedProbeSettings
+{
+  /** Shared memory key for the launcher with id @p launcherId. */
+  GAMMARAY_COMMON_EXPORT QString key(qint64 launcherId);
+
+  /** Returns a new random nonce, to be passed to the target via the GAMMARAY_SETTINGS_NONCE
+   *  environment variable and to publish().
+   */
+  GAMMARAY_COMMON_EXPORT QByteArray createNonce();
+
+  /** Creates the shared memory segment @p memory and writes @p nonce and @p settings into it.
+   *  The key of @p memory has to be set already, the settings are available as long
+   *  as @p memory exists.
+   *  @returns @c false if that fails, including if a segment with that key exists already,
+   *  as we can't tell who created it.
+   */
+  GAMMARAY_COMMON_EXPORT bool publish(QSharedMemory *memory, const QByteArray &nonce,
+                                      const QHash<QByteArray, QByteArray> &settings);
+
+  /** Reads the settings published by the launcher with id @p launcherId into @p settings.
+   *  @returns @c false if there are none, if they are from an incompatible launcher, if the
+   *  segment is not owned by our user, or if it does not contain @p nonce.
+   */
+  GAMMARAY_COMMON_EXPORT bool read(qint64 launcherId, const QByteArray &nonce,
+                                   QHash<QByteArray, QByteArray> *settings);
+}
+
+}
+
+#endif // GAMMARAY_SHAREDPROBESETTINGS_H
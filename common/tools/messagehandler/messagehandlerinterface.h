@@ -42,9 +42,15 @@ class MessageHandlerInterface : public QObject
     explicit MessageHandlerInterface(QObject *parent = 0);
     virtual ~MessageHandlerInterface();
 
+  public slots:
+    /** Requests the backtrace of the message with MessageModelRole::Id @p id, which is delivered via backtraceAvailable(). */
+    virtual void requestBacktrace(qint64 id) = 0;
+
   signals:
     void fatalMessageReceived(const QString &app, const QString &message,
                               const QTime &time, const QStringList &backtrace);
+    /** The backtrace of the message with MessageModelRole::Id @p id, empty if there is none or it got removed meanwhile. */
+    void backtraceAvailable(qint64 id, const QStringList &backtrace);
 };
 
 }
@@ -40,7 +40,8 @@ namespace MessageModelRole {
         Type,
         File,
         Line,
-        Backtrace
+        Backtrace,
+        Id // stable sequence number of a message, unlike its row
     };
 }
 
@@ -32,11 +32,24 @@
 
 using namespace GammaRay;
 
-TransferImage::TransferImage()
+/// upper bound for the edge length of received images, anything larger is considered malformed input
+static const quint32 MaxImageExtent = 32767;
+
+static bool isValidImageFormat(quint32 format)
+{
+    return format > QImage::Format_Invalid && format < QImage::NImageFormats;
+}
+
+TransferImage::TransferImage() :
+    m_deltaFormat(QImage::Format_Invalid),
+    m_delta(false)
 {
 }
 
-TransferImage::TransferImage(const QImage& image) : m_image(image)
+TransferImage::TransferImage(const QImage& image) :
+    m_image(image),
+    m_deltaFormat(QImage::Format_Invalid),
+    m_delta(false)
 {
 }
 
@@ -48,12 +61,61 @@ const QImage &TransferImage::image() const
 void TransferImage::setImage(const QImage& image)
 {
     m_image = image;
+    m_dirtyTiles.clear();
+    m_tiles.clear();
+    m_delta = false;
+}
+
+void TransferImage::setDirtyTiles(const QVector<QRect>& tiles)
+{
+    m_dirtyTiles = tiles;
+    m_delta = true;
+}
+
+QVector<QRect> TransferImage::dirtyTiles() const
+{
+    return m_dirtyTiles;
+}
+
+bool TransferImage::isDelta() const
+{
+    return m_delta;
+}
+
+bool TransferImage::applyDelta(QImage& base) const
+{
+    Q_ASSERT(m_delta);
+    if (base.size() != m_deltaSize || base.format() != m_deltaFormat)
+        return false;
+
+    const int bytesPerPixel = base.depth() / 8;
+    for (int i = 0; i < m_tiles.size(); ++i) {
+        const QRect &rect = m_dirtyTiles.at(i);
+        const QImage &tile = m_tiles.at(i);
+        if (!base.rect().contains(rect) || tile.size() != rect.size())
+            return false;
+        for (int y = 0; y < rect.height(); ++y)
+            memcpy(base.scanLine(rect.y() + y) + rect.x() * bytesPerPixel, tile.constScanLine(y), rect.width() * bytesPerPixel);
+    }
+    return true;
+}
+
+qint64 TransferImage::encodedSize() const
+{
+    if (!m_delta)
+        return (qint64)m_image.bytesPerLine() * m_image.height();
+
+    qint64 size = 0;
+    const int bytesPerPixel = m_image.depth() / 8;
+    foreach (const QRect &rect, m_dirtyTiles)
+        size += (qint64)rect.width() * rect.height() * bytesPerPixel;
+    return size;
 }
 
 
 QDataStream& operator<<(QDataStream& stream, const GammaRay::TransferImage& image)
 {
-    static const TransferImage::Format format = TransferImage::RawFormat;
+    const TransferImage::Format format = image.isDelta() ? TransferImage::TileFormat : TransferImage::RawFormat;
 
     const QImage &img = image.image();
     stream << (quint32)(format);
@@ -69,6 +131,19 @@ QDataStream& operator<<(QDataStream& stream, const GammaRay::TransferImage& imag
             }
             break;
         }
+        case TransferImage::TileFormat:
+        {
+            Q_ASSERT(img.depth() % 8 == 0);
+            const int bytesPerPixel = img.depth() / 8;
+            const QVector<QRect> tiles = image.dirtyTiles();
+            stream << (quint32)img.format() << (quint32)img.width() << (quint32)img.height() << (quint32)tiles.size();
+            foreach (const QRect &rect, tiles) {
+                stream << (quint32)rect.x() << (quint32)rect.y() << (quint32)rect.width() << (quint32)rect.height();
+                for (int y = rect.top(); y <= rect.bottom(); ++y)
+                    stream.device()->write((const char*)img.constScanLine(y) + rect.x() * bytesPerPixel, rect.width() * bytesPerPixel);
+            }
+            break;
+        }
     }
 
     return stream;
@@ -92,14 +167,82 @@ QDataStream& operator>>(QDataStream& stream, TransferImage& image)
         {
             quint32 f, w, h;
             stream >> f >> w >> h;
+            if (!isValidImageFormat(f) || w > MaxImageExtent || h > MaxImageExtent) {
+                stream.setStatus(QDataStream::ReadCorruptData);
+                image.setImage(QImage());
+                break;
+            }
             QImage img(w, h, static_cast<QImage::Format>(f));
             for (int i = 0; i < img.height(); ++i) {
               const QByteArray buffer = stream.device()->read(img.bytesPerLine());
+              if (buffer.size() != img.bytesPerLine()) {
+                  stream.setStatus(QDataStream::ReadPastEnd);
+                  img = QImage();
+                  break;
+              }
               memcpy(img.scanLine(i), buffer.constData(), img.bytesPerLine());
             }
             image.setImage(img);
             break;
         }
+        case TransferImage::TileFormat:
+        {
+            quint32 f, w, h, count;
+            stream >> f >> w >> h >> count;
+            image.setImage(QImage());
+            // everything below comes from the wire, reject anything not fitting into the frame
+            const quint32 tileSize = TransferImage::TileSize;
+            const quint32 maxCount = ((w + tileSize - 1) / tileSize) * ((h + tileSize - 1) / tileSize);
+            if (stream.status() != QDataStream::Ok || !isValidImageFormat(f)
+                || w > MaxImageExtent || h > MaxImageExtent || count > maxCount) {
+                stream.setStatus(QDataStream::ReadCorruptData);
+                // applyDelta() fails on this, so the client asks for a key frame
+                image.m_deltaSize = QSize();
+                image.m_deltaFormat = QImage::Format_Invalid;
+                image.setDirtyTiles(QVector<QRect>());
+                break;
+            }
+            image.m_deltaFormat = static_cast<QImage::Format>(f);
+            image.m_deltaSize = QSize(w, h);
+            QVector<QRect> tiles;
+            tiles.reserve(count);
+            image.m_tiles.reserve(count);
+            for (quint32 j = 0; j < count; ++j) {
+                quint32 x, y, tw, th;
+                stream >> x >> y >> tw >> th;
+                if (stream.status() != QDataStream::Ok || tw == 0 || th == 0 || tw > tileSize || th > tileSize
+                    || x > w || tw > w - x || y > h || th > h - y) {
+                    stream.setStatus(QDataStream::ReadCorruptData);
+                    break;
+                }
+                QImage tile(tw, th, image.m_deltaFormat);
+                if (tile.isNull() || tile.depth() % 8 != 0) {
+                    stream.setStatus(QDataStream::ReadCorruptData);
+                    break;
+                }
+                const qint64 rowSize = tw * tile.depth() / 8;
+                for (int row = 0; row < tile.height(); ++row) {
+                    if (stream.device()->read((char*)tile.scanLine(row), rowSize) != rowSize) {
+                        stream.setStatus(QDataStream::ReadPastEnd);
+                        break;
+                    }
+                }
+                if (stream.status() != QDataStream::Ok)
+                    break;
+                tiles.push_back(QRect(x, y, tw, th));
+                image.m_tiles.push_back(tile);
+            }
+            if (stream.status() != QDataStream::Ok) {
+                // applyDelta() fails on this, so the client asks for a key frame
+                image.m_tiles.clear();
+                image.m_deltaSize = QSize();
+                image.m_deltaFormat = QImage::Format_Invalid;
+                image.setDirtyTiles(QVector<QRect>());
+                break;
+            }
+            image.setDirtyTiles(tiles);
+            break;
+        }
     }
 
     return stream;
@@ -31,11 +31,21 @@
 
 #include <QDataStream>
 #include <QImage>
+#include <QRect>
 #include <QVariant>
+#include <QVector>
+
+namespace GammaRay { class TransferImage; }
+
+QDataStream& operator>>(QDataStream &stream, GammaRay::TransferImage &image);
 
 namespace GammaRay {
 
-/** Wrapper class for a QImage to allow raw data transfer over a QDataStream, bypassing the usuale PNG encoding. */
+/** Wrapper class for a QImage to allow raw data transfer over a QDataStream, bypassing the usuale PNG encoding.
+ *
+ *  Optionally only a set of changed tiles is transferred, which the receiving side
+ *  then has to patch into the previously received image, see applyDelta().
+ */
 class TransferImage
 {
 public:
@@ -43,15 +53,47 @@ public:
     explicit TransferImage(const QImage &image);
 
     const QImage &image() const;
+    /// sets a new full image, discarding any delta information
     void setImage(const QImage &image);
 
+    /// edge length of the tiles used for delta encoding
+    enum { TileSize = 64 };
+
+    /**
+     * Only transfer the given tiles of image(), relative to the previously transferred image.
+     * An empty list is valid and means nothing changed.
+     */
+    void setDirtyTiles(const QVector<QRect> &tiles);
+    QVector<QRect> dirtyTiles() const;
+
+    /// returns @c true if this only contains the changed tiles relative to the previous image
+    bool isDelta() const;
+
+    /**
+     * Patches the tiles of a received delta image into @p base.
+     * Returns @c false if @p base does not match size and format of the encoded image.
+     */
+    bool applyDelta(QImage &base) const;
+
+    /// the amount of pixel data that is put on the wire for this image
+    qint64 encodedSize() const;
+
     enum Format {
       QImageFormat,
-      RawFormat
+      RawFormat,
+      TileFormat
     };
 
 private:
+    friend QDataStream& ::operator>>(QDataStream &stream, GammaRay::TransferImage &image);
+
     QImage m_image;
+    QVector<QRect> m_dirtyTiles;
+    // delta data as received from the remote side
+    QVector<QImage> m_tiles;
+    QSize m_deltaSize;
+    QImage::Format m_deltaFormat;
+    bool m_delta;
 };
 
 }
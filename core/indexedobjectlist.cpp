@@ -0,0 +1,157 @@
+/*
+  indexedobjectlist.cpp
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "indexedobjectlist.h"
+
+using namespace GammaRay;
+
+IndexedObjectList::IndexedObjectList()
+  : m_removedCount(0)
+{
+}
+
+int IndexedObjectList::size() const
+{
+  return m_objects.size() - m_removedCount;
+}
+
+QObject *IndexedObjectList::at(int row) const
+{
+  return m_objects.at(slotForRow(row));
+}
+
+int IndexedObjectList::indexOf(QObject *obj) const
+{
+  const QHash<QObject*, int>::const_iterator it = m_slots.constFind(obj);
+  if (it == m_slots.constEnd()) {
+    return -1;
+  }
+  return rowForSlot(it.value());
+}
+
+bool IndexedObjectList::contains(QObject *obj) const
+{
+  return m_slots.contains(obj);
+}
+
+void IndexedObjectList::append(QObject *obj)
+{
+  Q_ASSERT(obj);
+  Q_ASSERT(!m_slots.contains(obj));
+
+  const int slot = m_objects.size();
+  m_objects.push_back(obj);
+  m_slots.insert(obj, slot);
+  // the new tree node covers the slots (slot - lowbit, slot], sum up the nodes below it
+  const int node = slot + 1;
+  int removed = 0;
+  for (int i = node - 1; i > node - (node & -node); i -= i & -i) {
+    removed += m_removedTree.at(i - 1);
+  }
+  m_removedTree.push_back(removed);
+  Q_ASSERT(slotForRow(size() - 1) == slot);
+}
+
+void IndexedObjectList::remove(QObject *obj)
+{
+  QHash<QObject*, int>::iterator it = m_slots.find(obj);
+  Q_ASSERT(it != m_slots.end());
+  const int slot = it.value();
+  Q_ASSERT(m_objects.at(slot) == obj);
+
+  m_slots.erase(it);
+  if (slot == m_objects.size() - 1) {
+    // no other tree node covers the last slot
+    m_objects.pop_back();
+    m_removedTree.pop_back();
+  } else {
+    m_objects[slot] = 0;
+    for (int i = slot + 1; i <= m_removedTree.size(); i += i & -i) {
+      ++m_removedTree[i - 1];
+    }
+    ++m_removedCount;
+  }
+
+  // rows do not change by this
+  if (m_removedCount > m_objects.size() / 2) {
+    compact();
+  }
+}
+
+int IndexedObjectList::rowForSlot(int slot) const
+{
+  int removedBefore = 0;
+  for (int i = slot; i > 0; i -= i & -i) {
+    removedBefore += m_removedTree.at(i - 1);
+  }
+  return slot - removedBefore;
+}
+
+int IndexedObjectList::slotForRow(int row) const
+{
+  if (!m_removedCount) {
+    return row;
+  }
+
+  // descend the tree to find the first slot that has row + 1 live slots up to and including it
+  const int size = m_objects.size();
+  int step = 1;
+  while (step * 2 <= size) {
+    step *= 2;
+  }
+  int pos = 0;
+  int remaining = row + 1;
+  for (; step > 0; step /= 2) {
+    if (pos + step > size) {
+      continue;
+    }
+    const int live = step - m_removedTree.at(pos + step - 1);
+    if (live < remaining) {
+      pos += step;
+      remaining -= live;
+    }
+  }
+  Q_ASSERT(pos < size && m_objects.at(pos));
+  return pos;
+}
+
+void IndexedObjectList::compact()
+{
+  int live = 0;
+  for (int slot = 0; slot < m_objects.size(); ++slot) {
+    QObject *obj = m_objects.at(slot);
+    if (!obj) {
+      continue;
+    }
+    m_objects[live] = obj;
+    m_slots[obj] = live;
+    ++live;
+  }
+  m_objects.resize(live);
+  m_removedTree.fill(0, live);
+  m_removedCount = 0;
+}
@@ -0,0 +1,75 @@
+/*
+  indexedobjectlist.h
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMMARAY_INDEXEDOBJECTLIST_H
+#define GAMMARAY_INDEXEDOBJECTLIST_H
+
+#include <QHash>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QObject;
+QT_END_NAMESPACE
+
+namespace GammaRay {
+
+/**
+ * List of objects in insertion order, with the row of each object looked up in O(log n),
+ * so removing arbitrary objects from long lists is cheap.
+ */
+class IndexedObjectList
+{
+  public:
+    IndexedObjectList();
+
+    int size() const;
+    QObject *at(int row) const;
+    /// Returns the row of @p obj, or -1 if it is not in the list.
+    int indexOf(QObject *obj) const;
+    bool contains(QObject *obj) const;
+
+    void append(QObject *obj);
+    /// Removes @p obj, rows of the following objects move up by one.
+    void remove(QObject *obj);
+
+  private:
+    int rowForSlot(int slot) const;
+    int slotForRow(int row) const;
+    void compact();
+
+    // objects in insertion order, removed ones are replaced by a null tombstone until the next compaction
+    QVector<QObject*> m_objects;
+    // slot in m_objects for each object
+    QHash<QObject*, int> m_slots;
+    // Fenwick tree counting the tombstones in m_objects, to map between rows and slots in O(log n)
+    QVector<int> m_removedTree;
+    int m_removedCount;
+};
+
+}
+
+#endif // GAMMARAY_INDEXEDOBJECTLIST_H
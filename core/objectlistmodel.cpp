@@ -32,7 +32,6 @@
 
 #include <QThread>
 
-#include <algorithm>
 #include <iostream>
 
 using namespace GammaRay;
@@ -50,7 +49,7 @@ ObjectListModel::ObjectListModel(Probe *probe)
 QVariant ObjectListModel::data(const QModelIndex &index, int role) const
 {
   QMutexLocker lock(Probe::objectLock());
-  if (index.row() >= 0 && index.row() < m_objects.size()) {
+  if (index.row() >= 0 && index.row() < rowCount()) {
     QObject *obj = m_objects.at(index.row());
     if (Probe::instance()->isValidObject(obj)) {
       return dataForObject(obj, index, role);
@@ -82,16 +81,12 @@ void ObjectListModel::objectAdded(QObject *obj)
   Q_ASSERT(QThread::currentThread() == thread());
   Q_ASSERT(obj);
   Q_ASSERT(Probe::instance()->isValidObject(obj));
+  Q_ASSERT(!m_objects.contains(obj));
 
-  QVector<QObject*>::iterator it = std::lower_bound(m_objects.begin(), m_objects.end(), obj);
-  Q_ASSERT(it == m_objects.end() || *it != obj);
-
-  const int row = std::distance(m_objects.begin(), it);
-  Q_ASSERT(row >= 0 && row <= m_objects.size());
-
+  // new objects are always appended, rows are not sorted in any way
+  const int row = rowCount();
   beginInsertRows(QModelIndex(), row, row);
-  m_objects.insert(it, obj);
-  Q_ASSERT(m_objects.at(row) == obj);
+  m_objects.append(obj);
   endInsertRows();
 }
 
@@ -99,18 +94,13 @@ void ObjectListModel::objectRemoved(QObject *obj)
 {
   Q_ASSERT(thread() == QThread::currentThread());
 
-  QVector<QObject*>::iterator it = std::lower_bound(m_objects.begin(), m_objects.end(), obj);
-  if (it == m_objects.end() || *it != obj) {
+  const int row = m_objects.indexOf(obj);
+  if (row < 0) {
     // not found
     return;
   }
 
-  const int row = std::distance(m_objects.begin(), it);
-  Q_ASSERT(row >= 0 && row < m_objects.size());
-  Q_ASSERT(m_objects.at(row) == obj);
-
   beginRemoveRows(QModelIndex(), row, row);
-  m_objects.erase(it);
+  m_objects.remove(obj);
   endRemoveRows();
 }
-
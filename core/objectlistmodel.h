@@ -30,10 +30,9 @@
 #define GAMMARAY_OBJECTLISTMODEL_H
 
 #include "objectmodelbase.h"
+#include "indexedobjectlist.h"
 
 #include <QMutex>
-#include <QVector>
-#include <QSet>
 
 namespace GammaRay {
 
@@ -64,10 +63,7 @@ class ObjectListModel : public ObjectModelBase<QAbstractTableModel>
     void objectRemoved(QObject *obj);
 
   private:
-    void removeObject(QObject *obj);
-
-    // sorted vector for stable iterators/indexes, esp. for the model methods
-    QVector<QObject*> m_objects;
+    IndexedObjectList m_objects;
 };
 
 }
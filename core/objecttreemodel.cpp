@@ -45,7 +45,8 @@ using namespace std;
 using namespace GammaRay;
 
 ObjectTreeModel::ObjectTreeModel(Probe *probe)
-  : ObjectModelBase< QAbstractItemModel >(probe)
+  : ObjectModelBase< QAbstractItemModel >(probe),
+    m_bulkInsert(false)
 {
   connect(probe, SIGNAL(objectCreated(QObject*)),
           this, SLOT(objectAdded(QObject*)));
@@ -60,6 +61,32 @@ static inline QObject *parentObject(QObject *obj)
   return  obj->parent();
 }
 
+void ObjectTreeModel::beginBulkInsert()
+{
+  Q_ASSERT(!m_bulkInsert);
+  beginResetModel();
+  m_bulkInsert = true;
+}
+
+void ObjectTreeModel::endBulkInsert()
+{
+  Q_ASSERT(m_bulkInsert);
+  for (QHash<QObject*, QVector<QObject*> >::iterator it = m_parentChildMap.begin(); it != m_parentChildMap.end(); ++it) {
+    std::sort(it.value().begin(), it.value().end());
+  }
+  m_bulkInsert = false;
+  endResetModel();
+}
+
+// during bulk insertion the children are unsorted, and nobody may look at the model anyway
+static void removeUnsorted(QVector<QObject*> &objects, QObject *obj)
+{
+  QVector<QObject*>::iterator it = std::find(objects.begin(), objects.end(), obj);
+  if (it != objects.end()) {
+    objects.erase(it);
+  }
+}
+
 void ObjectTreeModel::objectAdded(QObject *obj)
 {
   // see Probe::objectCreated, that promises a valid object in the main thread here
@@ -69,6 +96,19 @@ void ObjectTreeModel::objectAdded(QObject *obj)
   IF_DEBUG(cout << "tree obj added: " << hex << obj << " p: " << parentObject(obj) << endl;)
   Q_ASSERT(!obj->parent() || Probe::instance()->isValidObject(parentObject(obj)));
 
+  if (m_bulkInsert) {
+    if (m_childParentMap.contains(obj)) {
+      return;
+    }
+    QObject *parentObj = parentObject(obj);
+    if (parentObj && !m_childParentMap.contains(parentObj)) {
+      objectAdded(parentObj);
+    }
+    m_parentChildMap[parentObj].push_back(obj);
+    m_childParentMap.insert(obj, parentObj);
+    return;
+  }
+
   if (indexForObject(obj).isValid()) {
     IF_DEBUG(cout << "tree double obj added: " << hex << obj << endl;)
     return;
@@ -121,6 +161,12 @@ void ObjectTreeModel::objectRemoved(QObject *obj)
     return;
   }
 
+  if (m_bulkInsert) {
+    removeUnsorted(m_parentChildMap[m_childParentMap.take(obj)], obj);
+    m_parentChildMap.remove(obj);
+    return;
+  }
+
   QObject *parentObj = m_childParentMap[ obj ];
   const QModelIndex parentIndex = indexForObject(parentObj);
   //cppcheck-suppress nullPointerRedundantCheck
@@ -164,6 +210,16 @@ void ObjectTreeModel::objectReparented(QObject *obj)
     return;
   }
 
+  if (m_bulkInsert) {
+    QObject *&parentObj = m_childParentMap[obj];
+    if (parentObj != parentObject(obj)) {
+      removeUnsorted(m_parentChildMap[parentObj], obj);
+      parentObj = parentObject(obj);
+      m_parentChildMap[parentObj].push_back(obj);
+    }
+    return;
+  }
+
   QObject *oldParent = m_childParentMap.value(obj);
   const auto sourceParent = indexForObject(oldParent);
   //cppcheck-suppress nullPointerRedundantCheck
@@ -48,6 +48,14 @@ class ObjectTreeModel : public ObjectModelBase<QAbstractItemModel>
     QModelIndex parent(const QModelIndex &child) const Q_DECL_OVERRIDE;
     QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
 
+    /**
+     * Prepares for adding a large number of objects at once, e.g. when attaching to a running application.
+     * Objects added until endBulkInsert() are neither sorted nor announced individually,
+     * instead the model is reset once at the end.
+     */
+    void beginBulkInsert();
+    void endBulkInsert();
+
   private slots:
     void objectAdded(QObject *obj);
     void objectRemoved(QObject *obj);
@@ -59,6 +67,7 @@ class ObjectTreeModel : public ObjectModelBase<QAbstractItemModel>
   private:
     QHash<QObject*, QObject*> m_childParentMap;
     QHash<QObject*, QVector<QObject*> > m_parentChildMap;
+    bool m_bulkInsert;
 };
 
 }
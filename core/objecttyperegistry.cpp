@@ -0,0 +1,230 @@
+/*
+  objecttyperegistry.cpp
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "objecttyperegistry.h"
+
+#include "probe.h"
+#include "util.h"
+
+#include <QMutex>
+#include <QThread>
+
+#include <algorithm>
+
+using namespace GammaRay;
+
+ObjectTypeListModel::ObjectTypeListModel(const QVector<QByteArray> &classNames, QObject *parent)
+  : ObjectModelBase<QAbstractTableModel>(parent),
+    m_classNames(classNames)
+{
+}
+
+QVariant ObjectTypeListModel::data(const QModelIndex &index, int role) const
+{
+  QMutexLocker lock(Probe::objectLock());
+  if (index.row() >= 0 && index.row() < rowCount()) {
+    QObject *obj = m_objects.at(index.row());
+    if (Probe::instance()->isValidObject(obj)) {
+      return dataForObject(obj, index, role);
+    }
+  }
+  return QVariant();
+}
+
+int ObjectTypeListModel::columnCount(const QModelIndex &parent) const
+{
+  if (parent.isValid()) {
+    return 0;
+  }
+  return ObjectModelBase<QAbstractTableModel>::columnCount(parent);
+}
+
+int ObjectTypeListModel::rowCount(const QModelIndex &parent) const
+{
+  if (parent.isValid()) {
+    return 0;
+  }
+  return m_objects.size();
+}
+
+bool ObjectTypeListModel::acceptsClassName(const char *className) const
+{
+  for (QVector<QByteArray>::const_iterator it = m_classNames.constBegin(); it != m_classNames.constEnd(); ++it) {
+    if (*it == className) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ObjectTypeListModel::acceptsMetaObject(const QMetaObject *mo) const
+{
+  for (; mo; mo = mo->superClass()) {
+    if (acceptsClassName(mo->className())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ObjectTypeListModel::addObject(QObject *obj)
+{
+  beginInsertRows(QModelIndex(), m_objects.size(), m_objects.size());
+  m_objects.append(obj);
+  endInsertRows();
+}
+
+void ObjectTypeListModel::removeObject(QObject *obj)
+{
+  const int row = m_objects.indexOf(obj);
+  if (row < 0) {
+    return;
+  }
+  beginRemoveRows(QModelIndex(), row, row);
+  m_objects.remove(obj);
+  endRemoveRows();
+}
+
+ObjectTypeRegistry::ObjectTypeRegistry(Probe *probe)
+  : QObject(probe),
+    m_probe(probe)
+{
+  connect(probe, SIGNAL(objectCreated(QObject*)),
+          this, SLOT(objectAdded(QObject*)));
+  connect(probe, SIGNAL(objectDestroyed(QObject*)),
+          this, SLOT(objectRemoved(QObject*)));
+}
+
+ObjectTypeListModel *ObjectTypeRegistry::modelForTypes(QVector<QByteArray> classNames)
+{
+  Q_ASSERT(QThread::currentThread() == thread());
+
+  std::sort(classNames.begin(), classNames.end());
+  classNames.erase(std::unique(classNames.begin(), classNames.end()), classNames.end());
+  foreach (ObjectTypeListModel *model, m_models) {
+    if (model->m_classNames == classNames) {
+      return model;
+    }
+  }
+
+  ObjectTypeListModel *model = new ObjectTypeListModel(classNames, this);
+  m_models.push_back(model);
+  m_modelsForMetaObject.clear();
+
+  // nobody is looking at the new model yet, so populate it without signals
+  QMutexLocker lock(Probe::objectLock());
+  foreach (QObject *obj, m_probe->m_validObjects) {
+    if (m_probe->isObjectCreationQueued(obj)) {
+      continue; // not fully constructed yet, we'll get to it in objectAdded
+    }
+    if (modelsForObject(obj).contains(model)) {
+      model->m_objects.append(obj);
+      m_objectModels[obj].push_back(model);
+    }
+  }
+
+  return model;
+}
+
+QVector<ObjectTypeListModel*> ObjectTypeRegistry::modelsForObject(QObject *obj)
+{
+  const QMetaObject *staticMo = Util::firstStaticMetaObject(obj);
+  if (!staticMo) {
+    // we can't tell dynamic meta objects apart without private headers, so don't cache anything
+    QVector<ObjectTypeListModel*> models;
+    foreach (ObjectTypeListModel *model, m_models) {
+      if (model->acceptsMetaObject(obj->metaObject())) {
+        models.push_back(model);
+      }
+    }
+    return models;
+  }
+
+  // dynamic meta objects (eg. of QML types) can exist per instance, and their address
+  // can be reused for a different type, so only cache based on the static ones
+  QHash<const QMetaObject*, QVector<ObjectTypeListModel*> >::iterator it = m_modelsForMetaObject.find(staticMo);
+  if (it == m_modelsForMetaObject.end()) {
+    QVector<ObjectTypeListModel*> models;
+    foreach (ObjectTypeListModel *model, m_models) {
+      if (model->acceptsMetaObject(staticMo)) {
+        models.push_back(model);
+      }
+    }
+    it = m_modelsForMetaObject.insert(staticMo, models);
+  }
+
+  if (obj->metaObject() == staticMo) {
+    return it.value();
+  }
+
+  QVector<ObjectTypeListModel*> models = it.value();
+  for (const QMetaObject *mo = obj->metaObject(); mo != staticMo; mo = mo->superClass()) {
+    foreach (ObjectTypeListModel *model, m_models) {
+      if (!models.contains(model) && model->acceptsClassName(mo->className())) {
+        models.push_back(model);
+      }
+    }
+  }
+  return models;
+}
+
+void ObjectTypeRegistry::objectAdded(QObject *obj)
+{
+  // see Probe::objectCreated, that promises a valid object in the main thread
+  Q_ASSERT(QThread::currentThread() == thread());
+  Q_ASSERT(obj);
+
+  if (m_models.isEmpty()) {
+    return;
+  }
+
+  const QVector<ObjectTypeListModel*> models = modelsForObject(obj);
+  if (models.isEmpty()) {
+    return;
+  }
+
+  m_objectModels.insert(obj, models);
+  foreach (ObjectTypeListModel *model, models) {
+    model->addObject(obj);
+  }
+}
+
+void ObjectTypeRegistry::objectRemoved(QObject *obj)
+{
+  Q_ASSERT(thread() == QThread::currentThread());
+
+  QHash<QObject*, QVector<ObjectTypeListModel*> >::iterator it = m_objectModels.find(obj);
+  if (it == m_objectModels.end()) {
+    return;
+  }
+
+  const QVector<ObjectTypeListModel*> models = it.value();
+  m_objectModels.erase(it);
+  foreach (ObjectTypeListModel *model, models) {
+    model->removeObject(obj);
+  }
+}
@@ -0,0 +1,104 @@
+/*
+  objecttyperegistry.h
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMMARAY_OBJECTTYPEREGISTRY_H
+#define GAMMARAY_OBJECTTYPEREGISTRY_H
+
+#include "objectmodelbase.h"
+#include "indexedobjectlist.h"
+
+#include <QAbstractTableModel>
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+namespace GammaRay {
+
+class Probe;
+
+/**
+ * List of all objects inheriting one of a set of classes.
+ * Maintained by ObjectTypeRegistry, the same columns and roles as the object list model.
+ */
+class ObjectTypeListModel : public ObjectModelBase<QAbstractTableModel>
+{
+  Q_OBJECT
+  public:
+    explicit ObjectTypeListModel(const QVector<QByteArray> &classNames, QObject *parent);
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+
+  private:
+    friend class ObjectTypeRegistry;
+    bool acceptsClassName(const char *className) const;
+    bool acceptsMetaObject(const QMetaObject *mo) const;
+    void addObject(QObject *obj);
+    void removeObject(QObject *obj);
+
+    QVector<QByteArray> m_classNames;
+    IndexedObjectList m_objects;
+};
+
+/**
+ * Sorts the objects known to the probe into per-type lists, so that tools
+ * interested in a specific type don't need to filter the full object list.
+ * Which of the lists an object belongs to is computed once per QMetaObject,
+ * if private Qt headers are available to recognize dynamic meta objects.
+ */
+class ObjectTypeRegistry : public QObject
+{
+  Q_OBJECT
+  public:
+    explicit ObjectTypeRegistry(Probe *probe);
+
+    /**
+     * Returns the list of all objects inheriting one of @p classNames.
+     * Created and populated on first request, and shared by all callers
+     * asking for the same types.
+     */
+    ObjectTypeListModel *modelForTypes(QVector<QByteArray> classNames);
+
+  private slots:
+    void objectAdded(QObject *obj);
+    void objectRemoved(QObject *obj);
+
+  private:
+    QVector<ObjectTypeListModel*> modelsForObject(QObject *obj);
+
+    Probe *m_probe;
+    QVector<ObjectTypeListModel*> m_models;
+    // models interested in objects with the given (static) meta object
+    QHash<const QMetaObject*, QVector<ObjectTypeListModel*> > m_modelsForMetaObject;
+    // models containing an object, we can't look at the meta object anymore on destruction
+    QHash<QObject*, QVector<ObjectTypeListModel*> > m_objectModels;
+};
+
+}
+
+#endif // GAMMARAY_OBJECTTYPEREGISTRY_H
@@ -32,6 +32,7 @@
 
 #include "probe.h"
 #include "objectlistmodel.h"
+#include "objecttyperegistry.h"
 #include "objecttreemodel.h"
 #include "metaobjecttreemodel.h"
 #include "toolmodel.h"
@@ -62,11 +63,14 @@
 #include <QLibrary>
 #include <QMouseEvent>
 #include <QUrl>
+#include <QVarLengthArray>
 #include <QThread>
+#include <QThreadStorage>
 #include <QTimer>
 
 #ifdef HAVE_PRIVATE_QT_HEADERS
 #include <private/qobject_p.h>
+#include <private/qmetaobject_p.h>
 #else
 struct QSignalSpyCallbackSet
 {
@@ -102,7 +106,7 @@ namespace GammaRay {
 
 static void signal_begin_callback(QObject *caller, int method_index, void **argv)
 {
-  if (method_index == 0 || Probe::instance()->filterObject(caller))
+  if (method_index == 0 || !Probe::hasSignalCallbacksFor(method_index) || Probe::instance()->filterObject(caller))
     return;
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
@@ -112,12 +116,12 @@ static void signal_begin_callback(QObject *caller, int method_index, void **argv
     if (callbacks.signalBeginCallback) {
       callbacks.signalBeginCallback(caller, method_index, argv);
     }
-  });
+  }, caller->metaObject(), method_index);
 }
 
 static void signal_end_callback(QObject *caller, int method_index)
 {
-  if (method_index == 0)
+  if (method_index == 0 || !Probe::hasSignalCallbacksFor(method_index))
     return;
 
   QMutexLocker locker(Probe::objectLock());
@@ -131,24 +135,24 @@ static void signal_end_callback(QObject *caller, int method_index)
     if (callbacks.signalEndCallback) {
       callbacks.signalEndCallback(caller, method_index);
     }
-  });
+  }, caller->metaObject(), method_index);
 }
 
 static void slot_begin_callback(QObject *caller, int method_index, void **argv)
 {
-  if (method_index == 0 || Probe::instance()->filterObject(caller))
+  if (method_index == 0 || !Probe::hasSlotCallbacksFor(method_index) || Probe::instance()->filterObject(caller))
     return;
 
   Probe::executeSignalCallback([=](const SignalSpyCallbackSet &callbacks) {
     if (callbacks.slotBeginCallback) {
             callbacks.slotBeginCallback(caller, method_index, argv);
     }
-  });
+  }, caller->metaObject(), method_index);
 }
 
 static void slot_end_callback(QObject *caller, int method_index)
 {
-  if (method_index == 0)
+  if (method_index == 0 || !Probe::hasSlotCallbacksFor(method_index))
     return;
 
   QMutexLocker locker(Probe::objectLock());
@@ -159,7 +163,7 @@ static void slot_end_callback(QObject *caller, int method_index)
     if (callbacks.slotEndCallback) {
             callbacks.slotEndCallback(caller, method_index);
     }
-  });
+  }, caller->metaObject(), method_index);
 }
 
 static QItemSelectionModel *selectionModelFactory(QAbstractItemModel *model)
@@ -207,14 +211,77 @@ Q_GLOBAL_STATIC(Listener, s_listener)
 // locking it in objectAdded/Removed
 Q_GLOBAL_STATIC_WITH_ARGS(QMutex, s_lock, (QMutex::Recursive))
 
+namespace {
+/**
+ * Single producer/single consumer ring buffer for the objects created in one thread other
+ * than the probe's. Filled by that thread in objectAdded(), drained by the lock holder.
+ * One slot always stays empty to tell a full buffer from an empty one.
+ */
+struct PendingObjectBuffer
+{
+  enum { Capacity = 1024 };
+
+  PendingObjectBuffer() : head(0), tail(0), finished(0), next(0) {}
+
+  QObject *objects[Capacity];
+  QObject *parents[Capacity];
+  QAtomicInt head; // next slot to write, only changed by the producer
+  QAtomicInt tail; // next slot to read, only changed by the consumer
+  QAtomicInt finished; // the thread is gone, can be deleted once drained
+  PendingObjectBuffer *next;
+};
+
+struct PendingObjectBuffers
+{
+  PendingObjectBuffers() : first(0) {}
+  QMutex mutex;
+  PendingObjectBuffer *first;
+};
+
+/// Owned by the thread, marks the buffer for deletion when the thread exits
+struct PendingObjectBufferRef
+{
+  explicit PendingObjectBufferRef(PendingObjectBuffer *b) : buffer(b) {}
+  ~PendingObjectBufferRef()
+  {
+    buffer->finished.fetchAndStoreRelease(1);
+  }
+  PendingObjectBuffer *buffer;
+};
+}
+
+Q_GLOBAL_STATIC(PendingObjectBuffers, s_pendingObjectBuffers)
+Q_GLOBAL_STATIC(QThreadStorage<PendingObjectBufferRef*>, s_pendingObjectBufferRef)
+
+static inline int loadAcquire(QAtomicInt &value)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+  return value.loadAcquire();
+#else
+  return value.fetchAndAddAcquire(0);
+#endif
+}
+
+static inline int loadRelaxed(const QAtomicInt &value)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+  return value.load();
+#else
+  return value;
+#endif
+}
+
 Probe::Probe(QObject *parent):
   QObject(parent),
   m_objectListModel(new ObjectListModel(this)),
   m_objectTreeModel(new ObjectTreeModel(this)),
+  m_objectTypeRegistry(new ObjectTypeRegistry(this)),
   m_metaObjectTreeModel(new MetaObjectTreeModel(this)),
   m_toolModel(0),
   m_window(0),
-  m_queueTimer(new QTimer(this))
+  m_pendingObjectsScheduled(0),
+  m_queueTimer(new QTimer(this)),
+  m_signalSpyDispatchTable(0)
 {
   Q_ASSERT(thread() == qApp->thread());
   IF_DEBUG(cout << "attaching GammaRay probe" << endl;)
@@ -279,12 +346,19 @@ Probe::~Probe()
   ObjectBroker::clear();
   ProbeSettings::resetLauncherIdentifier();
 
+  takePendingObjects();
+  m_takenPendingObjects.clear();
+  m_takenPendingObjectIndexes.clear();
+
+  qDeleteAll(m_signalSpyDispatchTables);
+
   s_instance = QAtomicPointer<Probe>(0);
 }
 
 void Probe::setWindow(QObject *window)
 {
   m_window = window;
+  m_filterVerdicts.clear();
 }
 
 QObject *Probe::window() const
@@ -350,6 +424,9 @@ void Probe::createProbe(bool findExisting)
 
     s_instance = QAtomicPointer<Probe>(probe);
 
+    // there might be lots of objects to add now, don't update the object tree for each of them
+    probe->m_objectTreeModel->beginBulkInsert();
+
     // add objects to the probe that were tracked before its creation
     foreach (QObject *obj, s_listener()->addedBeforeProbeInstance) {
       objectAdded(obj);
@@ -360,6 +437,8 @@ void Probe::createProbe(bool findExisting)
     if (findExisting) {
       probe->findExistingObjects();
     }
+
+    probe->m_objectTreeModel->endBulkInsert();
   }
 
   // eventually initialize the rest
@@ -379,6 +458,10 @@ void Probe::startupHookReceived()
 void Probe::delayedInit()
 {
   QCoreApplication::instance()->installEventFilter(this);
+  {
+    // we might have missed reparenting before the event filter was in place
+    m_filterVerdicts.clear();
+  }
 
   QString appName = qApp->applicationName();
   if (appName.isEmpty() && !qApp->arguments().isEmpty()) {
@@ -451,8 +534,15 @@ bool Probe::filterObject(QObject *obj) const
     return false;
   }
 
+  // the verdicts are only used and changed by our thread, so looking them up needs no locking,
+  // and without reliable destruction tracking we would not notice when to drop them again
+  const bool useVerdicts = QThread::currentThread() == thread() && hasReliableObjectTracking();
+
+  // walk up until we find an ancestor with a known verdict, which then also applies to everything below it
+  QVarLengthArray<QObject*, 32> unknownAncestors;
   QSet<QObject *> visitedObjects;
   int iteration = 0;
+  bool filtered = false;
   QObject *o = obj;
   do {
     if (iteration > 100) {
@@ -469,11 +559,48 @@ bool Probe::filterObject(QObject *obj) const
     }
     ++iteration;
 
-    if (o == this || o == window())
-      return true;
+    if (useVerdicts) {
+      const QHash<QObject*, bool>::const_iterator it = m_filterVerdicts.constFind(o);
+      if (it != m_filterVerdicts.constEnd()) {
+        filtered = it.value();
+        break;
+      }
+    }
+    unknownAncestors.push_back(o);
+
+    if (o == this || o == window()) {
+      filtered = true;
+      break;
+    }
     o = o->parent();
   } while (o);
-  return false;
+
+  if (useVerdicts) {
+    for (int i = 0; i < unknownAncestors.size(); ++i) {
+      m_filterVerdicts.insert(unknownAncestors.at(i), filtered);
+    }
+  }
+  return filtered;
+}
+
+void Probe::invalidateFilterVerdicts(QObject *obj)
+{
+  if (QThread::currentThread() != thread()) {
+    return; // objects of other threads have no verdicts
+  }
+  // descendants only have a verdict if their ancestors have one, so this is O(1) for new objects
+  QVarLengthArray<QObject*, 32> objects;
+  objects.push_back(obj);
+  while (!objects.isEmpty()) {
+    QObject *o = objects.last();
+    objects.removeLast();
+    if (!m_filterVerdicts.remove(o)) {
+      continue;
+    }
+    foreach (QObject *child, o->children()) {
+      objects.push_back(child);
+    }
+  }
 }
 
 void Probe::registerModel(const QString &objectName, QAbstractItemModel *model)
@@ -493,6 +620,16 @@ QAbstractItemModel *Probe::objectTreeModel() const
   return m_objectTreeModel;
 }
 
+QAbstractItemModel *Probe::objectTypeModel(const QStringList &classNames)
+{
+  QVector<QByteArray> names;
+  names.reserve(classNames.size());
+  foreach (const QString &className, classNames) {
+    names.push_back(className.toLatin1());
+  }
+  return m_objectTypeRegistry->modelForTypes(names);
+}
+
 QAbstractItemModel *Probe::metaObjectModel() const
 {
   return m_metaObjectTreeModel;
@@ -511,7 +648,11 @@ QObject *Probe::probe() const
 bool Probe::isValidObject(QObject *obj) const
 {
   ///TODO: can we somehow assert(s_lock().isLocked()) ?!
-  return m_validObjects.contains(obj);
+  if (m_validObjects.contains(obj))
+    return true;
+  // objects created in other threads are alive before processPendingObjects() got to them
+  takePendingObjects();
+  return m_takenPendingObjectIndexes.contains(obj);
 }
 
 QMutex *Probe::objectLock()
@@ -534,17 +675,40 @@ QMutex *Probe::objectLock()
  * - post information to our thread
  * - emit objectCreated there right away if object still valid
  *
+ * Objects created in other threads are only recorded in a buffer of their thread, to not
+ * contend for the lock on every construction. They get processed as in case (3)
+ * by the next processQueuedObjectChanges() call. This relies on being notified
+ * about their destruction, so it is only done with reliable object tracking.
+ *
  * Pre-conditions: lock may or may not be held already, arbitrary thread
  */
 void Probe::objectAdded(QObject *obj, bool fromCtor)
 {
-  QMutexLocker lock(s_lock());
+  if (fromCtor && isInitialized() && instance()->thread() == QThread::currentThread()) {
+    // an object destroyed in another thread might have left a verdict at this address,
+    // the actual one is computed by filterObject() below
+    instance()->m_filterVerdicts.remove(obj);
+  }
 
   // attempt to ignore objects created by GammaRay itself, especially short-lived ones
   if (fromCtor && ProbeGuard::insideProbe() && obj->thread() == QThread::currentThread()) {
     return;
   }
 
+  if (fromCtor && isInitialized() && instance()->thread() != QThread::currentThread() && instance()->hasReliableObjectTracking()) {
+    // capture the parent here, it's only safe to look at obj in its own thread
+    if (instance()->pushPendingObject(obj, obj->parent()))
+      return;
+    // the buffer is full, add it right away instead
+  }
+
+  QMutexLocker lock(s_lock());
+  objectAddedLocked(obj, fromCtor);
+}
+
+// pre-condition: we have the lock, arbitrary thread
+void Probe::objectAddedLocked(QObject *obj, bool fromCtor)
+{
   if (!isInitialized()) {
     IF_DEBUG(cout
              << "objectAdded Before: "
@@ -575,7 +739,7 @@ void Probe::objectAdded(QObject *obj, bool fromCtor)
 
   // make sure we already know the parent
   if (obj->parent() && !instance()->m_validObjects.contains(obj->parent())) {
-    objectAdded(obj->parent(), fromCtor);
+    objectAddedLocked(obj->parent(), fromCtor);
   }
   Q_ASSERT(!obj->parent() || instance()->m_validObjects.contains(obj->parent()));
 
@@ -617,7 +781,18 @@ void Probe::processQueuedObjectChanges()
   // must be called from the main thread via timeout
   Q_ASSERT(QThread::currentThread() == thread());
 
-  foreach (const auto &change, m_queuedObjectChanges) {
+  processPendingObjects();
+
+  foreach (QObject *obj, m_staleFilterVerdicts) {
+    m_filterVerdicts.remove(obj);
+  }
+  m_staleFilterVerdicts.clear();
+
+  // not using foreach here, as the handlers might queue further changes
+  for (int i = 0; i < m_queuedObjectChanges.size(); ++i) {
+    const ObjectChange change = m_queuedObjectChanges.at(i);
+    if (!change.obj) // purged
+      continue;
     switch (change.type) {
       case ObjectChange::Create:
         objectFullyConstructed(change.obj);
@@ -631,6 +806,7 @@ void Probe::processQueuedObjectChanges()
   IF_DEBUG(cout << Q_FUNC_INFO << " done" << endl;)
 
   m_queuedObjectChanges.clear();
+  m_queuedObjectCreations.clear();
 
   foreach (QObject *obj, m_pendingReparents) {
     if (!isValidObject(obj))
@@ -720,6 +896,19 @@ void Probe::objectRemoved(QObject *obj)
     return;
   }
 
+  // obj might be half-destroyed already, so only drop it from the pending objects rather than processing those
+  instance()->forgetPendingObject(obj);
+
+  if (instance()->thread() == QThread::currentThread()) {
+    instance()->m_filterVerdicts.remove(obj);
+  } else {
+    // only our thread touches the verdicts, obj might have had one if it was moved away from us
+    if (instance()->m_staleFilterVerdicts.isEmpty()) {
+      instance()->notifyQueuedObjectChanges();
+    }
+    instance()->m_staleFilterVerdicts.push_back(obj);
+  }
+
   IF_DEBUG(cout << "object removed:" << hex << obj << " " << obj->parent() << endl;)
 
   bool success = instance()->m_validObjects.remove(obj);
@@ -751,6 +940,121 @@ void Probe::objectParentChanged()
   }
 }
 
+// pre-condition: arbitrary thread, lock may or may not be held
+bool Probe::pushPendingObject(QObject* obj, QObject *parent)
+{
+  QThreadStorage<PendingObjectBufferRef*> *storage = s_pendingObjectBufferRef();
+  PendingObjectBuffers *buffers = s_pendingObjectBuffers();
+  if (!storage || !buffers) // shutting down
+    return false;
+
+  if (!storage->hasLocalData()) {
+    // once per thread, afterwards recording an object does not allocate anything
+    PendingObjectBuffer *buffer = new PendingObjectBuffer;
+    {
+      QMutexLocker lock(&buffers->mutex);
+      buffer->next = buffers->first;
+      buffers->first = buffer;
+    }
+    storage->setLocalData(new PendingObjectBufferRef(buffer));
+  }
+
+  PendingObjectBuffer *buffer = storage->localData()->buffer;
+  const int head = loadRelaxed(buffer->head);
+  const int nextHead = (head + 1) % PendingObjectBuffer::Capacity;
+  if (nextHead == loadAcquire(buffer->tail))
+    return false;
+  buffer->objects[head] = obj;
+  buffer->parents[head] = parent;
+  buffer->head.fetchAndStoreRelease(nextHead);
+
+  if (m_pendingObjectsScheduled.testAndSetRelaxed(0, 1))
+    QMetaObject::invokeMethod(this, "processQueuedObjectChanges", Qt::QueuedConnection);
+  return true;
+}
+
+// pre-condition: we have the lock, arbitrary thread
+void Probe::takePendingObjects() const
+{
+  PendingObjectBuffers *buffers = s_pendingObjectBuffers();
+  if (!buffers)
+    return;
+
+  QMutexLocker lock(&buffers->mutex);
+  for (PendingObjectBuffer **link = &buffers->first; *link;) {
+    PendingObjectBuffer *buffer = *link;
+    // check this first, so a finished buffer is also completely drained
+    const bool finished = loadAcquire(buffer->finished);
+    const int head = loadAcquire(buffer->head);
+    int tail = loadRelaxed(buffer->tail);
+    // each buffer is in creation order, and parents live in the same thread as their children
+    while (tail != head) {
+      const PendingObject pending = { buffer->objects[tail], buffer->parents[tail] };
+      m_takenPendingObjectIndexes.insert(pending.obj, m_takenPendingObjects.size());
+      m_takenPendingObjects.push_back(pending);
+      tail = (tail + 1) % PendingObjectBuffer::Capacity;
+    }
+    buffer->tail.fetchAndStoreRelease(tail);
+
+    if (finished) {
+      *link = buffer->next;
+      delete buffer;
+    } else {
+      link = &buffer->next;
+    }
+  }
+}
+
+// pre-condition: we have the lock, arbitrary thread
+void Probe::forgetPendingObject(QObject* obj)
+{
+  takePendingObjects();
+  if (m_takenPendingObjects.isEmpty())
+    return;
+  // the children of obj might have been reparented before, so obj must not be looked at as their parent anymore
+  m_destroyedPendingParents.insert(obj);
+
+  const auto it = m_takenPendingObjectIndexes.find(obj);
+  if (it == m_takenPendingObjectIndexes.end())
+    return;
+  m_takenPendingObjects[it.value()].obj = 0;
+  m_takenPendingObjectIndexes.erase(it);
+}
+
+// pre-condition: we have the lock, our thread
+void Probe::processPendingObjects()
+{
+  Q_ASSERT(thread() == QThread::currentThread());
+
+  // objects pushed from now on need another processQueuedObjectChanges() call
+  m_pendingObjectsScheduled.fetchAndStoreRelaxed(0);
+  takePendingObjects();
+  for (int i = 0; i < m_takenPendingObjects.size(); ++i) {
+    // pending objects from other threads are never filtered (see filterObject()), and they might
+    // have been added via a child event already
+    const PendingObject pending = m_takenPendingObjects.at(i);
+    if (!pending.obj || m_validObjects.contains(pending.obj))
+      continue;
+    QObject *parent = pending.parent;
+    if (parent && !m_validObjects.contains(parent)) {
+      // obj has been reparented before its parent got destroyed, we just do not know where to
+      if (m_destroyedPendingParents.contains(parent))
+        continue;
+      // the parent was created before the probe or by GammaRay itself, and it is still alive,
+      // as any destruction after the creation of obj ends up in m_destroyedPendingParents
+      objectAddedLocked(parent, true);
+      if (!m_validObjects.contains(parent))
+        continue;
+    }
+    IF_DEBUG(cout << "objectAdded pending: " << hex << pending.obj << ", p: " << parent << endl;)
+    m_validObjects << pending.obj;
+    queueCreatedObject(pending.obj);
+  }
+  m_takenPendingObjects.clear();
+  m_takenPendingObjectIndexes.clear();
+  m_destroyedPendingParents.clear();
+}
+
 // pre-condition: we have the lock, arbitrary thread
 void Probe::queueCreatedObject(QObject* obj)
 {
@@ -759,6 +1063,7 @@ void Probe::queueCreatedObject(QObject* obj)
   ObjectChange c;
   c.obj = obj;
   c.type = ObjectChange::Create;
+  m_queuedObjectCreations.insert(obj, m_queuedObjectChanges.size());
   m_queuedObjectChanges.push_back(c);
   notifyQueuedObjectChanges();
 }
@@ -776,20 +1081,17 @@ void Probe::queueDestroyedObject(QObject* obj)
 // pre-condition: we have the lock, arbitrary thread
 bool Probe::isObjectCreationQueued(QObject* obj) const
 {
-  return std::find_if(m_queuedObjectChanges.begin(), m_queuedObjectChanges.end(), [obj](const ObjectChange &c) {
-      return c.obj == obj && c.type == Probe::ObjectChange::Create;
-    }) != m_queuedObjectChanges.end();
+  return m_queuedObjectCreations.contains(obj);
 }
 
 // pre-condition: we have the lock, arbitrary thread
 void Probe::purgeChangesForObject(QObject* obj)
 {
-  for (int i = 0; i < m_queuedObjectChanges.size(); ++i) {
-    if (m_queuedObjectChanges.at(i).obj == obj && m_queuedObjectChanges.at(i).type == ObjectChange::Create) {
-      m_queuedObjectChanges.remove(i);
-      return;
-    }
-  }
+  const auto it = m_queuedObjectCreations.find(obj);
+  if (it == m_queuedObjectCreations.end())
+    return;
+  m_queuedObjectChanges[it.value()].obj = 0;
+  m_queuedObjectCreations.erase(it);
 }
 
 // pre-condition: we have the lock, arbitrary thread
@@ -814,6 +1116,20 @@ void Probe::notifyQueuedObjectChanges()
 
 bool Probe::eventFilter(QObject *receiver, QEvent *event)
 {
+  // needed even for our own objects, they might be moved in or out of our window
+  // the new verdict is stored right away, rather than on the signal/slot hot path, except for
+  // removed children, which might be in destruction already
+  if (event->type() == QEvent::ChildAdded) {
+    QObject *child = static_cast<QChildEvent*>(event)->child();
+    invalidateFilterVerdicts(child);
+    filterObject(child);
+  } else if (event->type() == QEvent::ChildRemoved) {
+    invalidateFilterVerdicts(static_cast<QChildEvent*>(event)->child());
+  } else if (event->type() == QEvent::ParentChange) {
+    invalidateFilterVerdicts(receiver);
+    filterObject(receiver);
+  }
+
   if (ProbeGuard::insideProbe() && receiver->thread() == QThread::currentThread()) {
     return QObject::eventFilter(receiver, event);
   }
@@ -963,30 +1279,133 @@ void Probe::selectObject(void *object, const QString &typeName)
                                QItemSelectionModel::Current);
 }
 
+/** Lookup tables for deciding quickly whether any of the callbacks is interested in a signal or slot. */
+struct Probe::SignalSpyDispatchTable
+{
+  SignalSpyDispatchTable() : allSignals(false), allSlots(false) {}
+
+  static bool contains(const QVector<bool> &indexes, int index)
+  {
+    return index >= 0 && index < indexes.size() && indexes.at(index);
+  }
+
+  static void insert(QVector<bool> &indexes, int index)
+  {
+    if (index >= indexes.size())
+      indexes.resize(index + 1);
+    indexes[index] = true;
+  }
+
+  QVector<SignalSpyCallbackSet> callbacks;
+  QVector<bool> signalIndexes; // in the index space the signal callbacks get from Qt
+  QVector<bool> slotIndexes;
+  bool allSignals;
+  bool allSlots;
+};
+
+// the index signal spy callbacks get for @p method, or -1 if that can't be determined
+static int spyCallbackSignalIndex(const QMetaMethod &method)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#ifdef HAVE_PRIVATE_QT_HEADERS
+  return QMetaObjectPrivate::signalIndex(method);
+#else
+  Q_UNUSED(method);
+  return -1;
+#endif
+#else
+  return method.methodIndex();
+#endif
+}
+
 void Probe::registerSignalSpyCallbackSet(const SignalSpyCallbackSet &callbacks)
 {
   if (callbacks.isNull())
     return;
+
+  // registering the same callbacks again updates their method filters
+  for (QVector<SignalSpyCallbackSet>::iterator it = m_signalSpyCallbacks.begin(); it != m_signalSpyCallbacks.end(); ++it) {
+    if (it->signalBeginCallback == callbacks.signalBeginCallback && it->signalEndCallback == callbacks.signalEndCallback
+        && it->slotBeginCallback == callbacks.slotBeginCallback && it->slotEndCallback == callbacks.slotEndCallback) {
+      *it = callbacks;
+      setupSignalSpyCallbacks();
+      return;
+    }
+  }
+
   m_signalSpyCallbacks.push_back(callbacks);
   setupSignalSpyCallbacks();
 }
 
 void Probe::setupSignalSpyCallbacks()
 {
+  // compile a new table rather than modifying the current one, which might be in use in other threads right now
+  SignalSpyDispatchTable *table = new SignalSpyDispatchTable;
+  table->callbacks = m_signalSpyCallbacks;
   QSignalSpyCallbackSet cbs = { 0, 0, 0, 0 };
   foreach (const auto &it, m_signalSpyCallbacks) {
     if (it.signalBeginCallback) cbs.signal_begin_callback = signal_begin_callback;
     if (it.signalEndCallback) cbs.signal_end_callback = signal_end_callback;
     if (it.slotBeginCallback) cbs.slot_begin_callback = slot_begin_callback;
     if (it.slotEndCallback) cbs.slot_end_callback = slot_end_callback;
+
+    const bool wantsSignals = it.signalBeginCallback || it.signalEndCallback;
+    const bool wantsSlots = it.slotBeginCallback || it.slotEndCallback;
+    if (it.methodFilters.isEmpty()) {
+      table->allSignals |= wantsSignals;
+      table->allSlots |= wantsSlots;
+      continue;
+    }
+    foreach (const SignalSpyCallbackSet::MethodFilter &filter, it.methodFilters) {
+      const QMetaMethod method = filter.metaObject->method(filter.methodIndex);
+      if (method.methodType() == QMetaMethod::Signal) {
+        if (!wantsSignals)
+          continue;
+        const int signalIndex = spyCallbackSignalIndex(method);
+        if (signalIndex < 0)
+          table->allSignals = true;
+        else
+          SignalSpyDispatchTable::insert(table->signalIndexes, signalIndex);
+      } else if (wantsSlots) {
+        SignalSpyDispatchTable::insert(table->slotIndexes, filter.methodIndex);
+      }
+    }
   }
+
+  m_signalSpyDispatchTables.push_back(table);
+  m_signalSpyDispatchTable.fetchAndStoreRelease(table);
   qt_register_signal_spy_callbacks(cbs);
 }
 
+const Probe::SignalSpyDispatchTable *Probe::signalSpyDispatchTable()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+  return instance()->m_signalSpyDispatchTable.loadAcquire();
+#else
+  return instance()->m_signalSpyDispatchTable.fetchAndAddAcquire(0);
+#endif
+}
+
+bool Probe::hasSignalCallbacksFor(int signalIndex)
+{
+  const SignalSpyDispatchTable *table = signalSpyDispatchTable();
+  return table && (table->allSignals || SignalSpyDispatchTable::contains(table->signalIndexes, signalIndex));
+}
+
+bool Probe::hasSlotCallbacksFor(int methodIndex)
+{
+  const SignalSpyDispatchTable *table = signalSpyDispatchTable();
+  return table && (table->allSlots || SignalSpyDispatchTable::contains(table->slotIndexes, methodIndex));
+}
+
 template <typename Func>
-void Probe::executeSignalCallback(const Func &func)
+void Probe::executeSignalCallback(const Func &func, const QMetaObject *metaObject, int methodIndex)
 {
-  std::for_each(instance()->m_signalSpyCallbacks.constBegin(),
-                instance()->m_signalSpyCallbacks.constEnd(),
-                func);
+  const SignalSpyDispatchTable *table = signalSpyDispatchTable();
+  if (!table)
+    return;
+  for (QVector<SignalSpyCallbackSet>::const_iterator it = table->callbacks.constBegin(); it != table->callbacks.constEnd(); ++it) {
+    if (it->acceptsMethod(metaObject, methodIndex))
+      func(*it);
+  }
 }
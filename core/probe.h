@@ -34,7 +34,9 @@
 #include "signalspycallbackset.h"
 
 #include <QObject>
+#include <QHash>
 #include <QList>
+#include <QMutex>
 #include <QSet>
 #include <QVector>
 
@@ -42,7 +44,6 @@ class QItemSelectionModel;
 class QThread;
 class QPoint;
 class QTimer;
-class QMutex;
 
 namespace GammaRay {
 
@@ -50,6 +51,7 @@ class ProbeCreator;
 class MetaObjectTreeModel;
 class ObjectListModel;
 class ObjectTreeModel;
+class ObjectTypeRegistry;
 class ToolModel;
 class MainWindow;
 class BenchSuite;
@@ -75,6 +77,7 @@ class GAMMARAY_CORE_EXPORT Probe : public QObject, public ProbeInterface
 
     QAbstractItemModel *objectListModel() const Q_DECL_OVERRIDE;
     QAbstractItemModel *objectTreeModel() const Q_DECL_OVERRIDE;
+    QAbstractItemModel *objectTypeModel(const QStringList &classNames) Q_DECL_OVERRIDE;
     QAbstractItemModel *metaObjectModel() const;
     ToolModel *toolModel() const;
     void registerModel(const QString& objectName, QAbstractItemModel* model) Q_DECL_OVERRIDE;
@@ -107,7 +110,11 @@ class GAMMARAY_CORE_EXPORT Probe : public QObject, public ProbeInterface
 
     /// internal
     static void startupHookReceived();
-    template <typename Func>  static void executeSignalCallback(const Func &func);
+    template <typename Func>  static void executeSignalCallback(const Func &func, const QMetaObject *metaObject, int methodIndex);
+    /// internal, cheap check whether any signal spy callback might want to see @p signalIndex
+    static bool hasSignalCallbacksFor(int signalIndex);
+    /// internal, cheap check whether any slot spy callback might want to see @p methodIndex
+    static bool hasSlotCallbacksFor(int methodIndex);
 
   signals:
     /**
@@ -162,6 +169,7 @@ class GAMMARAY_CORE_EXPORT Probe : public QObject, public ProbeInterface
   private:
     friend class ProbeCreator;
     friend class BenchSuite;
+    friend class ObjectTypeRegistry;
 
     /* Returns @c true if we have working hooks in QtCore, that is we are notified reliably
      * about every QObject creation/destruction.
@@ -170,6 +178,19 @@ class GAMMARAY_CORE_EXPORT Probe : public QObject, public ProbeInterface
     bool hasReliableObjectTracking() const;
 
     void objectFullyConstructed(QObject *obj);
+    /** The part of objectAdded() that needs the lock. */
+    static void objectAddedLocked(QObject *obj, bool fromCtor);
+
+    /** Records @p obj with its initial @p parent in the buffer of the current thread, without locking.
+     *  Returns @c false if that is full, @p obj needs to be added right away then.
+     */
+    bool pushPendingObject(QObject *obj, QObject *parent);
+    /** Moves the objects pushed by pushPendingObject() into m_takenPendingObjects. */
+    void takePendingObjects() const;
+    /** Drops @p obj from the objects not processed yet, as it is being destroyed. */
+    void forgetPendingObject(QObject *obj);
+    /** Moves the objects pushed by pushPendingObject() into our regular tracking, our thread only. */
+    void processPendingObjects();
 
     void queueCreatedObject(QObject *obj);
     void queueDestroyedObject(QObject *obj);
@@ -179,6 +200,9 @@ class GAMMARAY_CORE_EXPORT Probe : public QObject, public ProbeInterface
 
     void findExistingObjects();
 
+    /** Drops the cached filterObject() results for @p obj and its descendants, e.g. as it got a new parent. */
+    void invalidateFilterVerdicts(QObject *obj);
+
     /** Check if we are capable of showing widgets. */
     static bool canShowWidgets();
     void showInProcessUi();
@@ -193,12 +217,19 @@ class GAMMARAY_CORE_EXPORT Probe : public QObject, public ProbeInterface
 
     ObjectListModel *m_objectListModel;
     ObjectTreeModel *m_objectTreeModel;
+    ObjectTypeRegistry *m_objectTypeRegistry;
     MetaObjectTreeModel *m_metaObjectTreeModel;
     ToolModel *m_toolModel;
     QItemSelectionModel *m_toolSelectionModel;
     QObject *m_window;
     QSet<QObject*> m_validObjects;
 
+    // filterObject() results, inherited by children from their parents and dropped on reparenting,
+    // only accessed from our thread
+    mutable QHash<QObject*, bool> m_filterVerdicts;
+    // objects destroyed in other threads, to be dropped from m_filterVerdicts by our thread
+    QVector<QObject*> m_staleFilterVerdicts;
+
     // all delayed object changes need to go through a single queue, as the order is crucial
     struct ObjectChange {
       QObject *obj;
@@ -208,12 +239,33 @@ class GAMMARAY_CORE_EXPORT Probe : public QObject, public ProbeInterface
       } type;
     };
     QVector<ObjectChange> m_queuedObjectChanges;
+    // index of the Create entry in m_queuedObjectChanges, entries of purged objects have a null obj
+    QHash<QObject*, int> m_queuedObjectCreations;
+
+    // objects created in other threads, taken from the per-thread buffers but not processed yet
+    struct PendingObject {
+      QObject *obj;
+      QObject *parent;
+    };
+    // set while a processQueuedObjectChanges() call for pushed objects is on its way
+    QAtomicInt m_pendingObjectsScheduled;
+    // in creation order per thread, entries of destroyed objects have a null obj
+    mutable QVector<PendingObject> m_takenPendingObjects;
+    // index of the last entry of an object in m_takenPendingObjects
+    mutable QHash<QObject*, int> m_takenPendingObjectIndexes;
+    // objects destroyed while m_takenPendingObjects was not empty
+    QSet<QObject*> m_destroyedPendingParents;
 
     QList<QObject*> m_pendingReparents;
     QTimer *m_queueTimer;
     QVector<QObject*> m_globalEventFilters;
     QVector<SignalSpyCallbackSet> m_signalSpyCallbacks;
     SignalSpyCallbackSet m_previousSignalSpyCallbackSet;
+    // m_signalSpyCallbacks compiled for lookups from any thread, outdated ones are kept until we are destroyed
+    struct SignalSpyDispatchTable;
+    static const SignalSpyDispatchTable *signalSpyDispatchTable();
+    QAtomicPointer<SignalSpyDispatchTable> m_signalSpyDispatchTable;
+    QVector<SignalSpyDispatchTable*> m_signalSpyDispatchTables;
 };
 
 }
@@ -43,6 +43,7 @@
 class QObject;
 class QAbstractItemModel;
 class QString;
+class QStringList;
 
 namespace GammaRay {
 
@@ -74,6 +75,17 @@ class ProbeInterface
      */
     virtual QAbstractItemModel *objectTreeModel() const = 0;
 
+    /**
+     * Returns a model containing all objects that inherit one of @p classNames (see QObject::inherits()),
+     * with the same columns and roles as objectListModel().
+     * Prefer this over filtering objectListModel() for a specific type, that doesn't scale
+     * with the number of objects in the target.
+     * @return a pointer to a QAbstractItemModel instance, shared by all callers asking for the same types.
+     *
+     * @since 2.5
+     */
+    virtual QAbstractItemModel *objectTypeModel(const QStringList &classNames) = 0;
+
     /**
      * Determines if the specified QObject belongs to the GammaRay Probe or Window.
      *
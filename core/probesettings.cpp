@@ -31,6 +31,7 @@
 
 #include "common/message.h"
 #include "common/paths.h"
+#include "common/sharedprobesettings.h"
 
 #include <QCoreApplication>
 #include <QDebug>
@@ -63,6 +64,8 @@ public:
     Q_INVOKABLE void sendServerAddress(const QUrl &address);
 
     void waitForSettingsReceived();
+    /** Settings are known already, only connect to the launcher to report the server address. */
+    void connectToLauncher();
 
 private slots:
     void readyRead();
@@ -73,11 +76,25 @@ private:
     QLocalSocket *m_socket;
     QWaitCondition m_waitCondition;
     QMutex m_mutex;
+    bool m_settingsKnown;
 };
 
+static void setRootPathFromSettings()
+{
+    const QString rootPath = ProbeSettings::value(QStringLiteral("RootPath")).toString();
+    if (!rootPath.isEmpty())
+        Paths::setRootPath(rootPath);
+    else {
+        const QString probePath = ProbeSettings::value(QStringLiteral("ProbePath")).toString();
+        if (!probePath.isEmpty())
+            Paths::setRootPath(probePath + QDir::separator() + GAMMARAY_INVERSE_PROBE_DIR);
+    }
+}
+
 ProbeSettingsReceiver::ProbeSettingsReceiver(QObject* parent):
     QObject(parent),
-    m_socket(Q_NULLPTR)
+    m_socket(Q_NULLPTR),
+    m_settingsKnown(false)
 {
 }
 
@@ -92,7 +109,8 @@ void ProbeSettingsReceiver::run()
     connect(m_socket, SIGNAL(readyRead()), this, SLOT(readyRead()));
     m_socket->connectToServer(QStringLiteral("gammaray-") + QString::number(ProbeSettings::launcherIdentifier()));
     if (!m_socket->waitForConnected()) {
-        qWarning() << "Failed to connect to launcher, can't receive probe settings!" << m_socket->errorString();
+        if (!m_settingsKnown)
+            qWarning() << "Failed to connect to launcher, can't receive probe settings!" << m_socket->errorString();
         settingsReceivedFallback();
     }
 }
@@ -105,6 +123,12 @@ void ProbeSettingsReceiver::waitForSettingsReceived()
     m_mutex.unlock();
 }
 
+void ProbeSettingsReceiver::connectToLauncher()
+{
+    m_settingsKnown = true;
+    QMetaObject::invokeMethod(this, "run", Qt::QueuedConnection);
+}
+
 void ProbeSettingsReceiver::readyRead()
 {
     while (Message::canReadMessage(m_socket)) {
@@ -124,16 +148,12 @@ void ProbeSettingsReceiver::readyRead()
             }
             case Protocol::ProbeSettings:
             {
+                // the probe is running already, changing the settings now would race with it
+                if (m_settingsKnown)
+                    return;
                 msg.payload() >> s_probeSettings()->settings;
                 //qDebug() << Q_FUNC_INFO << s_probeSettings()->settings;
-                const QString rootPath = ProbeSettings::value(QStringLiteral("RootPath")).toString();
-                if (!rootPath.isEmpty())
-                    Paths::setRootPath(rootPath);
-                else {
-                    const QString probePath = ProbeSettings::value(QStringLiteral("ProbePath")).toString();
-                    if (!probePath.isEmpty())
-                        Paths::setRootPath(probePath + QDir::separator() + GAMMARAY_INVERSE_PROBE_DIR);
-                }
+                setRootPathFromSettings();
 
                 m_waitCondition.wakeAll();
                 return;
@@ -146,16 +166,16 @@ void ProbeSettingsReceiver::readyRead()
 
 void ProbeSettingsReceiver::sendServerAddress(const QUrl& address)
 {
-    if (!m_socket || m_socket->state() != QLocalSocket::ConnectedState)
-        return;
-
-    Message msg(Protocol::LauncherAddress, Protocol::ServerAddress);
-    msg.payload() << address;
-    msg.write(m_socket);
+    if (m_socket && m_socket->state() == QLocalSocket::ConnectedState) {
+        Message msg(Protocol::LauncherAddress, Protocol::ServerAddress);
+        msg.payload() << address;
+        msg.write(m_socket);
 
-    m_socket->waitForBytesWritten();
-    m_socket->close();
+        m_socket->waitForBytesWritten();
+        m_socket->close();
+    }
 
+    // nobody to report to otherwise, don't keep the thread around for that
     deleteLater();
     s_probeSettings()->receiver = Q_NULLPTR;
     thread()->quit();
@@ -163,15 +183,11 @@ void ProbeSettingsReceiver::sendServerAddress(const QUrl& address)
 
 void ProbeSettingsReceiver::settingsReceivedFallback()
 {
+    if (m_settingsKnown)
+        return;
+
     // see if we got fallback data via environment variables
-    const QString rootPath = ProbeSettings::value(QStringLiteral("RootPath")).toString();
-    if (!rootPath.isEmpty())
-        Paths::setRootPath(rootPath);
-    else {
-        const QString probePath = ProbeSettings::value(QStringLiteral("ProbePath")).toString();
-        if (!probePath.isEmpty())
-            Paths::setRootPath(probePath + QDir::separator() + GAMMARAY_INVERSE_PROBE_DIR);
-    }
+    setRootPathFromSettings();
 
     m_waitCondition.wakeAll();
 }
@@ -206,6 +222,14 @@ void ProbeSettings::receiveSettings()
     auto receiver = new ProbeSettingsReceiver;
     s_probeSettings()->receiver = receiver;
     receiver->moveToThread(t);
+
+    // the launcher usually provides the settings via shared memory as well, in which case
+    // the socket is only needed for reporting the server address back later on
+    if (SharedProbeSettings::read(launcherIdentifier(), qgetenv("GAMMARAY_SETTINGS_NONCE"), &s_probeSettings()->settings)) {
+        setRootPathFromSettings();
+        receiver->connectToLauncher();
+        return;
+    }
     receiver->waitForSettingsReceived();
 }
 
@@ -223,6 +247,7 @@ void ProbeSettings::resetLauncherIdentifier()
   // if we were launch by GammaRay, and we later try to re-attach, we need to make sure
   // to not end up with an outdated launcher id
   qputenv("GAMMARAY_LAUNCHER_ID", "");
+  qputenv("GAMMARAY_SETTINGS_NONCE", "");
 }
 
 void ProbeSettings::sendServerAddress(const QUrl& addr)
@@ -43,7 +43,8 @@ namespace ProbeSettings
   GAMMARAY_CORE_EXPORT QVariant value(const QString &key, const QVariant &defaultValue = QString());
 
   /** Call if using runtime attaching to obtain settings provided via shared memory.
-   *  This method blocks until communication with the launcher is complete.
+   *  If the launcher did not provide the settings via shared memory, this method blocks
+   *  until communication with the launcher is complete.
    */
   void receiveSettings();
 
@@ -39,6 +39,7 @@
 #include <QDebug>
 #include <QBuffer>
 #include <QIcon>
+#include <QTimer>
 
 #include <iostream>
 
@@ -46,15 +47,25 @@ using namespace GammaRay;
 using namespace std;
 
 void (*RemoteModelServer::s_registerServerCallback)() = 0;
+QHash<int, bool> RemoteModelServer::s_serializableTypes;
+
+static bool rangesTouch(int first1, int last1, int first2, int last2)
+{
+  return first1 <= last2 + 1 && first2 <= last1 + 1;
+}
 
 RemoteModelServer::RemoteModelServer(const QString &objectName, QObject *parent) :
   QObject(parent),
   m_model(0),
+  m_pendingChangesTimer(new QTimer(this)),
   m_dummyBuffer(new QBuffer(&m_dummyData, this)),
   m_monitored(false)
 {
   setObjectName(objectName);
   m_dummyBuffer->open(QIODevice::WriteOnly);
+  m_pendingChangesTimer->setInterval(0);
+  m_pendingChangesTimer->setSingleShot(true);
+  connect(m_pendingChangesTimer, SIGNAL(timeout()), this, SLOT(flushChanges()));
   registerServer();
 }
 
@@ -112,6 +123,7 @@ void RemoteModelServer::disconnectModel()
 {
   Q_ASSERT(m_model);
   Model::unused(m_model);
+  m_pendingChanges.clear();
 
   disconnect(m_model, SIGNAL(headerDataChanged(Qt::Orientation,int,int)), this, SLOT(headerDataChanged(Qt::Orientation,int,int)));
   disconnect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(rowsInserted(QModelIndex,int,int)));
@@ -138,6 +150,9 @@ void RemoteModelServer::newRequest(const GammaRay::Message &msg)
   if (!m_model && msg.type() != Protocol::ModelSyncBarrier)
     return;
 
+  // replies refer to the current model state, so the client needs to see all changes first
+  flushChanges();
+
   ProbeGuard g;
   switch (msg.type()) {
     case Protocol::ModelRowColumnCountRequest:
@@ -266,21 +281,39 @@ QMap<int, QVariant> RemoteModelServer::filterItemData(const QMap< int, QVariant
 
 bool RemoteModelServer::canSerialize(const QVariant& value) const
 {
-  // recurse into containers
+  // whether a type has stream operators doesn't depend on the content, so that is cached per type,
+  // including negative results, failing QMetaType::save() warns every time
+  QHash<int, bool>::const_iterator it = s_serializableTypes.constFind(value.userType());
+  if (it == s_serializableTypes.constEnd()) {
+    // ugly, but there doesn't seem to be a better way atm to find out without trying
+    m_dummyBuffer->seek(0);
+    QDataStream stream(m_dummyBuffer);
+    const bool hasStreamOperators = QMetaType::save(stream, value.userType(), value.constData());
+    s_serializableTypes.insert(value.userType(), hasStreamOperators);
+    // a failure in the content only rules out this value, not the type
+    if (!hasStreamOperators || stream.status() != QDataStream::Ok)
+      return false;
+  } else if (!it.value()) {
+    return false;
+  }
+
+  // the content of containers can still fail, e.g. QVariants holding a QObject*
 #if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
   if (value.canConvert<QVariantList>()) {
-    QSequentialIterable it = value.value<QSequentialIterable>();
-    foreach (const QVariant &v, it) {
+    QSequentialIterable iterable = value.value<QSequentialIterable>();
+    foreach (const QVariant &v, iterable) {
       if (!canSerialize(v))
         return false;
     }
+  } else if (value.canConvert<QVariantHash>() || value.canConvert<QVariantMap>()) {
+    QAssociativeIterable iterable = value.value<QAssociativeIterable>();
+    for (QAssociativeIterable::const_iterator element = iterable.begin(); element != iterable.end(); ++element) {
+      if (!canSerialize(element.key()) || !canSerialize(element.value()))
+        return false;
+    }
   }
 #endif
-
-  // ugly, but there doesn't seem to be a better way atm to find out without trying
-  m_dummyBuffer->seek(0);
-  QDataStream stream(m_dummyBuffer);
-  return QMetaType::save(stream, value.userType(), value.constData());
+  return true;
 }
 
 void RemoteModelServer::modelMonitored(bool monitored)
@@ -300,15 +333,14 @@ void RemoteModelServer::dataChanged(const QModelIndex& begin, const QModelIndex&
 {
   if (!isConnected())
     return;
-  Message msg(m_myAddress, Protocol::ModelContentChanged);
-  msg.payload() << Protocol::fromQModelIndex(begin) << Protocol::fromQModelIndex(end) << roles;
-  sendMessage(msg);
+  queueChange(Protocol::ModelContentChanged, begin.parent(), begin.row(), end.row(), begin.column(), end.column(), roles);
 }
 
 void RemoteModelServer::headerDataChanged(Qt::Orientation orientation, int first, int last)
 {
   if (!isConnected())
     return;
+  flushChanges();
   Message msg(m_myAddress, Protocol::ModelHeaderChanged);
   msg.payload() <<  qint8(orientation) << first << last;
   sendMessage(msg);
@@ -316,7 +348,9 @@ void RemoteModelServer::headerDataChanged(Qt::Orientation orientation, int first
 
 void RemoteModelServer::rowsInserted(const QModelIndex& parent, int start, int end)
 {
-  sendAddRemoveMessage(Protocol::ModelRowsAdded, parent, start, end);
+  if (!isConnected())
+    return;
+  queueChange(Protocol::ModelRowsAdded, parent, start, end);
 }
 
 void RemoteModelServer::rowsAboutToBeMoved(const QModelIndex& sourceParent, int sourceStart, int sourceEnd, const QModelIndex& destinationParent, int destinationRow)
@@ -340,7 +374,9 @@ void RemoteModelServer::rowsMoved(const QModelIndex& sourceParent, int sourceSta
 
 void RemoteModelServer::rowsRemoved(const QModelIndex& parent, int start, int end)
 {
-  sendAddRemoveMessage(Protocol::ModelRowsRemoved, parent, start, end);
+  if (!isConnected())
+    return;
+  queueChange(Protocol::ModelRowsRemoved, parent, start, end);
 }
 
 void RemoteModelServer::columnsInserted(const QModelIndex& parent, int start, int end)
@@ -382,6 +418,7 @@ void RemoteModelServer::sendLayoutChanged(const QVector< Protocol::ModelIndex >&
 {
   if (!isConnected())
     return;
+  flushChanges();
   Message msg(m_myAddress, Protocol::ModelLayoutChanged);
   msg.payload() << parents << hint;
   sendMessage(msg);
@@ -389,6 +426,7 @@ void RemoteModelServer::sendLayoutChanged(const QVector< Protocol::ModelIndex >&
 
 void RemoteModelServer::modelReset()
 {
+  m_pendingChanges.clear(); // superseded by the reset
   if (!isConnected())
     return;
   sendMessage(Message(m_myAddress, Protocol::ModelReset));
@@ -398,16 +436,136 @@ void RemoteModelServer::sendAddRemoveMessage(Protocol::MessageType type, const Q
 {
   if (!isConnected())
     return;
+  flushChanges();
   Message msg(m_myAddress, type);
   msg.payload() << Protocol::fromQModelIndex(parent) << start << end;
   sendMessage(msg);
 }
 
+void RemoteModelServer::queueChange(Protocol::MessageType type, const QModelIndex& parent, int first, int last, int firstColumn, int lastColumn, const QVector<int>& roles)
+{
+  const Protocol::ModelIndex parentIndex = Protocol::fromQModelIndex(parent);
+  if (type == Protocol::ModelRowsRemoved)
+    discardChangesInRemovedRows(parentIndex, first, last);
+
+  m_pendingChangesTimer->start();
+
+  if (!m_pendingChanges.isEmpty()) {
+    PendingChange &prev = m_pendingChanges.last();
+    if (prev.type == type && prev.parent == parentIndex) {
+      switch (type) {
+        case Protocol::ModelContentChanged:
+          if (!rangesTouch(prev.first, prev.last, first, last) || !rangesTouch(prev.firstColumn, prev.lastColumn, firstColumn, lastColumn))
+            break;
+          prev.first = qMin(prev.first, first);
+          prev.last = qMax(prev.last, last);
+          prev.firstColumn = qMin(prev.firstColumn, firstColumn);
+          prev.lastColumn = qMax(prev.lastColumn, lastColumn);
+          if (roles.isEmpty()) {
+            prev.roles.clear(); // all roles changed
+          } else if (!prev.roles.isEmpty()) {
+            foreach (int role, roles) {
+              if (!prev.roles.contains(role))
+                prev.roles.push_back(role);
+            }
+          }
+          return;
+        case Protocol::ModelRowsAdded:
+          // inserted into or right next to the previously inserted block
+          if (first < prev.first || first > prev.last + 1)
+            break;
+          prev.last += last - first + 1;
+          return;
+        case Protocol::ModelRowsRemoved:
+          // removal of the rows right after the previously removed block
+          if (first == prev.first) {
+            prev.last += last - first + 1;
+            return;
+          }
+          // removal of the rows right before the previously removed block
+          if (last + 1 == prev.first) {
+            prev.first = first;
+            return;
+          }
+          break;
+      }
+    }
+  }
+
+  PendingChange change;
+  change.type = type;
+  change.parent = parentIndex;
+  change.first = first;
+  change.last = last;
+  change.firstColumn = firstColumn;
+  change.lastColumn = lastColumn;
+  change.roles = roles;
+  m_pendingChanges.push_back(change);
+}
+
+void RemoteModelServer::discardChangesInRemovedRows(const Protocol::ModelIndex& parent, int first, int last)
+{
+  // only data changes after the last structural change share the coordinates of this removal
+  for (int i = m_pendingChanges.size() - 1; i >= 0; --i) {
+    PendingChange &change = m_pendingChanges[i];
+    if (change.type != Protocol::ModelContentChanged)
+      break;
+
+    if (change.parent == parent) {
+      if (change.first >= first && change.last <= last) {
+        m_pendingChanges.remove(i);
+      } else if (change.first >= first && change.first <= last) {
+        change.first = last + 1;
+      } else if (change.last >= first && change.last <= last) {
+        change.last = first - 1;
+      }
+    } else if (change.parent.size() > parent.size()
+            && change.parent.at(parent.size()).first >= first
+            && change.parent.at(parent.size()).first <= last
+            && change.parent.mid(0, parent.size()) == parent) {
+      m_pendingChanges.remove(i); // inside a removed sub-tree
+    }
+  }
+}
+
+void RemoteModelServer::flushChanges()
+{
+  m_pendingChangesTimer->stop();
+  if (m_pendingChanges.isEmpty())
+    return;
+
+  const QVector<PendingChange> changes = m_pendingChanges;
+  m_pendingChanges.clear();
+  if (!isConnected())
+    return;
+
+  // a single change is sent as the plain message, everything else as one compound message
+  Message msg(m_myAddress, changes.size() == 1 ? changes.first().type : Protocol::ModelChangeBatch);
+  if (changes.size() > 1)
+    msg.payload() << quint32(changes.size());
+
+  foreach (const PendingChange &change, changes) {
+    if (changes.size() > 1)
+      msg.payload() << change.type;
+    if (change.type == Protocol::ModelContentChanged) {
+      Protocol::ModelIndex begin = change.parent;
+      begin.push_back(qMakePair(change.first, change.firstColumn));
+      Protocol::ModelIndex end = change.parent;
+      end.push_back(qMakePair(change.last, change.lastColumn));
+      msg.payload() << begin << end << change.roles;
+    } else {
+      msg.payload() << change.parent << change.first << change.last;
+    }
+  }
+  sendMessage(msg);
+}
+
 void RemoteModelServer::sendMoveMessage(Protocol::MessageType type, const Protocol::ModelIndex& sourceParent, int sourceStart, int sourceEnd,
                                         const Protocol::ModelIndex& destinationParent, int destinationIndex)
 {
   if (!isConnected())
     return;
+  flushChanges();
   Message msg(m_myAddress, type);
   msg.payload() << sourceParent << qint32(sourceStart) << qint32(sourceEnd)
                << destinationParent << qint32(destinationIndex);
@@ -34,9 +34,11 @@
 #include <QObject>
 #include <QPointer>
 #include <QRegExp>
+#include <QHash>
 
 class QBuffer;
 class QAbstractItemModel;
+class QTimer;
 
 namespace GammaRay {
 
@@ -75,6 +77,10 @@ class RemoteModelServer : public QObject
     void connectModel();
     void disconnectModel();
     void sendAddRemoveMessage(Protocol::MessageType type, const QModelIndex &parent, int start, int end);
+    /** Adds a change to the journal sent at the end of the current event loop iteration. */
+    void queueChange(Protocol::MessageType type, const QModelIndex &parent, int first, int last, int firstColumn = 0, int lastColumn = 0, const QVector<int> &roles = QVector<int>());
+    /** Drops queued data changes for rows that are about to be removed. */
+    void discardChangesInRemovedRows(const Protocol::ModelIndex &parent, int first, int last);
     void sendMoveMessage(Protocol::MessageType type, const Protocol::ModelIndex &sourceParent, int sourceStart, int sourceEnd, const Protocol::ModelIndex &destinationParent, int destinationIndex);
     QMap< int, QVariant > filterItemData(const QMap< int, QVariant >& data) const;
     void sendLayoutChanged(const QVector<Protocol::ModelIndex> &parents = QVector<Protocol::ModelIndex>(), quint32 hint = 0);
@@ -117,12 +123,32 @@ class RemoteModelServer : public QObject
 
     void modelDeleted();
 
+    /** Sends all queued changes, call before sending anything else to preserve the message order. */
+    void flushChanges();
+
   private:
+    struct PendingChange {
+      Protocol::MessageType type;
+      Protocol::ModelIndex parent;
+      qint32 first;
+      qint32 last;
+      // for data changes only
+      qint32 firstColumn;
+      qint32 lastColumn;
+      QVector<int> roles;
+    };
+
     QPointer<QAbstractItemModel> m_model;
+    // data changes and row insertions/removals of the current event loop iteration,
+    // adjacent ranges are merged
+    QVector<PendingChange> m_pendingChanges;
+    QTimer *m_pendingChangesTimer;
     // those two are used for canSerialize, since recreating the QBuffer is somewhat expensive,
     // especially since being a QObject triggers all kind of GammaRay internals
     QByteArray m_dummyData;
     QBuffer *m_dummyBuffer;
+    // metatypes known to have (or lack) stream operators, shared among all instances
+    static QHash<int, bool> s_serializableTypes;
     // converted model indexes from aboutToBeX signals, needed in cases where the operation changes
     // the serialized index (move to sub-tree of source parent for example)
     // as operations can occur nested, we need to have a stack for this
@@ -140,7 +140,10 @@ void Server::sendServerGreeting()
 
   {
     Message msg(endpointAddress(), Protocol::ServerInfo);
-    msg.payload() << label(); // TODO: expand with anything else needed here: Qt/GammaRay version, hostname, that kind of stuff
+    quint32 capabilities = Protocol::NoCapabilities;
+    if (ProbeSettings::value(QStringLiteral("MessageCompression"), true).toBool())
+      capabilities |= Protocol::MessageCompression;
+    msg.payload() << label() << capabilities; // TODO: expand with anything else needed here: Qt/GammaRay version, hostname, that kind of stuff
     send(msg);
   }
 
@@ -169,6 +172,14 @@ void Server::messageReceived(const Message& msg)
         QMetaObject::invokeMethod(it.value().first, it.value().second, Q_ARG(bool, msg.type() == Protocol::ObjectMonitored));
         break;
       }
+      case Protocol::ClientInfo:
+      {
+        quint32 capabilities;
+        msg.payload() >> capabilities;
+        // the client only accepts what we offered in the greeting
+        setCompressionEnabled(capabilities & Protocol::MessageCompression);
+        break;
+      }
     }
   } else {
     dispatchMessage(msg);
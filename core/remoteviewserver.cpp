@@ -28,8 +28,11 @@
 
 #include "remoteviewserver.h"
 
+#include <core/probesettings.h>
 #include <core/remote/server.h>
 
+#include <common/remoteviewframe.h>
+
 #include <QCoreApplication>
 #include <QDebug>
 #include <QMouseEvent>
@@ -41,19 +44,71 @@
 
 using namespace GammaRay;
 
+// send a full frame at least this often, so the client recovers from any glitch eventually
+static const int KeyFrameInterval = 100;
+
+// bounds for the adaptive update interval, in ms
+static const int MinUpdateInterval = 40;
+static const int MaxUpdateInterval = 2000;
+// how long after the last input event we consider the user to be interacting, in ms
+static const int InteractionTimeout = 500;
+
+// exponential moving average for the timing measurements
+static qreal smoothed(qreal average, qint64 sample)
+{
+    return 0.75 * average + 0.25 * sample;
+}
+
+static quint64 hashTile(const QImage &image, const QRect &rect)
+{
+    // FNV-1a, applied to machine words where possible
+    quint64 hash = Q_UINT64_C(14695981039346656037);
+    const int rowSize = rect.width() * image.depth() / 8;
+    const int wordCount = rowSize / (int)sizeof(quint64);
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        const uchar *row = image.constScanLine(y) + rect.x() * image.depth() / 8;
+        for (int i = 0; i < wordCount; ++i) {
+            quint64 word;
+            memcpy(&word, row + i * sizeof(quint64), sizeof(quint64));
+            hash = (hash ^ word) * Q_UINT64_C(1099511628211);
+        }
+        for (int i = wordCount * sizeof(quint64); i < rowSize; ++i)
+            hash = (hash ^ row[i]) * Q_UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
 RemoteViewServer::RemoteViewServer(const QString& name, QObject* parent):
     RemoteViewInterface(name, parent),
     m_eventReceiver(Q_NULLPTR),
     m_updateTimer(new QTimer(this)),
+    m_interactionTimer(new QTimer(this)),
     m_clientActive(false),
     m_sourceChanged(false),
-    m_clientReady(true)
+    m_clientReady(true),
+    m_lastImageFormat(QImage::Format_Invalid),
+    m_framesSinceKeyFrame(0),
+    m_tileEncodingEnabled(false),
+    m_keyFrameRequested(true),
+    m_framesSent(0),
+    m_keyFramesSent(0),
+    m_imageBytesSent(0),
+    m_grabTime(0.0),
+    m_serializationTime(0.0),
+    m_ackLatency(0.0),
+    m_reducedResolution(false),
+    m_maxLoad(qBound(1, ProbeSettings::value(QStringLiteral("RemoteViewMaxLoad"), 25).toInt(), 100))
 {
     Server::instance()->registerMonitorNotifier(Endpoint::instance()->objectAddress(name), this, "clientConnectedChanged");
 
     m_updateTimer->setSingleShot(true);
-    m_updateTimer->setInterval(100);
+    m_updateTimer->setInterval(MinUpdateInterval);
     connect(m_updateTimer, SIGNAL(timeout()), this, SLOT(requestUpdateTimeout()));
+
+    // once interaction stops, refresh in full resolution
+    m_interactionTimer->setSingleShot(true);
+    m_interactionTimer->setInterval(InteractionTimeout);
+    connect(m_interactionTimer, SIGNAL(timeout()), this, SLOT(interactionFinished()));
 }
 
 void RemoteViewServer::setEventReceiver(EventReceiver* receiver)
@@ -68,6 +123,7 @@ void RemoteViewServer::pickElementAt(const QPoint& pos)
 
 void RemoteViewServer::resetView()
 {
+    m_keyFrameRequested = true;
     emit reset();
 }
 
@@ -79,7 +135,133 @@ bool RemoteViewServer::isActive() const
 void RemoteViewServer::sendFrame(const RemoteViewFrame& frame)
 {
     m_clientReady = false;
-    emit frameUpdated(frame);
+    if (m_grabTimer.isValid()) {
+        m_grabTime = smoothed(m_grabTime, m_grabTimer.elapsed());
+        m_grabTimer.invalidate();
+    }
+
+    QElapsedTimer serializationTimer;
+    serializationTimer.start();
+
+    RemoteViewFrame f(frame);
+    m_reducedResolution = useReducedResolution();
+    if (m_reducedResolution) {
+        const QImage img = f.image();
+        // viewRect() defaults to the image rect, pin the one of the full resolution source frame
+        // before downscaling, so the client keeps mapping the image onto the original view coordinates
+        f.setViewRect(frame.viewRect());
+        f.setImage(img.scaled(img.size() / 2, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+    }
+    encodeFrame(f);
+
+    ++m_framesSent;
+    if (!f.isDelta())
+        ++m_keyFramesSent;
+    m_imageBytesSent += f.encodedImageSize();
+
+    emit frameUpdated(f);
+
+    m_serializationTime = smoothed(m_serializationTime, serializationTimer.elapsed());
+    m_ackTimer.start();
+}
+
+int RemoteViewServer::maximumLoad() const
+{
+    return m_maxLoad;
+}
+
+void RemoteViewServer::setMaximumLoad(int percent)
+{
+    m_maxLoad = qBound(1, percent, 100);
+    updatePacing();
+}
+
+bool RemoteViewServer::useReducedResolution() const
+{
+    if (!m_interactionTimer->isActive())
+        return false;
+    // stay reduced for the entire interaction, switching resolution forces key frames
+    if (m_reducedResolution)
+        return true;
+    // only worth it if full resolution frames can't keep up with the minimum interval
+    return (m_grabTime + m_serializationTime) * 100.0 / m_maxLoad > MinUpdateInterval;
+}
+
+void RemoteViewServer::updatePacing()
+{
+    // a frame cycle consists of the frame cost, the client round-trip and the update interval,
+    // the frame cost must not exceed m_maxLoad percent of that
+    const qreal cost = m_grabTime + m_serializationTime;
+    const qreal interval = cost * 100.0 / m_maxLoad - cost - m_ackLatency;
+    m_updateTimer->setInterval(qBound(MinUpdateInterval, qRound(interval), MaxUpdateInterval));
+}
+
+quint64 RemoteViewServer::framesSent() const
+{
+    return m_framesSent;
+}
+
+quint64 RemoteViewServer::keyFramesSent() const
+{
+    return m_keyFramesSent;
+}
+
+quint64 RemoteViewServer::imageBytesSent() const
+{
+    return m_imageBytesSent;
+}
+
+void RemoteViewServer::encodeFrame(RemoteViewFrame& frame)
+{
+    if (!m_tileEncodingEnabled)
+        return;
+
+    const QImage img = frame.image();
+    if (img.isNull() || img.depth() % 8 != 0) {
+        m_tileHashes.clear();
+        return;
+    }
+
+    const int tileSize = TransferImage::TileSize;
+    const int columns = (img.width() + tileSize - 1) / tileSize;
+    const int rows = (img.height() + tileSize - 1) / tileSize;
+
+    QVector<quint64> hashes;
+    hashes.reserve(columns * rows);
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            const QRect tile = QRect(column * tileSize, row * tileSize, tileSize, tileSize) & img.rect();
+            hashes.push_back(hashTile(img, tile));
+        }
+    }
+
+    const bool keyFrame = m_keyFrameRequested
+        || m_framesSinceKeyFrame >= KeyFrameInterval
+        || img.size() != m_lastImageSize
+        || img.format() != m_lastImageFormat
+        || hashes.size() != m_tileHashes.size();
+
+    QVector<QRect> dirtyTiles;
+    for (int i = 0; !keyFrame && i < hashes.size(); ++i) {
+        if (hashes.at(i) == m_tileHashes.at(i))
+            continue;
+        const int row = i / columns;
+        const int column = i % columns;
+        dirtyTiles.push_back(QRect(column * tileSize, row * tileSize, tileSize, tileSize) & img.rect());
+    }
+
+    m_tileHashes = hashes;
+    m_lastImageSize = img.size();
+    m_lastImageFormat = img.format();
+
+    if (keyFrame) {
+        m_keyFrameRequested = false;
+        m_framesSinceKeyFrame = 0;
+        return;
+    }
+
+    ++m_framesSinceKeyFrame;
+    frame.setDirtyTiles(dirtyTiles);
 }
 
 void RemoteViewServer::sourceChanged()
@@ -91,9 +273,26 @@ void RemoteViewServer::sourceChanged()
 void RemoteViewServer::clientViewUpdated()
 {
     m_clientReady = true;
+    if (m_ackTimer.isValid()) {
+        m_ackLatency = smoothed(m_ackLatency, m_ackTimer.elapsed());
+        m_ackTimer.invalidate();
+        updatePacing();
+    }
     checkRequestUpdate();
 }
 
+void RemoteViewServer::setTileEncodingEnabled(bool enabled)
+{
+    m_tileEncodingEnabled = enabled;
+    m_keyFrameRequested = true;
+}
+
+void RemoteViewServer::requestKeyFrame()
+{
+    m_keyFrameRequested = true;
+    sourceChanged();
+}
+
 void RemoteViewServer::checkRequestUpdate()
 {
     if (isActive() && !m_updateTimer->isActive() && m_clientReady && m_sourceChanged)
@@ -104,6 +303,7 @@ void RemoteViewServer::sendKeyEvent(int type, int key, int modifiers, const QStr
 {
     if (!m_eventReceiver)
         return;
+    m_interactionTimer->start();
 
     auto event = new QKeyEvent((QEvent::Type)type, key, (Qt::KeyboardModifiers)modifiers, text, autorep, count);
     QCoreApplication::postEvent(m_eventReceiver, event);
@@ -113,6 +313,7 @@ void RemoteViewServer::sendMouseEvent(int type, const QPoint& localPos, int butt
 {
     if (!m_eventReceiver)
         return;
+    m_interactionTimer->start();
 
     auto event = new QMouseEvent((QEvent::Type)type, localPos, (Qt::MouseButton)button, (Qt::MouseButtons)buttons, (Qt::KeyboardModifiers)modifiers);
     QCoreApplication::postEvent(m_eventReceiver, event);
@@ -122,6 +323,7 @@ void RemoteViewServer::sendWheelEvent(const QPoint& localPos, QPoint pixelDelta,
 {
     if (!m_eventReceiver)
         return;
+    m_interactionTimer->start();
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
     auto event = new QWheelEvent(localPos, m_eventReceiver->mapToGlobal(localPos), pixelDelta, angleDelta, 0, /*not used*/ Qt::Vertical, /*not used*/ (Qt::MouseButtons)buttons, (Qt::KeyboardModifiers)modifiers);
@@ -138,20 +340,37 @@ void RemoteViewServer::setViewActive(bool active)
 {
     m_clientActive = active;
     m_clientReady = active;
+    m_keyFrameRequested = true;
     if (active)
         sourceChanged();
     else
         m_updateTimer->stop();
+    m_ackTimer.invalidate();
 }
 
 void RemoteViewServer::clientConnectedChanged(bool connected)
 {
-    if (!connected)
+    if (!connected) {
         setViewActive(false);
+        m_tileEncodingEnabled = false;
+    }
+}
+
+void RemoteViewServer::interactionFinished()
+{
+    if (m_reducedResolution)
+        sourceChanged();
 }
 
 void RemoteViewServer::requestUpdateTimeout()
 {
+    m_grabTimer.start();
     emit requestUpdate();
+    if (m_grabTimer.isValid()) {
+        // asynchronous grab (e.g. waiting for the next rendered frame), only the work done
+        // so far is a cost to us, waiting for the frame is not
+        m_grabTime = smoothed(m_grabTime, m_grabTimer.elapsed());
+        m_grabTimer.invalidate();
+    }
     m_sourceChanged = false;
 }
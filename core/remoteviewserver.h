@@ -33,6 +33,10 @@
 
 #include <common/remoteviewinterface.h>
 
+#include <QElapsedTimer>
+#include <QImage>
+#include <QVector>
+
 class QTimer;
 class QWindow;
 
@@ -43,6 +47,9 @@ class GAMMARAY_CORE_EXPORT RemoteViewServer : public RemoteViewInterface
 {
     Q_OBJECT
     Q_INTERFACES(GammaRay::RemoteViewInterface)
+    Q_PROPERTY(quint64 framesSent READ framesSent)
+    Q_PROPERTY(quint64 keyFramesSent READ keyFramesSent)
+    Q_PROPERTY(quint64 imageBytesSent READ imageBytesSent)
 public:
     explicit RemoteViewServer(const QString& name, QObject* parent = Q_NULLPTR);
 
@@ -63,6 +70,21 @@ public:
     /// sends a new frame to the client
     void sendFrame(const RemoteViewFrame &frame);
 
+    /// number of frames sent to the client so far
+    quint64 framesSent() const;
+    /// number of frames that had to be sent in full
+    quint64 keyFramesSent() const;
+    /// accumulated size of the image data of all frames sent so far
+    quint64 imageBytesSent() const;
+
+    /**
+     * Maximum share of the main thread time (in percent) spent on producing frames.
+     * The update interval is adjusted based on the measured cost of producing and sending
+     * a frame to stay below this. Defaults to the RemoteViewMaxLoad probe setting, or 25%.
+     */
+    int maximumLoad() const;
+    void setMaximumLoad(int percent);
+
 public slots:
     /// call this to indicate the source has changed and the client reuqires an update
     void sourceChanged();
@@ -79,19 +101,50 @@ private:
     void sendWheelEvent(const QPoint& localPos, QPoint pixelDelta, QPoint angleDelta, int buttons, int modifiers) Q_DECL_OVERRIDE;
     void setViewActive(bool active) Q_DECL_OVERRIDE;
     void clientViewUpdated() Q_DECL_OVERRIDE;
+    void setTileEncodingEnabled(bool enabled) Q_DECL_OVERRIDE;
+    void requestKeyFrame() Q_DECL_OVERRIDE;
 
     void checkRequestUpdate();
+    /// adjusts the update interval based on the measured frame cost
+    void updatePacing();
+    /// downscale frames while the user is interacting and full frames are too expensive
+    bool useReducedResolution() const;
+    /// reduces @p frame to the tiles that changed since the last frame, if possible
+    void encodeFrame(RemoteViewFrame &frame);
 
 private slots:
     void clientConnectedChanged(bool connected);
     void requestUpdateTimeout();
+    void interactionFinished();
 
 private:
     EventReceiver *m_eventReceiver;
     QTimer *m_updateTimer;
+    QTimer *m_interactionTimer;
     bool m_clientActive;
     bool m_sourceChanged;
     bool m_clientReady;
+
+    // tile-based delta encoding state
+    QVector<quint64> m_tileHashes;
+    QSize m_lastImageSize;
+    QImage::Format m_lastImageFormat;
+    int m_framesSinceKeyFrame;
+    bool m_tileEncodingEnabled;
+    bool m_keyFrameRequested;
+
+    quint64 m_framesSent;
+    quint64 m_keyFramesSent;
+    quint64 m_imageBytesSent;
+
+    // frame pacing measurements, in ms
+    QElapsedTimer m_grabTimer;
+    QElapsedTimer m_ackTimer;
+    qreal m_grabTime;
+    qreal m_serializationTime;
+    qreal m_ackLatency;
+    bool m_reducedResolution;
+    int m_maxLoad;
 };
 
 }
@@ -28,6 +28,8 @@
 
 #include "signalspycallbackset.h"
 
+#include <QMetaObject>
+
 using namespace GammaRay;
 
 SignalSpyCallbackSet::SignalSpyCallbackSet() :
@@ -42,3 +44,28 @@ bool SignalSpyCallbackSet::isNull() const
 {
     return signalBeginCallback == 0 && signalEndCallback == 0 && slotBeginCallback == 0 && slotEndCallback == 0;
 }
+
+void SignalSpyCallbackSet::addMethodFilter(const QMetaObject *metaObject, int methodIndex)
+{
+    Q_ASSERT(metaObject);
+    Q_ASSERT(methodIndex >= 0 && methodIndex < metaObject->methodCount());
+    const MethodFilter filter = { metaObject, methodIndex };
+    methodFilters.push_back(filter);
+}
+
+bool SignalSpyCallbackSet::acceptsMethod(const QMetaObject *metaObject, int methodIndex) const
+{
+    if (methodFilters.isEmpty())
+        return true;
+
+    for (int i = 0; i < methodFilters.size(); ++i) {
+        const MethodFilter &filter = methodFilters.at(i);
+        if (filter.methodIndex != methodIndex)
+            continue;
+        for (const QMetaObject *mo = metaObject; mo; mo = mo->superClass()) {
+            if (mo == filter.metaObject)
+                return true;
+        }
+    }
+    return false;
+}
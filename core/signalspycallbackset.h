@@ -31,7 +31,10 @@
 
 #include "gammaray_core_export.h"
 
+#include <QVector>
+
 class QObject;
+struct QMetaObject;
 
 namespace GammaRay {
 
@@ -44,6 +47,19 @@ struct GAMMARAY_CORE_EXPORT SignalSpyCallbackSet
     SignalSpyCallbackSet();
     bool isNull() const;
 
+    /**
+     * Restricts the callbacks to the method @p methodIndex of @p metaObject and classes derived from it.
+     * Can be called multiple times, without any restriction the callbacks are called for all signals/slots.
+     * This allows the probe to skip all other emissions and invocations early.
+     * @since 2.5
+     */
+    void addMethodFilter(const QMetaObject *metaObject, int methodIndex);
+    /**
+     * Returns @c true if the callbacks want to see @p methodIndex of an object of type @p metaObject.
+     * @since 2.5
+     */
+    bool acceptsMethod(const QMetaObject *metaObject, int methodIndex) const;
+
     typedef void (*BeginCallback)(QObject *caller, int methodIndex, void **argv);
     typedef void (*EndCallback)(QObject *caller, int methodIndex);
 
@@ -51,6 +67,13 @@ struct GAMMARAY_CORE_EXPORT SignalSpyCallbackSet
     EndCallback signalEndCallback;
     BeginCallback slotBeginCallback;
     EndCallback slotEndCallback;
+
+    struct MethodFilter
+    {
+        const QMetaObject *metaObject;
+        int methodIndex;
+    };
+    QVector<MethodFilter> methodFilters;
 };
 
 }
@@ -32,6 +32,7 @@
 #include "proxytoolfactory.h"
 #include "probe.h"
 #include "probesettings.h"
+#include "util.h"
 
 #include "tools/localeinspector/localeinspector.h"
 #include "tools/metatypebrowser/metatypebrowser.h"
@@ -59,6 +60,12 @@
 
 using namespace GammaRay;
 
+/** Hash key for @p className, only valid as long as @p className is. */
+static inline QByteArray classNameKey(const char *className)
+{
+  return QByteArray::fromRawData(className, qstrlen(className));
+}
+
 ToolModel::ToolModel(QObject *parent): QAbstractListModel(parent)
 {
   // built-in tools
@@ -151,27 +158,28 @@ void ToolModel::objectAdded(QObject *obj)
   Q_ASSERT(QThread::currentThread() == thread());
   Q_ASSERT(Probe::instance()->isValidObject(obj));
 
-  // m_knownMetaObjects allows us to skip the expensive recursive search for matching tools
-  if (!m_knownMetaObjects.contains(obj->metaObject())) {
-    objectAdded(obj->metaObject());
-    m_knownMetaObjects.insert(obj->metaObject());
-  }
+  objectAdded(obj->metaObject());
 }
 
 void ToolModel::objectAdded(const QMetaObject *mo)
 {
   Q_ASSERT(thread() == QThread::currentThread());
-  foreach (ToolFactory *factory, m_inactiveTools) {
-    if (factory->supportedTypes().contains(mo->className())) {
-      m_inactiveTools.remove(factory);
+  // m_knownMetaObjects allows us to stop at the first class we have seen before, since
+  // tools for it and all its base classes have been activated already
+  for (; mo && !m_knownMetaObjects.contains(mo); mo = mo->superClass()) {
+    m_knownMetaObjects.insert(mo);
+    const QHash<QByteArray, QVector<ToolFactory*> >::const_iterator it = m_toolsForClassName.constFind(classNameKey(mo->className()));
+    if (it == m_toolsForClassName.constEnd())
+      continue;
+    foreach (ToolFactory *factory, it.value()) {
+      if (!m_inactiveTools.remove(factory))
+        continue;
       factory->init(Probe::instance());
       const int row = m_tools.indexOf(factory);
-      emit dataChanged(index(row, 0), index(row, 0));
+      if (row >= 0)
+        emit dataChanged(index(row, 0), index(row, 0));
     }
   }
-  if (mo->superClass()) {
-    objectAdded(mo->superClass());
-  }
 }
 
 QVector< ToolFactory* > ToolModel::plugins() const
@@ -188,17 +196,17 @@ QModelIndex ToolModel::toolForObject(QObject* object) const
 {
   if (!object)
     return QModelIndex();
-  const QMetaObject *metaObject = object->metaObject();
-  while (metaObject) {
-    for (int i = 0; i < m_tools.size(); i++) {
-      const ToolFactory *factory = m_tools.at(i);
-      if (factory && factory->supportedTypes().contains(metaObject->className())) {
-        return index(i, 0);
-      }
-    }
-    metaObject = metaObject->superClass();
+  // dynamic meta objects (eg. of QML types) can exist per instance, and their address
+  // can be reused for unrelated types later on, so only memoize the result for static ones,
+  // which is none at all without private headers, as we can't tell them apart then
+  const QMetaObject *staticMetaObject = Util::firstStaticMetaObject(object);
+  for (const QMetaObject *mo = object->metaObject(); mo && mo != staticMetaObject; mo = mo->superClass()) {
+    const int row = m_toolRowForClassName.value(classNameKey(mo->className()), -1);
+    if (row >= 0)
+      return index(row, 0);
   }
-  return QModelIndex();
+  const int row = toolRowForMetaObject(staticMetaObject);
+  return row >= 0 ? index(row, 0) : QModelIndex();
 }
 
 QModelIndex ToolModel::toolForObject(const void* object, const QString& typeName) const
@@ -207,20 +215,40 @@ QModelIndex ToolModel::toolForObject(const void* object, const QString& typeName
     return QModelIndex();
   const MetaObject *metaObject = MetaObjectRepository::instance()->metaObject(typeName);
   while (metaObject) {
-    for (int i = 0; i < m_tools.size(); i++) {
-      const ToolFactory *factory = m_tools.at(i);
-      if (factory && factory->supportedTypes().contains(metaObject->className())) {
-        return index(i, 0);
-      }
-    }
+    const int row = m_toolRowForClassName.value(metaObject->className().toLatin1(), -1);
+    if (row >= 0)
+      return index(row, 0);
     metaObject = metaObject->superClass();
   }
   return QModelIndex();
 }
 
+int ToolModel::toolRowForMetaObject(const QMetaObject *mo) const
+{
+  if (!mo)
+    return -1;
+
+  const QHash<const QMetaObject*, int>::const_iterator it = m_toolRowForMetaObject.constFind(mo);
+  if (it != m_toolRowForMetaObject.constEnd())
+    return it.value();
+
+  int row = m_toolRowForClassName.value(classNameKey(mo->className()), -1);
+  if (row < 0)
+    row = toolRowForMetaObject(mo->superClass());
+  m_toolRowForMetaObject.insert(mo, row);
+  return row;
+}
+
 void ToolModel::addToolFactory(ToolFactory* tool)
 {
   if (!tool->isHidden())
     m_tools.push_back(tool);
   m_inactiveTools.insert(tool);
+
+  foreach (const QString &type, tool->supportedTypes()) {
+    const QByteArray className = type.toLatin1();
+    m_toolsForClassName[className].push_back(tool);
+    if (!tool->isHidden() && !m_toolRowForClassName.contains(className))
+      m_toolRowForClassName.insert(className, m_tools.size() - 1);
+  }
 }
@@ -29,10 +29,13 @@
 #ifndef GAMMARAY_TOOLMODEL_H
 #define GAMMARAY_TOOLMODEL_H
 
+#include "gammaray_core_export.h"
+
 #include <common/pluginmanager.h>
 #include <common/modelroles.h>
 
 #include <QAbstractListModel>
+#include <QHash>
 #include <QSet>
 #include <QVector>
 #include <QPointer>
@@ -47,7 +50,7 @@ typedef PluginManager<ToolFactory, ProxyToolFactory> ToolPluginManager;
 /**
  * Manages the list of available probing tools.
  */
-class ToolModel : public QAbstractListModel
+class GAMMARAY_CORE_EXPORT ToolModel : public QAbstractListModel
 {
   Q_OBJECT
   public:
@@ -82,11 +85,18 @@ class ToolModel : public QAbstractListModel
     void objectAdded(const QMetaObject *mo);
 
     void addToolFactory(ToolFactory* tool);
+    /** returns the row of the tool best suited for instances of @p mo, or -1 if there is none. */
+    int toolRowForMetaObject(const QMetaObject *mo) const;
 
   private:
     QVector<ToolFactory*> m_tools;
     QSet<ToolFactory*> m_inactiveTools;
     QSet<const QMetaObject*> m_knownMetaObjects;
+    /// all tools, including hidden ones, supporting a given class name
+    QHash<QByteArray, QVector<ToolFactory*> > m_toolsForClassName;
+    /// row of the first visible tool supporting a given class name
+    QHash<QByteArray, int> m_toolRowForClassName;
+    mutable QHash<const QMetaObject*, int> m_toolRowForMetaObject;
     QPointer<QWidget> m_parentWidget;
     QScopedPointer<ToolPluginManager> m_pluginManager;
 };
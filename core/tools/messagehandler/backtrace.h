@@ -31,9 +31,18 @@
 #define GAMMARAY_MESSAGEHANDLER_BACKTRACE_H
 
 #include <QStringList>
+#include <QVector>
 
 typedef QStringList Backtrace;
+typedef QVector<quintptr> BacktraceAddresses;
 
+/** Returns the current call stack with resolved symbols. */
 Backtrace getBacktrace(int levels = -1);
+/** Returns the return addresses of the current call stack, without the expensive symbol lookup.
+ *  This is empty on platforms where the two steps can't be separated.
+ */
+BacktraceAddresses getBacktraceAddresses(int levels = -1);
+/** Resolves the symbols of a call stack captured with getBacktraceAddresses(). */
+Backtrace symbolizeBacktrace(const BacktraceAddresses &addresses);
 
 #endif // BACKTRACE_H
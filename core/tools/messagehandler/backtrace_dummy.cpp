@@ -33,3 +33,15 @@ Backtrace getBacktrace(int levels)
   Q_UNUSED(levels);
   return Backtrace();
 }
+
+BacktraceAddresses getBacktraceAddresses(int levels)
+{
+  Q_UNUSED(levels);
+  return BacktraceAddresses();
+}
+
+Backtrace symbolizeBacktrace(const BacktraceAddresses &addresses)
+{
+  Q_UNUSED(addresses);
+  return Backtrace();
+}
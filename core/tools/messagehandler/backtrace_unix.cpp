@@ -32,6 +32,7 @@
 #include "backtrace.h"
 
 #include <QString>
+#include <QVarLengthArray>
 #include <stdlib.h>
 
 #ifdef HAVE_BACKTRACE
@@ -69,17 +70,40 @@ static QString maybeDemangleName(char *name)
 
 Backtrace getBacktrace(int levels)
 {
-  QStringList s;
+  return symbolizeBacktrace(getBacktraceAddresses(levels));
+}
+
+BacktraceAddresses getBacktraceAddresses(int levels)
+{
+  BacktraceAddresses addresses;
 #ifdef HAVE_BACKTRACE
   void *trace[256];
-  int n = backtrace(trace, 256);
+  const int n = backtrace(trace, levels == -1 ? 256 : qMin(levels, 256));
+  addresses.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    addresses.push_back(reinterpret_cast<quintptr>(trace[i]));
+  }
+#else
+  Q_UNUSED(levels);
+#endif
+  return addresses;
+}
+
+Backtrace symbolizeBacktrace(const BacktraceAddresses &addresses)
+{
+  QStringList s;
+#ifdef HAVE_BACKTRACE
+  const int n = addresses.size();
   if (!n) {
     return s;
   }
-  char **strings = backtrace_symbols(trace, n);
-
-  if (levels != -1) {
-    n = qMin(n, levels);
+  QVarLengthArray<void*, 256> trace(n);
+  for (int i = 0; i < n; ++i) {
+    trace[i] = reinterpret_cast<void*>(addresses.at(i));
+  }
+  char **strings = backtrace_symbols(trace.constData(), n);
+  if (!strings) {
+    return s;
   }
 
   s.reserve(n);
@@ -87,11 +111,9 @@ Backtrace getBacktrace(int levels)
     s << maybeDemangleName(strings[i]);
   }
 
-  if (strings) {
-    free(strings);
-  }
+  free(strings);
 #else
-  Q_UNUSED(levels);
+  Q_UNUSED(addresses);
 #endif
   return s;
 }
@@ -75,3 +75,14 @@ Backtrace getBacktrace(int/*levels*/)
   }
   return stackWalkerToQStringList->getStackWalkerBacktrace();
 }
+
+// StackWalker can only resolve the stack it walks itself, so getBacktrace() has to be used here
+BacktraceAddresses getBacktraceAddresses(int/*levels*/)
+{
+  return BacktraceAddresses();
+}
+
+Backtrace symbolizeBacktrace(const BacktraceAddresses &/*addresses*/)
+{
+  return Backtrace();
+}
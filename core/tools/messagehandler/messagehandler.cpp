@@ -32,6 +32,7 @@
 #include "backtrace.h"
 
 #include <core/probeguard.h>
+#include <core/probesettings.h>
 #include <core/remote/serverproxymodel.h>
 
 #include "common/objectbroker.h"
@@ -39,9 +40,11 @@
 
 #include <QCoreApplication>
 #include <QDebug>
+#include <QAtomicInt>
 #include <QMutex>
 #include <QSortFilterProxyModel>
 #include <QThread>
+#include <QVector>
 
 #include <iostream>
 
@@ -60,6 +63,115 @@ static MessageHandlerCallback s_handler = 0;
 static bool s_handlerDisabled = false;
 static QMutex s_mutex(QMutex::Recursive);
 
+namespace {
+/**
+ * Bounded lock-free queue for messages from any thread, drained by MessageHandler
+ * in batches. All slots are allocated upfront, so queueing a message only copies it.
+ * See http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue,
+ * simplified for a single consumer.
+ */
+class MessageQueue
+{
+  public:
+    enum { Capacity = 4096 }; // must be a power of two
+
+    MessageQueue() : m_enqueuePos(0), m_dequeuePos(0), m_dropped(0), m_flushPending(0)
+    {
+      for (int i = 0; i < Capacity; ++i) {
+        m_slots[i].sequence.fetchAndStoreRelaxed(i);
+      }
+    }
+
+    /// Returns @c false if the queue is full, the message is counted as dropped then.
+    bool enqueue(const DebugMessage &message)
+    {
+      int pos = loadRelaxed(m_enqueuePos);
+      Slot *slot;
+      forever {
+        slot = &m_slots[pos & (Capacity - 1)];
+        const int diff = static_cast<int>(static_cast<uint>(loadAcquire(slot->sequence)) - static_cast<uint>(pos));
+        if (diff == 0) {
+          if (m_enqueuePos.testAndSetRelaxed(pos, pos + 1)) {
+            break;
+          }
+          pos = loadRelaxed(m_enqueuePos);
+        } else if (diff < 0) {
+          m_dropped.fetchAndAddRelaxed(1);
+          return false;
+        } else {
+          pos = loadRelaxed(m_enqueuePos);
+        }
+      }
+      slot->message = message;
+      slot->sequence.fetchAndStoreRelease(pos + 1);
+      return true;
+    }
+
+    /// Only to be called from the consumer thread.
+    bool dequeue(DebugMessage *message)
+    {
+      Slot &slot = m_slots[m_dequeuePos & (Capacity - 1)];
+      const int diff = static_cast<int>(static_cast<uint>(loadAcquire(slot.sequence)) - static_cast<uint>(m_dequeuePos + 1));
+      if (diff < 0) {
+        return false;
+      }
+      *message = slot.message;
+      slot.message = DebugMessage(); // don't keep the strings alive until the slot is reused
+      slot.sequence.fetchAndStoreRelease(m_dequeuePos + Capacity);
+      ++m_dequeuePos;
+      return true;
+    }
+
+    int takeDroppedCount()
+    {
+      return m_dropped.fetchAndStoreRelaxed(0);
+    }
+
+    /// Returns @c true if the caller is the first one since the last resetFlushPending() call, and thus has to trigger a flush.
+    bool setFlushPending()
+    {
+      return m_flushPending.testAndSetOrdered(0, 1);
+    }
+
+    void resetFlushPending()
+    {
+      m_flushPending.fetchAndStoreOrdered(0);
+    }
+
+  private:
+    static inline int loadAcquire(QAtomicInt &value)
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+      return value.loadAcquire();
+#else
+      return value.fetchAndAddAcquire(0);
+#endif
+    }
+
+    static inline int loadRelaxed(const QAtomicInt &value)
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+      return value.load();
+#else
+      return value;
+#endif
+    }
+
+    struct Slot {
+      QAtomicInt sequence;
+      DebugMessage message;
+    };
+
+    Slot m_slots[Capacity];
+    QAtomicInt m_enqueuePos;
+    int m_dequeuePos;
+    QAtomicInt m_dropped;
+    QAtomicInt m_flushPending;
+};
+}
+
+Q_GLOBAL_STATIC(MessageQueue, s_messageQueue)
+
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
 static void handleMessage(QtMsgType type, const char *rawMsg)
 #else
@@ -85,22 +197,18 @@ static void handleMessage(QtMsgType type, const QMessageLogContext &context, con
 #endif
 
   if (type == QtCriticalMsg || type == QtFatalMsg || (type == QtWarningMsg && !ProbeGuard::insideProbe())) {
-    message.backtrace = getBacktrace(50);
-    // remove trailing internal functions
-    // be a bit careful and first make sure that we find this function...
-    // TODO: go even higher until qWarning/qFatal/qDebug/... ?
-    int removeUntil = -1;
-    for (int i = 0; i < message.backtrace.size(); ++i) {
-      if (message.backtrace.at(i).contains(QLatin1String("handleMessage"))) {
-        removeUntil = i;
-        break;
-      }
-    }
-    if (removeUntil != -1) {
-      message.backtrace = message.backtrace.mid(removeUntil + 1);
+    // resolving symbols is expensive, leave that to MessageModel, which only does it when needed
+    message.backtraceAddresses = getBacktraceAddresses(50);
+    if (message.backtraceAddresses.isEmpty()) {
+      message.backtrace = stripMessageHandlerFrames(getBacktrace(50));
     }
   }
 
+  // we need the symbols right away here
+  if (!message.backtraceAddresses.isEmpty() && (type == QtFatalMsg || qgetenv("GAMMARAY_UNITTEST") == "1")) {
+    message.backtrace = stripMessageHandlerFrames(symbolizeBacktrace(message.backtraceAddresses));
+  }
+
   if (!message.backtrace.isEmpty() && (qgetenv("GAMMARAY_UNITTEST") == "1" || type == QtFatalMsg)) {
     if (type == QtFatalMsg) {
       std::cerr << "QFatal in " << qPrintable(qApp->applicationName()) << " (" << qPrintable(qApp->applicationFilePath()) << ')' << std::endl;
@@ -121,17 +229,17 @@ static void handleMessage(QtMsgType type, const QMessageLogContext &context, con
   }
 
   // reset msg handler so the app still works as usual
-  // but make sure we don't let other threads bypass our
-  // handler during that time
-  QMutexLocker lock(&s_mutex);
-  s_handlerDisabled = true;
-  if (s_handler) { // try a direct call to the previous handler first, that avoids triggering the recursion detection in Qt5
+  MessageHandlerCallback handler = s_handler;
+  if (handler) { // try a direct call to the previous handler first, that avoids triggering the recursion detection in Qt5
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-    s_handler(type, context, msg);
+    handler(type, context, msg);
 #else
-    s_handler(type, rawMsg);
+    handler(type, rawMsg);
 #endif
   } else {
+    // make sure we don't let other threads bypass our handler during that time
+    QMutexLocker lock(&s_mutex);
+    s_handlerDisabled = true;
     installMessageHandler(s_handler);
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
     qt_message_output(type, context, msg);
@@ -139,32 +247,42 @@ static void handleMessage(QtMsgType type, const QMessageLogContext &context, con
     qt_message_output(type, rawMsg);
 #endif
     installMessageHandler(handleMessage);
+    s_handlerDisabled = false;
   }
-  s_handlerDisabled = false;
-  lock.unlock();
 
-  if (s_model) {
-    // add directly from foreground thread, delay from background thread
-    QMetaObject::invokeMethod(s_model, "addMessage", Qt::AutoConnection,
-                              Q_ARG(GammaRay::DebugMessage, message));
+  MessageModel *model = s_model;
+  MessageQueue *queue = s_messageQueue();
+  if (model && queue) {
+    if (model->thread() == QThread::currentThread()) {
+      // add directly from foreground thread, after what background threads queued so far, this never drops messages
+      QMetaObject::invokeMethod(static_cast<QObject*>(model)->parent(), "addMessage", Qt::DirectConnection,
+                                Q_ARG(GammaRay::DebugMessage, message));
+    } else if (queue->enqueue(message) && queue->setFlushPending()) {
+      // only the first message of a batch posts an event, the rest is picked up along with it
+      QMetaObject::invokeMethod(static_cast<QObject*>(model)->parent(), "flushMessages", Qt::QueuedConnection);
+    }
   }
 }
 
 MessageHandler::MessageHandler(ProbeInterface *probe, QObject *parent)
   : MessageHandlerInterface(parent),
-  m_messageModel(new MessageModel(this))
+  m_messageModel(new MessageModel(this)),
+  m_messageProxyModel(0)
 {
 
   Q_ASSERT(s_model == 0);
   s_model = m_messageModel;
+  m_messageModel->setMaximumMessageCount(ProbeSettings::value(QStringLiteral("MaxMessages"), 100000).toInt());
 
   auto proxy = new ServerProxyModel<QSortFilterProxyModel>(this);
   proxy->addRole(MessageModelRole::Type);
   proxy->addRole(MessageModelRole::Line);
-  proxy->addRole(MessageModelRole::Backtrace);
+  proxy->addRole(MessageModelRole::Id);
+  // backtraces are expensive to symbolize, so they are only provided on request
   proxy->setSourceModel(m_messageModel);
   proxy->setSortRole(MessageModelRole::Sort);
   probe->registerModel(QStringLiteral("com.kdab.GammaRay.MessageModel"), proxy);
+  m_messageProxyModel = proxy;
 
   // install handler directly, catches most cases,
   // i.e. user has no special handler or the handler
@@ -203,6 +321,75 @@ void MessageHandler::ensureHandlerInstalled()
   }
 }
 
+void MessageHandler::flushMessages()
+{
+  ///WARNING: do not trigger *any* kind of debug output here
+  ///         this would trigger an infinite loop and hence crash!
+
+  MessageQueue *queue = s_messageQueue();
+  if (!queue) {
+    return;
+  }
+
+  // reset first, anything queued from now on either makes it into this batch or triggers the next one
+  queue->resetFlushPending();
+
+  m_messageModel->addMessages(takeQueuedMessages());
+}
+
+void MessageHandler::addMessage(const DebugMessage &message)
+{
+  ///WARNING: do not trigger *any* kind of debug output here
+  ///         this would trigger an infinite loop and hence crash!
+
+  QVector<DebugMessage> messages = takeQueuedMessages();
+  messages.push_back(message);
+  m_messageModel->addMessages(messages);
+}
+
+QVector<DebugMessage> MessageHandler::takeQueuedMessages()
+{
+  QVector<DebugMessage> messages;
+  MessageQueue *queue = s_messageQueue();
+  if (!queue) {
+    return messages;
+  }
+
+  DebugMessage message;
+  while (queue->dequeue(&message)) {
+    messages.push_back(message);
+  }
+
+  const int dropped = queue->takeDroppedCount();
+  if (dropped > 0) {
+    DebugMessage note;
+    note.type = QtWarningMsg;
+    note.message = tr("GammaRay dropped %n message(s), the application logged faster than they could be processed.", 0, dropped);
+    note.time = QTime::currentTime();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    note.category = 0;
+    note.file = 0;
+    note.function = 0;
+    note.line = 0;
+#endif
+    messages.push_back(note);
+  }
+
+  return messages;
+}
+
+void MessageHandler::requestBacktrace(qint64 id)
+{
+  // rows change with sorting, filtering and removal of old messages while the request is on its way
+  const int row = m_messageModel->rowForId(id);
+  if (row < 0) {
+    emit backtraceAvailable(id, QStringList());
+    return;
+  }
+  const QModelIndex index = m_messageModel->index(row, 0);
+  emit backtraceAvailable(id, index.data(MessageModelRole::Backtrace).toStringList());
+}
+
 void MessageHandler::handleFatalMessage(const DebugMessage &message)
 {
   const QString app = qApp->applicationName().isEmpty()
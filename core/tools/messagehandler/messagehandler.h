@@ -32,6 +32,10 @@
 
 #include <common/tools/messagehandler/messagehandlerinterface.h>
 
+#include <QVector>
+
+class QAbstractItemModel;
+
 namespace GammaRay {
 
 struct DebugMessage;
@@ -49,12 +53,21 @@ class MessageHandler : public MessageHandlerInterface
     explicit MessageHandler(ProbeInterface *probe, QObject *parent = 0);
     ~MessageHandler();
 
+  public slots:
+    void requestBacktrace(qint64 id) Q_DECL_OVERRIDE;
+
   private slots:
     void ensureHandlerInstalled();
+    void flushMessages();
+    void addMessage(const GammaRay::DebugMessage &message);
     void handleFatalMessage(const GammaRay::DebugMessage &message);
 
   private:
+    /// Drains the queue filled by other threads, plus a note about dropped messages if necessary.
+    QVector<DebugMessage> takeQueuedMessages();
+
     MessageModel *m_messageModel;
+    QAbstractItemModel *m_messageProxyModel;
 };
 
 class MessageHandlerFactory : public QObject, public StandardToolFactory<QObject, MessageHandler>
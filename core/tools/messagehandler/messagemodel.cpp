@@ -34,8 +34,15 @@
 
 using namespace GammaRay;
 
+static QByteArray stackKey(const BacktraceAddresses &addresses)
+{
+  return QByteArray(reinterpret_cast<const char*>(addresses.constData()), addresses.size() * sizeof(quintptr));
+}
+
 MessageModel::MessageModel(QObject *parent)
   : QAbstractTableModel(parent)
+  , m_firstMessageId(0)
+  , m_maximumMessageCount(0)
 {
   qRegisterMetaType<DebugMessage>();
 }
@@ -45,14 +52,127 @@ MessageModel::~MessageModel()
 
 }
 
-void MessageModel::addMessage(const DebugMessage &message)
+void MessageModel::addMessages(const QVector<DebugMessage> &messages)
 {
   ///WARNING: do not trigger *any* kind of debug output here
   ///         this would trigger an infinite loop and hence crash!
 
-  beginInsertRows(QModelIndex(), m_messages.count(), m_messages.count());
-  m_messages << message;
+  if (messages.isEmpty()) {
+    return;
+  }
+
+  beginInsertRows(QModelIndex(), m_messages.count(), m_messages.count() + messages.count() - 1);
+  m_messages.reserve(m_messages.count() + messages.count());
+  m_messageStacks.reserve(m_messages.count() + messages.count());
+  for (QVector<DebugMessage>::const_iterator it = messages.constBegin(); it != messages.constEnd(); ++it) {
+    m_messages.push_back(*it);
+    m_messages.last().backtraceAddresses.clear();
+    m_messageStacks.push_back(internStack(it->backtraceAddresses));
+  }
   endInsertRows();
+
+  removeOldestMessages();
+}
+
+void MessageModel::setMaximumMessageCount(int count)
+{
+  m_maximumMessageCount = qMax(0, count);
+  removeOldestMessages();
+}
+
+int MessageModel::maximumMessageCount() const
+{
+  return m_maximumMessageCount;
+}
+
+void MessageModel::removeOldestMessages()
+{
+  // removing from the front moves all remaining messages, so only do that once we are 10% over the limit
+  if (m_maximumMessageCount <= 0 || m_messages.count() <= m_maximumMessageCount + qMax(1, m_maximumMessageCount / 10)) {
+    return;
+  }
+
+  const int count = m_messages.count() - m_maximumMessageCount;
+  beginRemoveRows(QModelIndex(), 0, count - 1);
+  for (int row = 0; row < count; ++row) {
+    releaseStack(m_messageStacks.at(row));
+  }
+  m_messages.remove(0, count);
+  m_messageStacks.remove(0, count);
+  m_firstMessageId += count;
+  endRemoveRows();
+}
+
+int MessageModel::rowForId(qint64 id) const
+{
+  if (id < m_firstMessageId || id - m_firstMessageId >= m_messages.count()) {
+    return -1;
+  }
+  return static_cast<int>(id - m_firstMessageId);
+}
+
+int MessageModel::internStack(const BacktraceAddresses &addresses)
+{
+  if (addresses.isEmpty()) {
+    return -1;
+  }
+
+  const QByteArray key = stackKey(addresses);
+  const QHash<QByteArray, int>::const_iterator it = m_stackIndex.constFind(key);
+  if (it != m_stackIndex.constEnd()) {
+    ++m_stacks[it.value()].refCount;
+    return it.value();
+  }
+
+  Stack stack;
+  stack.addresses = addresses;
+  stack.refCount = 1;
+  int stackIndex;
+  if (!m_freeStacks.isEmpty()) {
+    stackIndex = m_freeStacks.last();
+    m_freeStacks.removeLast();
+    m_stacks[stackIndex] = stack;
+  } else {
+    stackIndex = m_stacks.size();
+    m_stacks.push_back(stack);
+  }
+  m_stackIndex.insert(key, stackIndex);
+  return stackIndex;
+}
+
+void MessageModel::releaseStack(int stackIndex)
+{
+  if (stackIndex < 0) {
+    return;
+  }
+
+  Stack &stack = m_stacks[stackIndex];
+  Q_ASSERT(stack.refCount > 0);
+  if (--stack.refCount > 0) {
+    return;
+  }
+  m_stackIndex.remove(stackKey(stack.addresses));
+  stack.addresses = BacktraceAddresses();
+  stack.backtrace = Backtrace();
+  m_freeStacks.push_back(stackIndex);
+}
+
+Backtrace MessageModel::backtrace(int row) const
+{
+  const DebugMessage &msg = m_messages.at(row);
+  if (!msg.backtrace.isEmpty()) {
+    return msg.backtrace;
+  }
+
+  const int stackIndex = m_messageStacks.at(row);
+  if (stackIndex < 0) {
+    return Backtrace();
+  }
+  Stack &stack = m_stacks[stackIndex];
+  if (stack.backtrace.isEmpty()) {
+    stack.backtrace = stripMessageHandlerFrames(symbolizeBacktrace(stack.addresses));
+  }
+  return stack.backtrace;
 }
 
 int MessageModel::columnCount(const QModelIndex &parent) const
@@ -114,7 +234,9 @@ QVariant MessageModel::data(const QModelIndex &index, int role) const
     return msg.line;
 #endif
   } else if (role == MessageModelRole::Backtrace && index.column() == 0) {
-    return msg.backtrace;
+    return backtrace(index.row());
+  } else if (role == MessageModelRole::Id && index.column() == 0) {
+    return m_firstMessageId + index.row();
   }
 
   return QVariant();
@@ -135,3 +257,14 @@ QVariant MessageModel::headerData(int section, Qt::Orientation orientation, int
   return QVariant();
 }
 
+Backtrace GammaRay::stripMessageHandlerFrames(const Backtrace &backtrace)
+{
+  // be a bit careful and first make sure that we find this function...
+  // TODO: go even higher until qWarning/qFatal/qDebug/... ?
+  for (int i = 0; i < backtrace.size(); ++i) {
+    if (backtrace.at(i).contains(QLatin1String("handleMessage"))) {
+      return backtrace.mid(i + 1);
+    }
+  }
+  return backtrace;
+}
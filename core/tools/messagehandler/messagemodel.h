@@ -33,6 +33,7 @@
 #include <common/tools/messagehandler/messagemodelroles.h>
 
 #include <QAbstractTableModel>
+#include <QHash>
 #include <QTime>
 #include <QVector>
 
@@ -42,7 +43,8 @@ struct DebugMessage {
   QtMsgType type;
   QString message;
   QTime time;
-  Backtrace backtrace;
+  Backtrace backtrace; // if resolved right away
+  BacktraceAddresses backtraceAddresses; // otherwise resolved on demand
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
   const char *category;
   const char *file;
@@ -53,6 +55,13 @@ struct DebugMessage {
 
 }
 
+namespace GammaRay {
+
+/** Removes the frames of our own message handler from the top of @p backtrace. */
+Backtrace stripMessageHandlerFrames(const Backtrace &backtrace);
+
+}
+
 Q_DECLARE_METATYPE(GammaRay::DebugMessage)
 Q_DECLARE_TYPEINFO(GammaRay::DebugMessage, Q_MOVABLE_TYPE);
 
@@ -71,11 +80,42 @@ class MessageModel : public QAbstractTableModel
     QVariant headerData(int section, Qt::Orientation orientation,
                         int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
 
-  public slots:
-    void addMessage(const GammaRay::DebugMessage &message);
+    /// Appends @p messages in one go, then drops the oldest ones if there are too many.
+    void addMessages(const QVector<GammaRay::DebugMessage> &messages);
+
+    /**
+     * Limits the number of retained messages, 0 means unlimited.
+     * The oldest messages are removed in chunks, so up to 10% more than that are kept at times.
+     */
+    void setMaximumMessageCount(int count);
+    int maximumMessageCount() const;
+
+    /// Returns the row of the message with MessageModelRole::Id @p id, or -1 if it has been removed.
+    int rowForId(qint64 id) const;
 
   private:
+    void removeOldestMessages();
+
+    /// Returns the index of @p addresses in m_stacks, adding it if necessary, or -1 for an empty stack.
+    int internStack(const BacktraceAddresses &addresses);
+    /// Drops a reference to the stack at @p stackIndex, freeing its slot once no message uses it anymore.
+    void releaseStack(int stackIndex);
+    Backtrace backtrace(int row) const;
+
     QVector<DebugMessage> m_messages;
+    // messages are numbered consecutively in the order they are added, so we only need the id of the first one
+    qint64 m_firstMessageId;
+    // messages in a loop tend to have the same stack, so we only store and resolve each of those once
+    struct Stack {
+      BacktraceAddresses addresses;
+      Backtrace backtrace; // resolved on first use
+      int refCount; // number of messages using this, 0 for a free slot
+    };
+    mutable QVector<Stack> m_stacks;
+    QHash<QByteArray, int> m_stackIndex;
+    QVector<int> m_freeStacks; // slots in m_stacks to reuse
+    QVector<int> m_messageStacks; // index into m_stacks per message
+    int m_maximumMessageCount;
 };
 
 }
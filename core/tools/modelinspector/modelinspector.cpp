@@ -41,6 +41,7 @@
 
 #include <3rdparty/kde/krecursivefilterproxymodel.h>
 #include <QDebug>
+#include <QTimer>
 
 using namespace GammaRay;
 
@@ -51,7 +52,8 @@ ModelInspector::ModelInspector(ProbeInterface* probe, QObject *parent) :
   m_modelContentServer(0),
   m_modelContentSelectionModel(0),
   m_safetyFilterProxyModel(0),
-  m_modelTester(0)
+  m_modelTester(0),
+  m_modelTestTimer(0)
 {
   auto modelModelSource = new ModelModel(this);
   connect(probe->probe(), SIGNAL(objectCreated(QObject*)),
@@ -76,8 +78,9 @@ ModelInspector::ModelInspector(ProbeInterface* probe, QObject *parent) :
   selectionChanged(QItemSelection());
 
   m_modelTester = new ModelTester(this);
-  connect(probe->probe(), SIGNAL(objectCreated(QObject*)),
-          m_modelTester, SLOT(objectAdded(QObject*)));
+  m_modelTestTimer = new QTimer(this);
+  m_modelTestTimer->setInterval(1000);
+  connect(m_modelTestTimer, SIGNAL(timeout()), SLOT(updateModelTestResult()));
 
   if (m_probe->needsObjectDiscovery()) {
     connect(m_probe->probe(), SIGNAL(objectCreated(QObject*)), SLOT(objectCreated(QObject*)));
@@ -100,9 +103,11 @@ void ModelInspector::modelSelected(const QItemSelection& selected)
   if (selected.size() >= 1)
     index = selected.first().topLeft();
 
+  m_selectedModel = 0;
   if (index.isValid()) {
     QObject *obj = index.data(ObjectModel::ObjectRole).value<QObject*>();
     QAbstractItemModel *model = qobject_cast<QAbstractItemModel*>(obj);
+    m_selectedModel = model;
 
     if (model->inherits("QQmlListModel")) {
       if (!m_safetyFilterProxyModel)
@@ -124,6 +129,7 @@ void ModelInspector::modelSelected(const QItemSelection& selected)
 
   // clear the cell info box
   selectionChanged(QItemSelection());
+  updateModelTestResult();
 }
 
 void ModelInspector::objectSelected(QObject* object)
@@ -163,3 +169,38 @@ void ModelInspector::objectCreated(QObject* object)
   if (auto proxy = qobject_cast<QAbstractProxyModel*>(object))
     m_probe->discoverObject(proxy->sourceModel());
 }
+
+void ModelInspector::setModelTestEnabled(bool enabled)
+{
+  if (!m_selectedModel)
+    return;
+
+  if (!enabled) {
+    m_modelTester->detach(m_selectedModel);
+  } else if (!m_modelTester->attach(m_selectedModel)) {
+    emit modelTestResult(false, tr("Models living in a different thread can't be checked."), QStringList());
+    return;
+  }
+  updateModelTestResult();
+}
+
+void ModelInspector::updateModelTestResult()
+{
+  if (!m_selectedModel || !m_modelTester->isAttached(m_selectedModel)) {
+    m_modelTestTimer->stop();
+    emit modelTestResult(false, QString(), QStringList());
+    return;
+  }
+
+  const QStringList failures = m_modelTester->failures(m_selectedModel);
+  const qint64 checkTime = m_modelTester->checkTime(m_selectedModel);
+  const qint64 attachedTime = qMax<qint64>(1, m_modelTester->attachedTime(m_selectedModel));
+  const QString summary = tr("%n failure(s), %1 changes checked in %2 ms (%3% overhead)", 0, failures.size())
+    .arg(m_modelTester->checkedChanges(m_selectedModel))
+    .arg(checkTime / 1000000)
+    .arg(100.0 * checkTime / attachedTime, 0, 'f', 2);
+  emit modelTestResult(true, summary, failures);
+
+  if (!m_modelTestTimer->isActive())
+    m_modelTestTimer->start();
+}
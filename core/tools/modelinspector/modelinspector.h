@@ -33,9 +33,12 @@
 
 #include "common/modelinspectorinterface.h"
 
+#include <QPointer>
+
 class QAbstractItemModel;
 class QItemSelection;
 class QItemSelectionModel;
+class QTimer;
 
 namespace GammaRay {
 
@@ -51,12 +54,16 @@ class ModelInspector : public ModelInspectorInterface
   public:
     explicit ModelInspector(ProbeInterface *probe, QObject *parent = 0);
 
+  public slots:
+    void setModelTestEnabled(bool enabled) Q_DECL_OVERRIDE;
+
   private slots:
     void modelSelected(const QItemSelection &selected);
     void selectionChanged(const QItemSelection &selected);
 
     void objectSelected(QObject* object);
     void objectCreated(QObject *object);
+    void updateModelTestResult();
 
   private:
     ProbeInterface *m_probe;
@@ -69,7 +76,9 @@ class ModelInspector : public ModelInspectorInterface
 
     ModelCellModel *m_cellModel;
 
+    QPointer<QAbstractItemModel> m_selectedModel;
     ModelTester *m_modelTester;
+    QTimer *m_modelTestTimer;
 };
 
 class ModelInspectorFactory : public QObject, public StandardToolFactory<QAbstractItemModel, ModelInspector>
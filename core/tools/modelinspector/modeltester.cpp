@@ -31,8 +31,13 @@
 
 #include "util.h"
 
-#include <QAbstractListModel>
+#include <QAbstractItemModel>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QPersistentModelIndex>
+#include <QSet>
+#include <QStack>
+#include <QThread>
 
 #include <iostream>
 
@@ -40,37 +45,193 @@ using namespace GammaRay;
 
 namespace GammaRay {
   struct ModelTester::ModelTestResult {
-    ModelTestResult() : modelTest(0)
+    explicit ModelTestResult(QAbstractItemModel *m) : model(m), checkedChanges(0), checkTime(0)
     {
+      attachedTimer.start();
     }
 
-    ~ModelTestResult()
+    // state before a row/column insertion or removal, to verify the change afterwards
+    struct Change {
+      QPersistentModelIndex parent;
+      int oldSize;
+      QVariant last;
+      QVariant next;
+    };
+
+    // state before rows or columns are moved
+    struct Move {
+      QPersistentModelIndex sourceParent;
+      QPersistentModelIndex destinationParent;
+      int oldSourceSize;
+      int oldDestinationSize;
+      QVariant first;
+    };
+
+    QAbstractItemModel *model;
+    QStack<Change> insertedRows;
+    QStack<Change> removedRows;
+    QStack<Change> insertedColumns;
+    QStack<Change> removedColumns;
+    QStack<Move> movedRows;
+    QStack<Move> movedColumns;
+    QList<QPersistentModelIndex> layoutChanging;
+
+    QStringList failures;
+    QSet<int> failedChecks;
+
+    int checkedChanges;
+    qint64 checkTime;
+    QElapsedTimer attachedTimer;
+  };
+}
+
+namespace {
+/** Accounts the time spent in its scope to the overhead of checking a model. */
+class CheckTimer
+{
+  public:
+    CheckTimer(qint64 *total, int *changes, bool isChange) : m_total(total)
     {
-      delete modelTest;
+      if (isChange) {
+        ++(*changes);
+      }
+      m_timer.start();
     }
 
-    ModelTest *modelTest;
-    QHash<int, QString> failures;
-  };
+    ~CheckTimer()
+    {
+      *m_total += m_timer.nsecsElapsed();
+    }
+
+  private:
+    qint64 *m_total;
+    QElapsedTimer m_timer;
+};
 }
 
+// rows checked on each change, so huge inserts or resets don't stall the application
+static const int MaxCheckedRows = 50;
+static const int MaxCheckedColumns = 16;
+
+static void addFailure(QAbstractItemModel *model, QStringList &failures, QSet<int> &failedChecks, int line, const char *message)
+{
+  ///TODO: track file
+  if (failedChecks.contains(line)) {
+    return;
+  }
+  std::cout << qPrintable(Util::displayString(model)) << " "
+            << line << " " << message << std::endl;
+  failedChecks.insert(line);
+  failures.push_back(QString::fromLatin1(message));
+}
+
+#define MODELTESTER_VERIFY(result, condition) \
+  (!(condition) ? addFailure(result->model, result->failures, result->failedChecks, __LINE__, #condition) : qt_noop())
+
+#define MODELTESTER_CHECK_SCOPE(result, isChange) \
+  CheckTimer checkTimer(&result->checkTime, &result->checkedChanges, isChange); \
+  Q_UNUSED(checkTimer)
+
 ModelTester::ModelTester(QObject *parent) : QObject(parent)
 {
 }
 
-void ModelTester::objectAdded(QObject *obj)
+ModelTester::~ModelTester()
 {
-  QAbstractItemModel *model = qobject_cast<QAbstractItemModel*>(obj);
-  if (model) {
-    // TODO filter out our own models, way too slow otherwise
-    // or even better allow to specify somehow to which models we want to attach
-    connect(model, SIGNAL(destroyed(QObject*)), SLOT(modelDestroyed(QObject*)));
-    ModelTestResult *result = new ModelTestResult;
-    m_modelTestMap.insert(model, result); // needs to be available for the
-                                          // initial calls to failure() already
-    // FIXME too slow!
-//     result->modelTest = new ModelTest(model, this);
+  qDeleteAll(m_modelTestMap);
+}
+
+bool ModelTester::attach(QAbstractItemModel *model)
+{
+  if (!model) {
+    return false;
+  }
+  if (m_modelTestMap.contains(model)) {
+    return true;
   }
+  // the checks need to run synchronously with the changes, which we can't do for models in other threads
+  if (model->thread() != thread()) {
+    return false;
+  }
+
+  ModelTestResult *result = new ModelTestResult(model);
+  m_modelTestMap.insert(model, result);
+
+  connect(model, SIGNAL(destroyed(QObject*)), SLOT(modelDestroyed(QObject*)));
+  connect(model, SIGNAL(rowsAboutToBeInserted(QModelIndex,int,int)),
+          SLOT(rowsAboutToBeInserted(QModelIndex,int,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+          SLOT(rowsInserted(QModelIndex,int,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+          SLOT(rowsAboutToBeRemoved(QModelIndex,int,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+          SLOT(rowsRemoved(QModelIndex,int,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(columnsAboutToBeInserted(QModelIndex,int,int)),
+          SLOT(columnsAboutToBeInserted(QModelIndex,int,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(columnsInserted(QModelIndex,int,int)),
+          SLOT(columnsInserted(QModelIndex,int,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(columnsAboutToBeRemoved(QModelIndex,int,int)),
+          SLOT(columnsAboutToBeRemoved(QModelIndex,int,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(columnsRemoved(QModelIndex,int,int)),
+          SLOT(columnsRemoved(QModelIndex,int,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(rowsAboutToBeMoved(QModelIndex,int,int,QModelIndex,int)),
+          SLOT(rowsAboutToBeMoved(QModelIndex,int,int,QModelIndex,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+          SLOT(rowsMoved(QModelIndex,int,int,QModelIndex,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(columnsAboutToBeMoved(QModelIndex,int,int,QModelIndex,int)),
+          SLOT(columnsAboutToBeMoved(QModelIndex,int,int,QModelIndex,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(columnsMoved(QModelIndex,int,int,QModelIndex,int)),
+          SLOT(columnsMoved(QModelIndex,int,int,QModelIndex,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+          SLOT(dataChanged(QModelIndex,QModelIndex)), Qt::DirectConnection);
+  connect(model, SIGNAL(headerDataChanged(Qt::Orientation,int,int)),
+          SLOT(headerDataChanged(Qt::Orientation,int,int)), Qt::DirectConnection);
+  connect(model, SIGNAL(layoutAboutToBeChanged()), SLOT(layoutAboutToBeChanged()), Qt::DirectConnection);
+  connect(model, SIGNAL(layoutChanged()), SLOT(layoutChanged()), Qt::DirectConnection);
+  connect(model, SIGNAL(modelAboutToBeReset()), SLOT(modelAboutToBeReset()), Qt::DirectConnection);
+  connect(model, SIGNAL(modelReset()), SLOT(modelReset()), Qt::DirectConnection);
+
+  MODELTESTER_CHECK_SCOPE(result, false);
+  checkRows(result, QModelIndex(), 0, model->rowCount() - 1);
+  return true;
+}
+
+void ModelTester::detach(QAbstractItemModel *model)
+{
+  if (!m_modelTestMap.contains(model)) {
+    return;
+  }
+  disconnect(model, 0, this, 0);
+  delete m_modelTestMap.take(model);
+}
+
+bool ModelTester::isAttached(QAbstractItemModel *model) const
+{
+  return m_modelTestMap.contains(model);
+}
+
+QStringList ModelTester::failures(QAbstractItemModel *model) const
+{
+  const ModelTestResult *result = m_modelTestMap.value(model);
+  return result ? result->failures : QStringList();
+}
+
+int ModelTester::checkedChanges(QAbstractItemModel *model) const
+{
+  const ModelTestResult *result = m_modelTestMap.value(model);
+  return result ? result->checkedChanges : 0;
+}
+
+qint64 ModelTester::checkTime(QAbstractItemModel *model) const
+{
+  const ModelTestResult *result = m_modelTestMap.value(model);
+  return result ? result->checkTime : 0;
+}
+
+qint64 ModelTester::attachedTime(QAbstractItemModel *model) const
+{
+  const ModelTestResult *result = m_modelTestMap.value(model);
+  return result ? result->attachedTimer.nsecsElapsed() : 0;
 }
 
 void ModelTester::modelDestroyed(QObject *model)
@@ -88,16 +249,478 @@ void ModelTester::failure(QAbstractItemModel *model, const char *file, int line,
   if (!result) {
     // one of our own models
     qt_assert(message, file, line);
+    return;
   }
 
-  ///TODO: track file
-  if (!result->failures.contains(line)) {
-    std::cout << qPrintable(Util::displayString(model)) << " "
-              << line << " " << message << std::endl;
-    result->failures.insert(line, QString::fromLatin1(message));
+  addFailure(model, result->failures, result->failedChecks, line, message);
+}
+
+ModelTester::ModelTestResult *ModelTester::resultForSender() const
+{
+  // the model might have been moved to another thread after we attached
+  if (QThread::currentThread() != thread()) {
+    return 0;
+  }
+  return m_modelTestMap.value(static_cast<QAbstractItemModel*>(sender()));
+}
+
+void ModelTester::checkIndex(ModelTestResult *result, const QModelIndex &parent, int row, int column)
+{
+  QAbstractItemModel *model = result->model;
+  const QModelIndex idx = model->index(row, column, parent);
+  MODELTESTER_VERIFY(result, idx.isValid());
+  if (!idx.isValid()) {
+    return;
+  }
+  MODELTESTER_VERIFY(result, idx.model() == model);
+  MODELTESTER_VERIFY(result, idx.row() == row);
+  MODELTESTER_VERIFY(result, idx.column() == column);
+  MODELTESTER_VERIFY(result, model->hasIndex(row, column, parent));
+  MODELTESTER_VERIFY(result, model->index(row, column, parent) == idx);
+  MODELTESTER_VERIFY(result, model->parent(idx) == parent);
+  MODELTESTER_VERIFY(result, idx.sibling(row, 0) == model->index(row, 0, parent));
+
+  if (column == 0) {
+    const int rows = model->rowCount(idx);
+    MODELTESTER_VERIFY(result, rows >= 0);
+    if (rows > 0 && model->columnCount(idx) > 0) {
+      MODELTESTER_VERIFY(result, model->hasChildren(idx));
+    }
+  }
+
+  model->flags(idx);
+  model->data(idx, Qt::DisplayRole);
+
+  const QVariant alignment = model->data(idx, Qt::TextAlignmentRole);
+  if (alignment.isValid()) {
+    const int value = alignment.toInt();
+    MODELTESTER_VERIFY(result, value == (value & static_cast<int>(Qt::AlignHorizontal_Mask | Qt::AlignVertical_Mask)));
+  }
+
+  const QVariant checkState = model->data(idx, Qt::CheckStateRole);
+  if (checkState.isValid()) {
+    const int state = checkState.toInt();
+    MODELTESTER_VERIFY(result, state == Qt::Unchecked || state == Qt::PartiallyChecked || state == Qt::Checked);
+  }
+}
+
+void ModelTester::checkRows(ModelTestResult *result, const QModelIndex &parent, int first, int last)
+{
+  QAbstractItemModel *model = result->model;
+  const int rows = model->rowCount(parent);
+  const int columns = model->columnCount(parent);
+  MODELTESTER_VERIFY(result, rows >= 0);
+  MODELTESTER_VERIFY(result, columns >= 0);
+  MODELTESTER_VERIFY(result, !model->index(rows, 0, parent).isValid());
+  MODELTESTER_VERIFY(result, !model->index(0, columns, parent).isValid());
+  if (first > last || columns <= 0) {
+    return;
+  }
+
+  // the beginning and the end of larger ranges is where off-by-one errors show
+  const int headEnd = qMin(last, first + MaxCheckedRows / 2 - 1);
+  const int tailBegin = qMax(headEnd + 1, last - MaxCheckedRows / 2 + 1);
+  for (int row = first; row <= last; row = (row == headEnd ? tailBegin : row + 1)) {
+    for (int column = 0; column < qMin(columns, MaxCheckedColumns); ++column) {
+      checkIndex(result, parent, row, column);
+    }
+  }
+}
+
+void ModelTester::rowsAboutToBeInserted(const QModelIndex &parent, int start, int end)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, false);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, start >= 0);
+  MODELTESTER_VERIFY(result, start <= end);
+  MODELTESTER_VERIFY(result, start <= model->rowCount(parent));
+
+  ModelTestResult::Change c;
+  c.parent = parent;
+  c.oldSize = model->rowCount(parent);
+  c.last = model->data(model->index(start - 1, 0, parent));
+  c.next = model->data(model->index(start, 0, parent));
+  result->insertedRows.push(c);
+}
+
+void ModelTester::rowsInserted(const QModelIndex &parent, int start, int end)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, true);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, !result->insertedRows.isEmpty());
+  if (result->insertedRows.isEmpty()) {
+    return;
+  }
+  const ModelTestResult::Change c = result->insertedRows.pop();
+  MODELTESTER_VERIFY(result, c.parent == parent);
+  MODELTESTER_VERIFY(result, c.oldSize + (end - start + 1) == model->rowCount(parent));
+  MODELTESTER_VERIFY(result, c.last == model->data(model->index(start - 1, 0, parent)));
+  MODELTESTER_VERIFY(result, c.next == model->data(model->index(end + 1, 0, parent)));
+
+  checkRows(result, parent, start, end);
+}
+
+void ModelTester::rowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, false);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, start >= 0);
+  MODELTESTER_VERIFY(result, start <= end);
+  MODELTESTER_VERIFY(result, end < model->rowCount(parent));
+
+  ModelTestResult::Change c;
+  c.parent = parent;
+  c.oldSize = model->rowCount(parent);
+  c.last = model->data(model->index(start - 1, 0, parent));
+  c.next = model->data(model->index(end + 1, 0, parent));
+  result->removedRows.push(c);
+}
+
+void ModelTester::rowsRemoved(const QModelIndex &parent, int start, int end)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, true);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, !result->removedRows.isEmpty());
+  if (result->removedRows.isEmpty()) {
+    return;
+  }
+  const ModelTestResult::Change c = result->removedRows.pop();
+  MODELTESTER_VERIFY(result, c.parent == parent);
+  MODELTESTER_VERIFY(result, c.oldSize - (end - start + 1) == model->rowCount(parent));
+  MODELTESTER_VERIFY(result, c.last == model->data(model->index(start - 1, 0, parent)));
+  MODELTESTER_VERIFY(result, c.next == model->data(model->index(start, 0, parent)));
+
+  // the rows around the removed range have new neighbors now
+  checkRows(result, parent, qMax(0, start - 1), qMin(start, model->rowCount(parent) - 1));
+}
+
+void ModelTester::columnsAboutToBeInserted(const QModelIndex &parent, int start, int end)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
   }
+  MODELTESTER_CHECK_SCOPE(result, false);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, start >= 0);
+  MODELTESTER_VERIFY(result, start <= end);
+  MODELTESTER_VERIFY(result, start <= model->columnCount(parent));
+
+  ModelTestResult::Change c;
+  c.parent = parent;
+  c.oldSize = model->columnCount(parent);
+  result->insertedColumns.push(c);
+}
+
+void ModelTester::columnsInserted(const QModelIndex &parent, int start, int end)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, true);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, !result->insertedColumns.isEmpty());
+  if (result->insertedColumns.isEmpty()) {
+    return;
+  }
+  const ModelTestResult::Change c = result->insertedColumns.pop();
+  MODELTESTER_VERIFY(result, c.parent == parent);
+  MODELTESTER_VERIFY(result, c.oldSize + (end - start + 1) == model->columnCount(parent));
+
+  checkRows(result, parent, 0, model->rowCount(parent) - 1);
 }
 
+void ModelTester::columnsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, false);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, start >= 0);
+  MODELTESTER_VERIFY(result, start <= end);
+  MODELTESTER_VERIFY(result, end < model->columnCount(parent));
+
+  ModelTestResult::Change c;
+  c.parent = parent;
+  c.oldSize = model->columnCount(parent);
+  result->removedColumns.push(c);
+}
+
+void ModelTester::columnsRemoved(const QModelIndex &parent, int start, int end)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, true);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, !result->removedColumns.isEmpty());
+  if (result->removedColumns.isEmpty()) {
+    return;
+  }
+  const ModelTestResult::Change c = result->removedColumns.pop();
+  MODELTESTER_VERIFY(result, c.parent == parent);
+  MODELTESTER_VERIFY(result, c.oldSize - (end - start + 1) == model->columnCount(parent));
+
+  checkRows(result, parent, 0, model->rowCount(parent) - 1);
+}
+
+void ModelTester::rowsAboutToBeMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                                     const QModelIndex &destinationParent, int destinationRow)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, false);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, sourceStart >= 0);
+  MODELTESTER_VERIFY(result, sourceStart <= sourceEnd);
+  MODELTESTER_VERIFY(result, sourceEnd < model->rowCount(sourceParent));
+  MODELTESTER_VERIFY(result, destinationRow >= 0);
+  MODELTESTER_VERIFY(result, destinationRow <= model->rowCount(destinationParent));
+  if (sourceParent == destinationParent) {
+    MODELTESTER_VERIFY(result, destinationRow < sourceStart || destinationRow > sourceEnd + 1);
+  }
+
+  ModelTestResult::Move m;
+  m.sourceParent = sourceParent;
+  m.destinationParent = destinationParent;
+  m.oldSourceSize = model->rowCount(sourceParent);
+  m.oldDestinationSize = model->rowCount(destinationParent);
+  m.first = model->data(model->index(sourceStart, 0, sourceParent));
+  result->movedRows.push(m);
+}
+
+void ModelTester::rowsMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                            const QModelIndex &destinationParent, int destinationRow)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, true);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, !result->movedRows.isEmpty());
+  if (result->movedRows.isEmpty()) {
+    return;
+  }
+  const ModelTestResult::Move m = result->movedRows.pop();
+  MODELTESTER_VERIFY(result, m.sourceParent == sourceParent);
+  MODELTESTER_VERIFY(result, m.destinationParent == destinationParent);
+
+  const int count = sourceEnd - sourceStart + 1;
+  int newStart = destinationRow;
+  if (sourceParent == destinationParent) {
+    MODELTESTER_VERIFY(result, m.oldSourceSize == model->rowCount(sourceParent));
+    if (destinationRow > sourceEnd) {
+      newStart -= count;
+    }
+  } else {
+    MODELTESTER_VERIFY(result, m.oldSourceSize - count == model->rowCount(sourceParent));
+    MODELTESTER_VERIFY(result, m.oldDestinationSize + count == model->rowCount(destinationParent));
+  }
+  MODELTESTER_VERIFY(result, m.first == model->data(model->index(newStart, 0, destinationParent)));
+
+  checkRows(result, destinationParent, newStart, qMin(newStart + count, model->rowCount(destinationParent)) - 1);
+}
+
+void ModelTester::columnsAboutToBeMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                                        const QModelIndex &destinationParent, int destinationColumn)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, false);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, sourceStart >= 0);
+  MODELTESTER_VERIFY(result, sourceStart <= sourceEnd);
+  MODELTESTER_VERIFY(result, sourceEnd < model->columnCount(sourceParent));
+  MODELTESTER_VERIFY(result, destinationColumn >= 0);
+  MODELTESTER_VERIFY(result, destinationColumn <= model->columnCount(destinationParent));
+  if (sourceParent == destinationParent) {
+    MODELTESTER_VERIFY(result, destinationColumn < sourceStart || destinationColumn > sourceEnd + 1);
+  }
+
+  ModelTestResult::Move m;
+  m.sourceParent = sourceParent;
+  m.destinationParent = destinationParent;
+  m.oldSourceSize = model->columnCount(sourceParent);
+  m.oldDestinationSize = model->columnCount(destinationParent);
+  result->movedColumns.push(m);
+}
+
+void ModelTester::columnsMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                               const QModelIndex &destinationParent, int destinationColumn)
+{
+  Q_UNUSED(destinationColumn);
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, true);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, !result->movedColumns.isEmpty());
+  if (result->movedColumns.isEmpty()) {
+    return;
+  }
+  const ModelTestResult::Move m = result->movedColumns.pop();
+  MODELTESTER_VERIFY(result, m.sourceParent == sourceParent);
+  MODELTESTER_VERIFY(result, m.destinationParent == destinationParent);
+
+  const int count = sourceEnd - sourceStart + 1;
+  if (sourceParent == destinationParent) {
+    MODELTESTER_VERIFY(result, m.oldSourceSize == model->columnCount(sourceParent));
+  } else {
+    MODELTESTER_VERIFY(result, m.oldSourceSize - count == model->columnCount(sourceParent));
+    MODELTESTER_VERIFY(result, m.oldDestinationSize + count == model->columnCount(destinationParent));
+  }
+
+  checkRows(result, destinationParent, 0, model->rowCount(destinationParent) - 1);
+}
+
+void ModelTester::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, true);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, topLeft.isValid());
+  MODELTESTER_VERIFY(result, bottomRight.isValid());
+  if (!topLeft.isValid() || !bottomRight.isValid()) {
+    return;
+  }
+  const QModelIndex commonParent = bottomRight.parent();
+  MODELTESTER_VERIFY(result, topLeft.parent() == commonParent);
+  MODELTESTER_VERIFY(result, topLeft.row() <= bottomRight.row());
+  MODELTESTER_VERIFY(result, topLeft.column() <= bottomRight.column());
+  MODELTESTER_VERIFY(result, bottomRight.row() < model->rowCount(commonParent));
+  MODELTESTER_VERIFY(result, bottomRight.column() < model->columnCount(commonParent));
+
+  checkRows(result, commonParent, topLeft.row(), qMin(bottomRight.row(), model->rowCount(commonParent) - 1));
+}
+
+void ModelTester::headerDataChanged(Qt::Orientation orientation, int start, int end)
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, true);
+  QAbstractItemModel *model = result->model;
+
+  MODELTESTER_VERIFY(result, start >= 0);
+  MODELTESTER_VERIFY(result, end >= 0);
+  MODELTESTER_VERIFY(result, start <= end);
+  const int itemCount = orientation == Qt::Vertical ? model->rowCount() : model->columnCount();
+  MODELTESTER_VERIFY(result, start < itemCount);
+  MODELTESTER_VERIFY(result, end < itemCount);
+}
+
+void ModelTester::layoutAboutToBeChanged()
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, false);
+  QAbstractItemModel *model = result->model;
+
+  // a sample is enough to catch models not updating their persistent indexes
+  result->layoutChanging.clear();
+  for (int i = 0; i < qBound(0, model->rowCount(), MaxCheckedRows); ++i) {
+    result->layoutChanging.append(QPersistentModelIndex(model->index(i, 0)));
+  }
+}
+
+void ModelTester::layoutChanged()
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, true);
+  QAbstractItemModel *model = result->model;
+
+  foreach (const QPersistentModelIndex &p, result->layoutChanging) {
+    MODELTESTER_VERIFY(result, p == model->index(p.row(), p.column(), p.parent()));
+  }
+  result->layoutChanging.clear();
+
+  checkRows(result, QModelIndex(), 0, model->rowCount() - 1);
+}
+
+void ModelTester::modelAboutToBeReset()
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, false);
+
+  // resets are allowed in the middle of nothing else
+  MODELTESTER_VERIFY(result, result->insertedRows.isEmpty() && result->removedRows.isEmpty());
+  MODELTESTER_VERIFY(result, result->insertedColumns.isEmpty() && result->removedColumns.isEmpty());
+  MODELTESTER_VERIFY(result, result->movedRows.isEmpty() && result->movedColumns.isEmpty());
+}
+
+void ModelTester::modelReset()
+{
+  ModelTestResult *result = resultForSender();
+  if (!result) {
+    return;
+  }
+  MODELTESTER_CHECK_SCOPE(result, true);
+
+  result->insertedRows.clear();
+  result->removedRows.clear();
+  result->insertedColumns.clear();
+  result->removedColumns.clear();
+  result->movedRows.clear();
+  result->movedColumns.clear();
+  result->layoutChanging.clear();
+
+  checkRows(result, QModelIndex(), 0, result->model->rowCount() - 1);
+}
+
+#undef MODELTESTER_CHECK_SCOPE
+#undef MODELTESTER_VERIFY
+
 // inplace build of modeltest, with some slight modificatins:
 // - change QVERIFY to non-fatal reporting
 // - suppress qDebug etc, since those trigger qobject creating and thus
@@ -30,30 +30,75 @@
 #define GAMMARAY_MODELINSPECTOR_MODELTESTER_H
 
 #include <QHash>
+#include <QModelIndex>
 #include <QObject>
-#include <QPointer>
+#include <QStringList>
 
 class QAbstractItemModel;
 class ModelTest;
 
 namespace GammaRay {
 
+/**
+ * Consistency checks for models the user explicitly asked for.
+ * Unlike ModelTest, this only looks at the rows affected by a change rather than
+ * walking the entire model on every signal, so it can stay attached to large models.
+ */
 class ModelTester : public QObject
 {
   Q_OBJECT
   public:
     explicit ModelTester(QObject *parent = 0);
+    ~ModelTester();
+
+    /** Starts checking @p model, returns @c false if that isn't possible as it lives in a different thread. */
+    bool attach(QAbstractItemModel *model);
+    void detach(QAbstractItemModel *model);
+    bool isAttached(QAbstractItemModel *model) const;
+
+    /** Failures found in @p model so far, in the order they were found. */
+    QStringList failures(QAbstractItemModel *model) const;
+    /** Number of changes of @p model checked so far. */
+    int checkedChanges(QAbstractItemModel *model) const;
+    /** Time spent on checking @p model so far, in nanoseconds. */
+    qint64 checkTime(QAbstractItemModel *model) const;
+    /** Time since checking @p model was started, in nanoseconds. */
+    qint64 attachedTime(QAbstractItemModel *model) const;
 
     void failure(QAbstractItemModel *model, const char *file, int line, const char *message);
 
-  public slots:
-    void objectAdded(QObject *obj);
-
   private slots:
     void modelDestroyed(QObject *model);
 
+    void rowsAboutToBeInserted(const QModelIndex &parent, int start, int end);
+    void rowsInserted(const QModelIndex &parent, int start, int end);
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int start, int end);
+    void rowsRemoved(const QModelIndex &parent, int start, int end);
+    void columnsAboutToBeInserted(const QModelIndex &parent, int start, int end);
+    void columnsInserted(const QModelIndex &parent, int start, int end);
+    void columnsAboutToBeRemoved(const QModelIndex &parent, int start, int end);
+    void columnsRemoved(const QModelIndex &parent, int start, int end);
+    void rowsAboutToBeMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                            const QModelIndex &destinationParent, int destinationRow);
+    void rowsMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                   const QModelIndex &destinationParent, int destinationRow);
+    void columnsAboutToBeMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                               const QModelIndex &destinationParent, int destinationColumn);
+    void columnsMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                      const QModelIndex &destinationParent, int destinationColumn);
+    void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void headerDataChanged(Qt::Orientation orientation, int start, int end);
+    void layoutAboutToBeChanged();
+    void layoutChanged();
+    void modelAboutToBeReset();
+    void modelReset();
+
   private:
     struct ModelTestResult;
+    ModelTestResult *resultForSender() const;
+    void checkRows(ModelTestResult *result, const QModelIndex &parent, int first, int last);
+    void checkIndex(ModelTestResult *result, const QModelIndex &parent, int row, int column);
+
     QHash<QAbstractItemModel*, ModelTestResult*> m_modelTestMap;
 };
 
@@ -31,12 +31,12 @@
 #include "textdocumentformatmodel.h"
 #include "textdocumentmodel.h"
 
-#include "objecttypefilterproxymodel.h"
 #include "probeinterface.h"
 
 #include "common/objectbroker.h"
 
 #include <QItemSelection>
+#include <QStringList>
 #include <QTextDocument>
 
 using namespace GammaRay;
@@ -44,9 +44,7 @@ using namespace GammaRay;
 TextDocumentInspector::TextDocumentInspector(ProbeInterface *probe, QObject *parent):
   QObject(parent)
 {
-  ObjectTypeFilterProxyModel<QTextDocument> *documentFilter =
-    new ObjectTypeFilterProxyModel<QTextDocument>(this);
-  documentFilter->setSourceModel(probe->objectListModel());
+  QAbstractItemModel *documentFilter = probe->objectTypeModel(QStringList() << QStringLiteral("QTextDocument"));
   probe->registerModel(QStringLiteral("com.kdab.GammaRay.TextDocumentsModel"), documentFilter);
 
   QItemSelectionModel *selectionModel = ObjectBroker::selectionModel(documentFilter);
@@ -334,3 +334,22 @@ int Util::signalIndexToMethodIndex(const QMetaObject* metaObject, int signalInde
   return -1;
 #endif
 }
+
+const QMetaObject *Util::firstStaticMetaObject(const QObject *object)
+{
+#ifdef HAVE_PRIVATE_QT_HEADERS
+  const QMetaObject *mo = object->metaObject();
+  // the per-instance one is not necessarily flagged as dynamic
+  if (QObjectPrivate::get(const_cast<QObject*>(object))->metaObject && mo->superClass()) {
+    mo = mo->superClass();
+  }
+  // QML adds one per level of types defined in QML on top of the C++ type
+  while (mo->superClass() && (QMetaObjectPrivate::get(mo)->flags & DynamicMetaObject)) {
+    mo = mo->superClass();
+  }
+  return mo;
+#else
+  Q_UNUSED(object);
+  return 0;
+#endif
+}
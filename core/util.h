@@ -171,6 +171,17 @@ namespace Util {
    * @since 2.2
    */
   GAMMARAY_CORE_EXPORT int signalIndexToMethodIndex(const QMetaObject* metaObject, int signalIndex);
+
+  /**
+   * Returns the first meta object in the class hierarchy of @p object that has been generated
+   * by moc, skipping dynamic meta objects created at runtime, e.g. for QML types.
+   * Dynamic meta objects can exist per instance, and their address can be reused for unrelated
+   * types later on, so only the returned one is suitable for caching information per meta object.
+   *
+   * @return @c 0 if dynamic meta objects cannot be recognized, as private Qt headers are not available.
+   * @since 2.5
+   */
+  GAMMARAY_CORE_EXPORT const QMetaObject *firstStaticMetaObject(const QObject *object);
 }
 
 }
@@ -37,6 +37,7 @@
 
 #include <common/endpoint.h>
 #include <common/message.h>
+#include <common/sharedprobesettings.h>
 
 #include <QByteArray>
 #include <QCoreApplication>
@@ -44,6 +45,7 @@
 #include <QFileInfo>
 #include <QLocalServer>
 #include <QLocalSocket>
+#include <QSharedMemory>
 #include <QUrl>
 
 #include <iostream>
@@ -64,6 +66,7 @@ struct LauncherPrivate
     options(options),
     server(Q_NULLPTR),
     socket(Q_NULLPTR),
+    settingsMemory(Q_NULLPTR),
     state(Initial),
     exitCode(0)
   {}
@@ -83,6 +86,8 @@ struct LauncherPrivate
   LaunchOptions options;
   QLocalServer *server;
   QLocalSocket *socket;
+  QSharedMemory *settingsMemory;
+  QByteArray settingsNonce; // only known to processes we launch
   ClientLauncher client;
   QTimer safetyTimer;
   AbstractInjector::Ptr injector;
@@ -202,6 +207,8 @@ void Launcher::sendLauncherId()
   // if we are launching a new process, make sure it knows how to talk to us
   if (d->options.isLaunch()) {
       d->options.setProbeSetting(QStringLiteral("LAUNCHER_ID"), instanceIdentifier());
+      d->settingsNonce = SharedProbeSettings::createNonce();
+      d->options.setProbeSetting(QStringLiteral("SETTINGS_NONCE"), QString::fromLatin1(d->settingsNonce));
   }
 }
 
@@ -214,6 +221,16 @@ void Launcher::setupProbeSettingsServer()
     d->server->removeServer(serverName);
     if (!d->server->listen(serverName))
         qWarning() << "Unable to send probe settings:" << d->server->errorString();
+
+    // lets the probe read the settings without waiting for the above connection, only
+    // possible for launched processes, attached ones can't receive the nonce
+    if (d->settingsNonce.isEmpty())
+        return;
+    d->settingsMemory = new QSharedMemory(SharedProbeSettings::key(instanceIdentifier()), this);
+    if (!SharedProbeSettings::publish(d->settingsMemory, d->settingsNonce, d->options.probeSettings())) {
+        delete d->settingsMemory;
+        d->settingsMemory = Q_NULLPTR;
+    }
 }
 
 void Launcher::startClient(const QUrl& serverAddress)
@@ -36,6 +36,7 @@
 #include "probefinder.h"
 
 #include <common/paths.h>
+#include <common/pluginindex.h>
 #include <launcher/probeabi.h>
 #include <launcher/probeabidetector.h>
 
@@ -112,6 +113,7 @@ static void usage(const char *argv0)
   out << "     --list-probes          \tlist all installed probes" << endl;
   out << "     --probe <abi>          \tspecify which probe to use" << endl;
   out << "     --connect <host>[:port]\tconnect to an already injected target" << endl;
+  out << "     --update-plugin-index <dir>\tregenerate the plugin meta-data index of <dir>" << endl;
   out << " -h, --help                 \tprint program help and exit" << endl;
   out << " -v, --version              \tprint program version and exit" << endl;
 #ifdef HAVE_QT_WIDGETS
@@ -218,6 +220,11 @@ int main(int argc, char **argv)
         out << abi.id() << " (" << abi.displayString() << ")" << endl;
       return 0;
     }
+    if ( arg == QLatin1String("--update-plugin-index") && !args.isEmpty()) {
+      PluginIndex index(args.takeFirst());
+      index.update();
+      return index.save() ? 0 : 1;
+    }
     if ( arg == QLatin1String("--probe") && !args.isEmpty()) {
       const ProbeABI abi = ProbeABI::fromString(args.takeFirst());
       if (!abi.isValid()) {
@@ -44,7 +44,20 @@ ProbeABIDetector::ProbeABIDetector()
 
 ProbeABI ProbeABIDetector::abiForExecutable(const QString &path) const
 {
-  return abiForQtCore(qtCoreForExecutable(path));
+  const QFileInfo fi(path);
+  if (!fi.exists())
+    return abiForQtCore(qtCoreForExecutable(path));
+
+  const QString key = fi.canonicalFilePath();
+  const QHash<QString, QtCoreCacheEntry>::const_iterator it = m_qtCoreForExecutableCache.constFind(key);
+  if (it != m_qtCoreForExecutableCache.constEnd() && it.value().lastModified == fi.lastModified())
+    return abiForQtCore(it.value().qtCorePath);
+
+  QtCoreCacheEntry entry;
+  entry.lastModified = fi.lastModified();
+  entry.qtCorePath = qtCoreForExecutable(path);
+  m_qtCoreForExecutableCache.insert(key, entry);
+  return abiForQtCore(entry.qtCorePath);
 }
 
 ProbeABI ProbeABIDetector::abiForProcess(qint64 pid) const
@@ -58,13 +71,15 @@ ProbeABI ProbeABIDetector::abiForQtCore(const QString& path) const
   if (!fi.exists())
     return ProbeABI();
 
-  const QHash<QString, ProbeABI>::const_iterator it = m_abiForQtCoreCache.constFind(fi.canonicalFilePath());
-  if (it != m_abiForQtCoreCache.constEnd())
-    return it.value();
+  const QHash<QString, AbiCacheEntry>::const_iterator it = m_abiForQtCoreCache.constFind(fi.canonicalFilePath());
+  if (it != m_abiForQtCoreCache.constEnd() && it.value().lastModified == fi.lastModified())
+    return it.value().abi;
 
-  const ProbeABI abi = detectAbiForQtCore(fi.canonicalFilePath());
-  m_abiForQtCoreCache.insert(fi.canonicalFilePath(), abi);
-  return abi;
+  AbiCacheEntry entry;
+  entry.lastModified = fi.lastModified();
+  entry.abi = detectAbiForQtCore(fi.canonicalFilePath());
+  m_abiForQtCoreCache.insert(fi.canonicalFilePath(), entry);
+  return entry.abi;
 }
 
 QString ProbeABIDetector::qtCoreFromLsof(qint64 pid) const
@@ -33,6 +33,7 @@
 
 #include "probeabi.h"
 
+#include <QDateTime>
 #include <QHash>
 #include <QString>
 
@@ -79,7 +80,19 @@ private:
      */
     QString qtCoreFromLsof(qint64 pid) const;
 
-    mutable QHash<QString, ProbeABI> m_abiForQtCoreCache;
+    /** Cached results, only valid as long as the file at the path used as key
+     *  has the same modification time.
+     */
+    struct QtCoreCacheEntry {
+      QDateTime lastModified;
+      QString qtCorePath;
+    };
+    struct AbiCacheEntry {
+      QDateTime lastModified;
+      ProbeABI abi;
+    };
+    mutable QHash<QString, QtCoreCacheEntry> m_qtCoreForExecutableCache;
+    mutable QHash<QString, AbiCacheEntry> m_abiForQtCoreCache;
 };
 
 }
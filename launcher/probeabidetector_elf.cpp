@@ -32,10 +32,16 @@
 #include "probeabi.h"
 
 #include <QDebug>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
 #include <QProcess>
+#include <QQueue>
+#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 #ifdef HAVE_ELF_H
 #include <elf.h>
@@ -45,6 +51,8 @@
 #include <sys/elf.h>
 #endif
 
+#include <limits>
+
 using namespace GammaRay;
 
 static QString qtCoreFromLdd(const QString &path)
@@ -72,9 +80,386 @@ static QString qtCoreFromLdd(const QString &path)
   return QString();
 }
 
+#ifdef HAVE_ELF
+namespace {
+struct Elf32Types
+{
+  typedef Elf32_Ehdr Ehdr;
+  typedef Elf32_Phdr Phdr;
+  typedef Elf32_Shdr Shdr;
+  typedef Elf32_Dyn Dyn;
+#ifdef DT_VERDEF
+  typedef Elf32_Verdef Verdef;
+  typedef Elf32_Verdaux Verdaux;
+#endif
+};
+
+struct Elf64Types
+{
+  typedef Elf64_Ehdr Ehdr;
+  typedef Elf64_Phdr Phdr;
+  typedef Elf64_Shdr Shdr;
+  typedef Elf64_Dyn Dyn;
+#ifdef DT_VERDEF
+  typedef Elf64_Verdef Verdef;
+  typedef Elf64_Verdaux Verdaux;
+#endif
+};
+
+/** The parts of an ELF file we need for resolving dependencies and Qt versions. */
+struct ElfFileInfo
+{
+  ElfFileInfo() : elfClass(ELFCLASSNONE), machine(EM_NONE) {}
+
+  QString path;
+  int elfClass;
+  int machine;
+  QList<QByteArray> needed;
+  QList<QByteArray> rpath;
+  QList<QByteArray> runpath;
+  QList<QByteArray> versionDefinitions;
+  QByteArray qtCoreBanner;
+};
+}
+
+static QByteArray stringAt(const uchar *data, quint64 size, quint64 offset)
+{
+  if (offset >= size)
+    return QByteArray();
+  const char *str = reinterpret_cast<const char*>(data + offset);
+  return QByteArray(str, qstrnlen(str, qMin<quint64>(size - offset, std::numeric_limits<uint>::max())));
+}
+
+/** Checks that @p length bytes at @p offset are within a file of @p size, without overflowing for bogus values. */
+static bool isInFile(quint64 size, quint64 offset, quint64 length)
+{
+  return offset <= size && length <= size - offset;
+}
+
+template <typename T>
+static bool readElfFile(const uchar *data, quint64 size, ElfFileInfo &info)
+{
+  if (size <= sizeof(typename T::Ehdr))
+    return false;
+  const typename T::Ehdr *hdr = reinterpret_cast<const typename T::Ehdr*>(data);
+  info.machine = hdr->e_machine;
+
+  // program headers, for the dynamic section and mapping virtual addresses to file offsets
+  if (hdr->e_phoff == 0 || hdr->e_phentsize != sizeof(typename T::Phdr)
+      || !isInFile(size, hdr->e_phoff, static_cast<quint64>(hdr->e_phnum) * sizeof(typename T::Phdr)))
+    return false;
+  const typename T::Phdr *phdrs = reinterpret_cast<const typename T::Phdr*>(data + hdr->e_phoff);
+
+  auto fileOffset = [phdrs, hdr](quint64 vaddr) -> quint64 {
+    for (int i = 0; i < hdr->e_phnum; ++i) {
+      if (phdrs[i].p_type == PT_LOAD && vaddr >= phdrs[i].p_vaddr && vaddr - phdrs[i].p_vaddr < phdrs[i].p_filesz)
+        return phdrs[i].p_offset + (vaddr - phdrs[i].p_vaddr);
+    }
+    return std::numeric_limits<quint64>::max();
+  };
+
+  const typename T::Dyn *dyn = 0;
+  quint64 dynCount = 0;
+  for (int i = 0; i < hdr->e_phnum; ++i) {
+    if (phdrs[i].p_type == PT_DYNAMIC && isInFile(size, phdrs[i].p_offset, phdrs[i].p_filesz)) {
+      dyn = reinterpret_cast<const typename T::Dyn*>(data + phdrs[i].p_offset);
+      dynCount = phdrs[i].p_filesz / sizeof(typename T::Dyn);
+      break;
+    }
+  }
+
+  quint64 strtab = std::numeric_limits<quint64>::max();
+  quint64 verdef = 0;
+  quint64 verdefCount = 0;
+  QVector<quint64> needed, rpath, runpath;
+  for (quint64 i = 0; i < dynCount && dyn[i].d_tag != DT_NULL; ++i) {
+    switch (dyn[i].d_tag) {
+      case DT_NEEDED: needed.push_back(dyn[i].d_un.d_val); break;
+      case DT_RPATH: rpath.push_back(dyn[i].d_un.d_val); break;
+#ifdef DT_RUNPATH
+      case DT_RUNPATH: runpath.push_back(dyn[i].d_un.d_val); break;
+#endif
+      case DT_STRTAB: strtab = fileOffset(dyn[i].d_un.d_ptr); break;
+#ifdef DT_VERDEF
+      case DT_VERDEF: verdef = fileOffset(dyn[i].d_un.d_ptr); break;
+      case DT_VERDEFNUM: verdefCount = dyn[i].d_un.d_val; break;
+#endif
+    }
+  }
+  if (strtab >= size) { // statically linked, or nothing we understand
+    needed.clear();
+    rpath.clear();
+    runpath.clear();
+    verdefCount = 0;
+  }
+
+  foreach (quint64 offset, needed)
+    info.needed.push_back(stringAt(data, size, strtab + offset));
+  foreach (quint64 offset, rpath)
+    info.rpath += stringAt(data, size, strtab + offset).split(':');
+  foreach (quint64 offset, runpath)
+    info.runpath += stringAt(data, size, strtab + offset).split(':');
+
+#ifdef DT_VERDEF
+  // version definitions, QtCore 5 defines one per minor version ("Qt_5.6")
+  for (quint64 i = 0, offset = verdef; i < verdefCount && isInFile(size, offset, sizeof(typename T::Verdef)); ++i) {
+    const typename T::Verdef *def = reinterpret_cast<const typename T::Verdef*>(data + offset);
+    if (def->vd_cnt > 0 && isInFile(size, offset, static_cast<quint64>(def->vd_aux) + sizeof(typename T::Verdaux))) {
+      const typename T::Verdaux *aux = reinterpret_cast<const typename T::Verdaux*>(data + offset + def->vd_aux);
+      info.versionDefinitions.push_back(stringAt(data, size, strtab + aux->vda_name));
+    }
+    if (def->vd_next == 0)
+      break;
+    offset += def->vd_next;
+  }
+#else
+  Q_UNUSED(verdef);
+  Q_UNUSED(verdefCount);
+#endif
+
+  // the version banner QtCore prints when executed, in .rodata
+  if (hdr->e_shoff != 0 && hdr->e_shentsize == sizeof(typename T::Shdr) && hdr->e_shstrndx < hdr->e_shnum
+      && isInFile(size, hdr->e_shoff, static_cast<quint64>(hdr->e_shnum) * sizeof(typename T::Shdr))) {
+    const typename T::Shdr *shdrs = reinterpret_cast<const typename T::Shdr*>(data + hdr->e_shoff);
+    const quint64 shstrtab = shdrs[hdr->e_shstrndx].sh_offset;
+    for (int i = 0; i < hdr->e_shnum; ++i) {
+      if (shdrs[i].sh_type != SHT_PROGBITS || !isInFile(size, shdrs[i].sh_offset, shdrs[i].sh_size)
+          || shdrs[i].sh_size > static_cast<quint64>(std::numeric_limits<int>::max())
+          || stringAt(data, size, shstrtab + shdrs[i].sh_name) != ".rodata")
+        continue;
+      const QByteArray rodata = QByteArray::fromRawData(reinterpret_cast<const char*>(data + shdrs[i].sh_offset), shdrs[i].sh_size);
+      const int pos = rodata.indexOf("This is the QtCore library version ");
+      if (pos >= 0)
+        info.qtCoreBanner = stringAt(data, size, shdrs[i].sh_offset + pos);
+      break;
+    }
+  }
+
+  return true;
+}
+
+static bool readElfFile(const QString &path, ElfFileInfo &info)
+{
+  QFile f(path);
+  if (!f.open(QFile::ReadOnly))
+    return false;
+
+  const uchar* data = f.map(0, f.size());
+  if (!data || f.size() < EI_NIDENT)
+    return false;
+
+  if (qstrncmp(reinterpret_cast<const char*>(data), ELFMAG, SELFMAG) != 0) // no ELF signature
+    return false;
+
+  // we read the structures in place, so the byte order has to match ours
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+  if (data[EI_DATA] != ELFDATA2LSB)
+    return false;
+#else
+  if (data[EI_DATA] != ELFDATA2MSB)
+    return false;
+#endif
+
+  info.path = path;
+  info.elfClass = data[EI_CLASS];
+  switch (info.elfClass) {
+    case ELFCLASS32:
+      return readElfFile<Elf32Types>(data, f.size(), info);
+    case ELFCLASS64:
+      return readElfFile<Elf64Types>(data, f.size(), info);
+  }
+  return false;
+}
+
+/** Reads the soname to path mapping from ld.so.cache, in the (glibc >= 2.3) format written by ldconfig. */
+static QHash<QByteArray, QStringList> readLdSoCache(const QString &path)
+{
+  QHash<QByteArray, QStringList> libs;
+  QFile f(path);
+  if (!f.open(QFile::ReadOnly))
+    return libs;
+  const quint64 size = f.size();
+  const uchar* data = f.map(0, size);
+  if (!data)
+    return libs;
+
+  // older ldconfig versions put the libc5 format first, followed by the new one
+  static const char oldMagic[] = "ld.so-1.7.0";
+  static const char newMagic[] = "glibc-ld.so.cache1.1";
+  quint64 offset = 0;
+  if (size >= 16 && qstrncmp(reinterpret_cast<const char*>(data), oldMagic, sizeof(oldMagic) - 1) == 0) {
+    const quint32 oldCount = *reinterpret_cast<const quint32*>(data + 12);
+    offset = 16 + static_cast<quint64>(oldCount) * 12;
+    offset = (offset + 7) & ~static_cast<quint64>(7);
+  }
+
+  // header: magic and version, number of entries, size of the string table, 20 bytes of flags and padding
+  static const int headerSize = 48;
+  // entry: flags, soname offset, path offset, OS version, 64bit hwcap
+  static const int entrySize = 24;
+  if (!isInFile(size, offset, headerSize) || qstrncmp(reinterpret_cast<const char*>(data + offset), newMagic, sizeof(newMagic) - 1) != 0)
+    return libs;
+
+  const uchar *cache = data + offset;
+  const quint64 cacheSize = size - offset;
+  const quint32 count = *reinterpret_cast<const quint32*>(cache + 20);
+  if (!isInFile(cacheSize, headerSize, static_cast<quint64>(count) * entrySize))
+    return libs;
+
+  libs.reserve(count);
+  for (quint32 i = 0; i < count; ++i) {
+    const quint32 *entry = reinterpret_cast<const quint32*>(cache + headerSize + i * entrySize);
+    const QByteArray soname = stringAt(cache, cacheSize, entry[1]);
+    const QByteArray libPath = stringAt(cache, cacheSize, entry[2]);
+    if (!soname.isEmpty() && !libPath.isEmpty())
+      libs[soname].push_back(QFile::decodeName(libPath));
+  }
+  return libs;
+}
+
+/**
+ * Finds QtCore among the (indirect) dependencies of an executable, following the
+ * search order of the dynamic linker (see ld.so(8)) without having to run it.
+ */
+class ElfDependencyResolver
+{
+public:
+  ElfDependencyResolver()
+    : m_elfClass(ELFCLASSNONE)
+    , m_machine(EM_NONE)
+    , m_ldSoCacheLoaded(false)
+  {
+  }
+
+  QString qtCoreForExecutable(const QString &path)
+  {
+    ElfFileInfo exe;
+    if (!readElfFile(QFileInfo(path).canonicalFilePath(), exe) || exe.needed.isEmpty())
+      return QString();
+    m_elfClass = exe.elfClass;
+    m_machine = exe.machine;
+    foreach (const QByteArray &dir, qgetenv("LD_LIBRARY_PATH").split(':')) {
+      if (!dir.isEmpty())
+        m_libraryPath.push_back(QFile::decodeName(dir));
+    }
+
+    QSet<QByteArray> seen;
+    QQueue<LoadedObject> queue;
+    queue.enqueue(LoadedObject(exe, QStringList()));
+    while (!queue.isEmpty()) {
+      const LoadedObject obj = queue.dequeue();
+      foreach (const QByteArray &name, obj.info.needed) {
+        if (seen.contains(name))
+          continue;
+        seen.insert(name);
+
+        ElfFileInfo lib;
+        const bool found = findLibrary(name, obj, lib);
+        if (ProbeABIDetector::containsQtCore(name))
+          return found ? lib.path : QString();
+        if (found)
+          queue.enqueue(LoadedObject(lib, obj.rpath));
+      }
+    }
+    return QString();
+  }
+
+private:
+  struct LoadedObject
+  {
+    LoadedObject(const ElfFileInfo &i, const QStringList &loaderRPath)
+      : info(i)
+    {
+      const QString origin = QFileInfo(info.path).absolutePath();
+      runpath = expandPaths(info.runpath, origin);
+      // DT_RPATH of all loaders applies as well, unless DT_RUNPATH is present
+      rpath = expandPaths(info.rpath, origin) + loaderRPath;
+    }
+
+    static QStringList expandPaths(const QList<QByteArray> &paths, const QString &origin)
+    {
+      QStringList result;
+      foreach (const QByteArray &p, paths) {
+        if (p.isEmpty())
+          continue;
+        QString dir = QFile::decodeName(p);
+        dir.replace(QLatin1String("${ORIGIN}"), origin);
+        dir.replace(QLatin1String("$ORIGIN"), origin);
+        result.push_back(dir);
+      }
+      return result;
+    }
+
+    ElfFileInfo info;
+    QStringList rpath;
+    QStringList runpath;
+  };
+
+  bool findLibrary(const QByteArray &name, const LoadedObject &loader, ElfFileInfo &lib)
+  {
+    const QString fileName = QFile::decodeName(name);
+    if (name.contains('/'))
+      return tryLibrary(fileName, lib);
+
+    if (loader.runpath.isEmpty() && tryDirectories(loader.rpath, fileName, lib))
+      return true;
+    if (tryDirectories(m_libraryPath, fileName, lib))
+      return true;
+    if (tryDirectories(loader.runpath, fileName, lib))
+      return true;
+
+    if (!m_ldSoCacheLoaded) {
+      m_ldSoCache = readLdSoCache(QStringLiteral("/etc/ld.so.cache"));
+      m_ldSoCacheLoaded = true;
+    }
+    foreach (const QString &path, m_ldSoCache.value(name)) {
+      if (tryLibrary(path, lib))
+        return true;
+    }
+
+    QStringList defaultDirs;
+    if (m_elfClass == ELFCLASS64)
+      defaultDirs << QStringLiteral("/lib64") << QStringLiteral("/usr/lib64");
+    defaultDirs << QStringLiteral("/lib") << QStringLiteral("/usr/lib");
+    return tryDirectories(defaultDirs, fileName, lib);
+  }
+
+  bool tryDirectories(const QStringList &dirs, const QString &fileName, ElfFileInfo &lib) const
+  {
+    foreach (const QString &dir, dirs) {
+      if (tryLibrary(dir + QLatin1Char('/') + fileName, lib))
+        return true;
+    }
+    return false;
+  }
+
+  /// like ld.so, skip libraries for other architectures (eg. 32bit ones in a multilib setup)
+  bool tryLibrary(const QString &path, ElfFileInfo &lib) const
+  {
+    ElfFileInfo candidate;
+    if (!readElfFile(path, candidate) || candidate.elfClass != m_elfClass || candidate.machine != m_machine)
+      return false;
+    lib = candidate;
+    return true;
+  }
+
+  int m_elfClass;
+  int m_machine;
+  QStringList m_libraryPath;
+  QHash<QByteArray, QStringList> m_ldSoCache;
+  bool m_ldSoCacheLoaded;
+};
+#endif
+
 QString ProbeABIDetector::qtCoreForExecutable(const QString& path) const
 {
-  // TODO: add fast version reading the ELF file directly?
+#ifdef HAVE_ELF
+  ElfDependencyResolver resolver;
+  const QString qtCorePath = resolver.qtCoreForExecutable(path);
+  if (!qtCorePath.isEmpty())
+    return qtCorePath;
+#endif
+  // not an ELF file or something we didn't understand, ask the dynamic linker
   return qtCoreFromLdd(path);
 }
 
@@ -145,6 +530,51 @@ static ProbeABI qtVersionFromExec(const QString &path)
   return abi;
 }
 
+static ProbeABI qtVersionFromElf(const QString &path)
+{
+  ProbeABI abi;
+#ifdef HAVE_ELF
+  ElfFileInfo info;
+  if (!readElfFile(path, info))
+    return abi;
+
+  // "This is the QtCore library version 4.8.7" or "... version Qt 5.6.1 (x86_64-little_endian-lp64 ..."
+  const QByteArray banner = info.qtCoreBanner.left(info.qtCoreBanner.indexOf('\n'));
+  foreach (const QByteArray &token, banner.mid(banner.indexOf("version ")).split(' ')) {
+    const QList<QByteArray> version = token.split('.');
+    bool majorOk = false, minorOk = false;
+    const int major = version.value(0).toInt(&majorOk);
+    const int minor = version.value(1).toInt(&minorOk);
+    if (version.size() >= 2 && majorOk && minorOk) {
+      abi.setQtVersion(major, minor);
+      return abi;
+    }
+  }
+
+  // otherwise take the highest "Qt_X.Y" symbol version
+  int major = -1, minor = -1;
+  foreach (const QByteArray &def, info.versionDefinitions) {
+    if (!def.startsWith("Qt_"))
+      continue;
+    const QList<QByteArray> version = def.mid(3).split('.');
+    bool majorOk = false, minorOk = false;
+    const int defMajor = version.value(0).toInt(&majorOk);
+    const int defMinor = version.value(1).toInt(&minorOk);
+    if (version.size() != 2 || !majorOk || !minorOk)
+      continue;
+    if (defMajor > major || (defMajor == major && defMinor > minor)) {
+      major = defMajor;
+      minor = defMinor;
+    }
+  }
+  if (major >= 0)
+    abi.setQtVersion(major, minor);
+#else
+  Q_UNUSED(path);
+#endif
+  return abi;
+}
+
 #ifdef HAVE_ELF
 template <typename ElfEHdr>
 static QString archFromELFHeader(const uchar *data, quint64 size)
@@ -199,6 +629,8 @@ ProbeABI ProbeABIDetector::detectAbiForQtCore(const QString& path) const
 
   // try to find the version
   ProbeABI abi = qtVersionFromFileName(path);
+  if (!abi.hasQtVersion())
+    abi = qtVersionFromElf(path);
   if (!abi.hasQtVersion())
     abi = qtVersionFromExec(path);
 
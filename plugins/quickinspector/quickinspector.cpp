@@ -38,7 +38,6 @@
 
 #include <core/metaobject.h>
 #include <core/metaobjectrepository.h>
-#include <core/objecttypefilterproxymodel.h>
 #include <core/probeinterface.h>
 #include <core/propertycontroller.h>
 #include <core/remote/server.h>
@@ -53,6 +52,7 @@
 #include <QQuickItem>
 #include <QQuickWindow>
 #include <QQuickView>
+#include <QStringList>
 
 #include <QQmlContext>
 #include <QQmlEngine>
@@ -246,8 +246,7 @@ QuickInspector::QuickInspector(ProbeInterface *probe, QObject *parent)
   registerVariantHandlers();
   probe->installGlobalEventFilter(this);
 
-  QAbstractProxyModel *windowModel = new ObjectTypeFilterProxyModel<QQuickWindow>(this);
-  windowModel->setSourceModel(probe->objectListModel());
+  QAbstractItemModel *windowModel = probe->objectTypeModel(QStringList() << QStringLiteral("QQuickWindow"));
   QAbstractProxyModel * proxy = new SingleColumnObjectProxyModel(this);
   proxy->setSourceModel(windowModel);
   m_windowModel = proxy;
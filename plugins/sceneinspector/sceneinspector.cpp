@@ -35,7 +35,6 @@
 #include <core/metaobjectrepository.h>
 #include <core/propertycontroller.h>
 #include <core/varianthandler.h>
-#include <core/objecttypefilterproxymodel.h>
 #include <core/probeinterface.h>
 #include <core/singlecolumnobjectproxymodel.h>
 #include <core/remote/server.h>
@@ -54,6 +53,7 @@
 #include <QGraphicsWidget>
 #include <QGraphicsView>
 #include <QItemSelectionModel>
+#include <QStringList>
 
 #include <iostream>
 
@@ -82,9 +82,8 @@ SceneInspector::SceneInspector(ProbeInterface *probe, QObject *parent)
   connect(probe->probe(), SIGNAL(objectSelected(QObject*,QPoint)),
           SLOT(objectSelected(QObject*,QPoint)));
 
-  ObjectTypeFilterProxyModel<QGraphicsScene> *sceneFilterProxy =
-    new ObjectTypeFilterProxyModel<QGraphicsScene>(this);
-  sceneFilterProxy->setSourceModel(probe->objectListModel());
+  QAbstractItemModel *sceneFilterProxy =
+    probe->objectTypeModel(QStringList() << QStringLiteral("QGraphicsScene"));
   SingleColumnObjectProxyModel *singleColumnProxy = new SingleColumnObjectProxyModel(this);
   singleColumnProxy->setSourceModel(sceneFilterProxy);
   probe->registerModel(QStringLiteral("com.kdab.GammaRay.SceneList"), singleColumnProxy);
@@ -94,6 +93,8 @@ SceneInspector::SceneInspector(ProbeInterface *probe, QObject *parent)
           this, SLOT(sceneSelected(QItemSelection)));
 
   m_sceneModel = new SceneModel(this);
+  connect(probe->probe(), SIGNAL(objectCreated(QObject*)), m_sceneModel, SLOT(objectCreated(QObject*)));
+  connect(probe->probe(), SIGNAL(objectDestroyed(QObject*)), m_sceneModel, SLOT(objectDestroyed(QObject*)));
   auto sceneProxy = new KRecursiveFilterProxyModel(this);
   sceneProxy->setSourceModel(m_sceneModel);
   probe->registerModel(QStringLiteral("com.kdab.GammaRay.SceneGraphModel"), sceneProxy);
@@ -32,6 +32,8 @@
 #include <QGraphicsItem>
 #include <QGraphicsScene>
 #include <QPalette>
+#include <QSet>
+#include <QTimer>
 
 using namespace GammaRay;
 
@@ -43,8 +45,15 @@ using namespace GammaRay;
 
 SceneModel::SceneModel(QObject *parent)
   : QAbstractItemModel(parent),
-    m_scene(0)
+    m_scene(0),
+    m_syncTimer(new QTimer(this)),
+    m_sceneItemsValid(false)
 {
+  // changed() is emitted for every repaint, so don't sync more often than a user could notice
+  m_syncTimer->setSingleShot(true);
+  m_syncTimer->setInterval(250);
+  connect(m_syncTimer, SIGNAL(timeout()), this, SLOT(syncScene()));
+
   QGV_ITEMTYPE(QGraphicsLineItem)
   QGV_ITEMTYPE(QGraphicsPixmapItem)
   QGV_ITEMTYPE(QGraphicsRectItem)
@@ -58,7 +67,23 @@ SceneModel::SceneModel(QObject *parent)
 void SceneModel::setScene(QGraphicsScene *scene)
 {
   beginResetModel();
+  if (m_scene) {
+    disconnect(m_scene, 0, this, 0);
+  }
   m_scene = scene;
+  if (m_scene) {
+    // also covers removal and reparenting of plain QGraphicsItems, as removal triggers a full update
+    // while this signal is connected
+    connect(m_scene, SIGNAL(changed(QList<QRectF>)), this, SLOT(sceneChanged()));
+  }
+  m_syncTimer->stop();
+  m_sceneItems.clear();
+  m_sceneItemsValid = false;
+  m_children.clear();
+  m_parents.clear();
+  m_rows.clear();
+  m_objectItems.clear();
+  m_itemObjects.clear();
   endResetModel();
 }
 
@@ -73,6 +98,9 @@ QVariant SceneModel::data(const QModelIndex &index, int role) const
     return QVariant();
   }
   QGraphicsItem *item = static_cast<QGraphicsItem*>(index.internalPointer());
+  if (!m_parents.contains(item) || !isInScene(item)) {
+    return QVariant(); // removed from the scene or deleted meanwhile, and not synced yet
+  }
 
   if (item && role == Qt::DisplayRole) {
     QGraphicsObject *obj = item->toGraphicsObject();
@@ -115,13 +143,13 @@ int SceneModel::rowCount(const QModelIndex &parent) const
       return 0;
     }
     QGraphicsItem* item = static_cast<QGraphicsItem*>(parent.internalPointer());
-    if (item) {
-      return item->childItems().size();
+    if (item && isInScene(item)) {
+      return childItems(item).size();
     } else {
       return 0;
     }
   }
-  return topLevelItems().size();
+  return childItems(0).size();
 }
 
 QModelIndex SceneModel::parent(const QModelIndex &child) const
@@ -130,43 +158,282 @@ QModelIndex SceneModel::parent(const QModelIndex &child) const
     return QModelIndex();
   }
   QGraphicsItem *item = static_cast<QGraphicsItem*>(child.internalPointer());
-  if (!item->parentItem()) {
+  return indexForItem(m_parents.value(item));
+}
+
+QModelIndex SceneModel::index(int row, int column, const QModelIndex &parent) const
+{
+  if (column < 0 || column >= columnCount() || row < 0 || !m_scene) {
     return QModelIndex();
   }
-  int row = 0;
-  if (item->parentItem()->parentItem()) {
-    row = item->parentItem()->parentItem()->childItems().indexOf(item->parentItem());
+  QGraphicsItem *parentItem = 0;
+  if (parent.isValid()) {
+    parentItem = static_cast<QGraphicsItem*>(parent.internalPointer());
+    if (!parentItem || !isInScene(parentItem)) {
+      return QModelIndex();
+    }
+  }
+  const QVector<QGraphicsItem*> &children = childItems(parentItem);
+  if (row >= children.size()) {
+    return QModelIndex();
   }
-  return createIndex(row, 0, item->parentItem());
+  return createIndex(row, column, children.at(row));
 }
 
-QModelIndex SceneModel::index(int row, int column, const QModelIndex &parent) const
+const QVector<QGraphicsItem*> &SceneModel::childItems(QGraphicsItem *parent) const
 {
-  if (column < 0 || column >= columnCount()) {
-    return QModelIndex();
+  QHash<QGraphicsItem*, QVector<QGraphicsItem*> >::iterator it = m_children.find(parent);
+  if (it != m_children.end()) {
+    return it.value();
+  }
+
+  const QVector<QGraphicsItem*> children = fetchChildItems(parent);
+  for (int row = 0; row < children.size(); ++row) {
+    cacheChild(parent, children.at(row), row);
+  }
+  return m_children.insert(parent, children).value();
+}
+
+QVector<QGraphicsItem*> SceneModel::fetchChildItems(QGraphicsItem *parent) const
+{
+  QVector<QGraphicsItem*> children;
+  if (parent) {
+    children = parent->childItems().toVector();
+  } else if (m_scene) {
+    Q_FOREACH (QGraphicsItem *item, m_scene->items()) {
+      if (!item->parentItem()) {
+        children.push_back(item);
+      }
+    }
   }
-  if (!parent.isValid() && row >= 0 && row < topLevelItems().size()) {
-    return createIndex(row, column, topLevelItems().at(row));
+  return children;
+}
+
+void SceneModel::cacheChild(QGraphicsItem *parent, QGraphicsItem *child, int row) const
+{
+  m_parents.insert(child, parent);
+  m_rows.insert(child, row);
+  if (QGraphicsObject *obj = child->toGraphicsObject()) {
+    m_objectItems.insert(obj, child);
+    m_itemObjects.insert(child, obj);
+  }
+}
+
+void SceneModel::updateRows(QGraphicsItem *parent, int first)
+{
+  const QVector<QGraphicsItem*> &children = m_children[parent];
+  for (int row = first; row < children.size(); ++row) {
+    m_rows.insert(children.at(row), row);
   }
-  QGraphicsItem *parentItem = static_cast<QGraphicsItem*>(parent.internalPointer());
-  if (!parentItem || row < 0 || row >= parentItem->childItems().size()) {
+}
+
+int SceneModel::rowOf(QGraphicsItem *item) const
+{
+  return m_rows.value(item, -1);
+}
+
+QModelIndex SceneModel::indexForItem(QGraphicsItem *item) const
+{
+  if (!item) {
+    return QModelIndex();
+  }
+  const int row = rowOf(item);
+  if (row < 0) {
     return QModelIndex();
   }
-  return createIndex(row, column, parentItem->childItems().at(row));
+  return createIndex(row, 0, item);
+}
+
+bool SceneModel::isInScene(QGraphicsItem *item) const
+{
+  if (!m_scene) {
+    return false;
+  }
+  if (!m_sceneItemsValid) {
+    // items get deleted without any notification, so only trust this until we return to the event loop
+    m_sceneItems.clear();
+    Q_FOREACH (QGraphicsItem *sceneItem, m_scene->items()) {
+      m_sceneItems.insert(sceneItem);
+    }
+    m_sceneItemsValid = true;
+    QMetaObject::invokeMethod(const_cast<SceneModel*>(this), "invalidateSceneItems", Qt::QueuedConnection);
+  }
+  return m_sceneItems.contains(item);
+}
+
+void SceneModel::invalidateSceneItems()
+{
+  m_sceneItemsValid = false;
+  m_sceneItems.clear();
+}
+
+void SceneModel::sceneChanged()
+{
+  invalidateSceneItems();
+  // not restarted, so continuous changes still get synced regularly
+  if (m_scene && !m_syncTimer->isActive()) {
+    m_syncTimer->start();
+  }
 }
 
-QList<QGraphicsItem*> SceneModel::topLevelItems() const
+void SceneModel::syncScene()
 {
-  QList<QGraphicsItem*> topLevel;
   if (!m_scene) {
-    return topLevel;
+    return;
+  }
+  syncChildren(0);
+}
+
+void SceneModel::syncChildren(QGraphicsItem *parent)
+{
+  if (!m_children.contains(parent)) {
+    return;
+  }
+  // parent is still part of the scene here, as we go top-down and removed items are dropped from the cache
+  const QVector<QGraphicsItem*> current = fetchChildItems(parent);
+
+  if (current != m_children.value(parent)) {
+    const QModelIndex parentIndex = indexForItem(parent);
+
+    // remove what is gone, in contiguous ranges, from the back
+    QSet<QGraphicsItem*> currentSet;
+    Q_FOREACH (QGraphicsItem *item, current) {
+      currentSet.insert(item);
+    }
+    for (int last = m_children.value(parent).size() - 1; last >= 0; --last) {
+      if (currentSet.contains(m_children.value(parent).at(last))) {
+        continue;
+      }
+      int first = last;
+      while (first > 0 && !currentSet.contains(m_children.value(parent).at(first - 1))) {
+        --first;
+      }
+      beginRemoveRows(parentIndex, first, last);
+      QVector<QGraphicsItem*> &children = m_children[parent];
+      for (int row = first; row <= last; ++row) {
+        QGraphicsItem *item = children.at(row);
+        // don't touch items that have been moved to a parent we synced already
+        if (m_parents.value(item) == parent) {
+          removeFromCache(item);
+        }
+      }
+      children.remove(first, last - first + 1);
+      updateRows(parent, first);
+      endRemoveRows();
+      last = first;
+    }
+
+    // insert what is new, in contiguous ranges, at their current position (as far as the order matches so far)
+    QSet<QGraphicsItem*> cachedSet;
+    Q_FOREACH (QGraphicsItem *item, m_children.value(parent)) {
+      cachedSet.insert(item);
+    }
+    for (int first = 0; first < current.size(); ++first) {
+      if (cachedSet.contains(current.at(first))) {
+        continue;
+      }
+      int last = first;
+      while (last + 1 < current.size() && !cachedSet.contains(current.at(last + 1))) {
+        ++last;
+      }
+      const int row = qMin(first, m_children.value(parent).size());
+      beginInsertRows(parentIndex, row, row + last - first);
+      QVector<QGraphicsItem*> &children = m_children[parent];
+      for (int i = first; i <= last; ++i) {
+        children.insert(row + i - first, current.at(i));
+        cacheChild(parent, current.at(i), row + i - first);
+      }
+      updateRows(parent, row);
+      endInsertRows();
+      first = last;
+    }
+
+    // what remains is a change in stacking order
+    if (current != m_children.value(parent)) {
+      emit layoutAboutToBeChanged();
+      Q_FOREACH (const QModelIndex &index, persistentIndexList()) {
+        if (index.parent() != parentIndex) {
+          continue;
+        }
+        QGraphicsItem *item = static_cast<QGraphicsItem*>(index.internalPointer());
+        changePersistentIndex(index, createIndex(current.indexOf(item), index.column(), item));
+      }
+      m_children[parent] = current;
+      updateRows(parent, 0);
+      emit layoutChanged();
+    }
+  }
+
+  const QVector<QGraphicsItem*> children = m_children.value(parent);
+  Q_FOREACH (QGraphicsItem *child, children) {
+    syncChildren(child);
   }
-  Q_FOREACH (QGraphicsItem *item, m_scene->items()) {
-    if (!item->parentItem()) {
-      topLevel.push_back(item);
+}
+
+void SceneModel::removeFromCache(QGraphicsItem *item)
+{
+  QHash<QGraphicsItem*, QVector<QGraphicsItem*> >::iterator it = m_children.find(item);
+  if (it != m_children.end()) {
+    const QVector<QGraphicsItem*> children = it.value();
+    m_children.erase(it);
+    Q_FOREACH (QGraphicsItem *child, children) {
+      if (m_parents.value(child) == item) { // not moved elsewhere meanwhile
+        removeFromCache(child);
+      }
     }
   }
-  return topLevel;
+  m_parents.remove(item);
+  m_rows.remove(item);
+  QHash<QGraphicsItem*, QObject*>::iterator objIt = m_itemObjects.find(item);
+  if (objIt != m_itemObjects.end()) {
+    m_objectItems.remove(objIt.value());
+    m_itemObjects.erase(objIt);
+  }
+}
+
+void SceneModel::objectCreated(QObject *obj)
+{
+  QGraphicsObject *graphicsObject = qobject_cast<QGraphicsObject*>(obj);
+  if (!m_scene || !graphicsObject || graphicsObject->scene() != m_scene) {
+    return;
+  }
+  QGraphicsItem *item = graphicsObject;
+  QGraphicsItem *parentItem = item->parentItem();
+  QHash<QGraphicsItem*, QVector<QGraphicsItem*> >::iterator it = m_children.find(parentItem);
+  if (it == m_children.end() || m_rows.contains(item) || (parentItem && !m_rows.contains(parentItem))) {
+    return; // siblings not fetched yet, or fetched after the item was added
+  }
+
+  // top-level items are appended rather than sorted by stacking order, that would need a full scan of the scene
+  int row = parentItem ? parentItem->childItems().indexOf(item) : it.value().size();
+  row = qBound(0, row, it.value().size());
+
+  beginInsertRows(indexForItem(parentItem), row, row);
+  m_children[parentItem].insert(row, item);
+  cacheChild(parentItem, item, row);
+  updateRows(parentItem, row);
+  endInsertRows();
+}
+
+void SceneModel::objectDestroyed(QObject *obj)
+{
+  // obj is partially destroyed already, so only use what we cached about it
+  QHash<QObject*, QGraphicsItem*>::iterator objIt = m_objectItems.find(obj);
+  if (objIt == m_objectItems.end()) {
+    return;
+  }
+  QGraphicsItem *item = objIt.value();
+
+  QGraphicsItem *parentItem = m_parents.value(item);
+  const int row = m_rows.value(item);
+  // the parent is known as well, as we only fetch children of items we know
+  beginRemoveRows(indexForItem(parentItem), row, row);
+  QVector<QGraphicsItem*> &children = m_children[parentItem];
+  Q_ASSERT(children.at(row) == item);
+  children.remove(row);
+  updateRows(parentItem, row);
+  removeFromCache(item);
+  endRemoveRows();
 }
 
 QVariant SceneModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -30,10 +30,14 @@
 #define GAMMARAY_SCENEINSPECTOR_SCENEMODEL_H
 
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QSet>
+#include <QVector>
 #include <common/modelroles.h>
 
 class QGraphicsScene;
 class QGraphicsItem;
+class QTimer;
 
 namespace GammaRay {
 
@@ -54,13 +58,58 @@ class SceneModel : public QAbstractItemModel
     QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
 
+  public slots:
+    /// Inserts @p obj into the model, if it is an item of our scene
+    void objectCreated(QObject *obj);
+    /// Removes @p obj from the model, if it is an item of our scene
+    void objectDestroyed(QObject *obj);
+
+  private slots:
+    /// Schedules bringing the cached item tree in line with the scene
+    void sceneChanged();
+    /// Brings the cached item tree in line with the scene
+    void syncScene();
+    /// Drops the snapshot of the scene items used by isInScene()
+    void invalidateSceneItems();
+
   private:
-    QList<QGraphicsItem*> topLevelItems() const;
+    /// Returns the children of @p parent, or the top-level items if @p parent is null, fetching them from the scene if necessary
+    const QVector<QGraphicsItem*> &childItems(QGraphicsItem *parent) const;
+    /// Returns the current children of @p parent, or the top-level items if @p parent is null, bypassing the cache
+    QVector<QGraphicsItem*> fetchChildItems(QGraphicsItem *parent) const;
+    /// Adds @p child to the lookup tables for being at @p row below @p parent
+    void cacheChild(QGraphicsItem *parent, QGraphicsItem *child, int row) const;
+    /// Updates the cached rows of the children of @p parent, starting at @p first
+    void updateRows(QGraphicsItem *parent, int first);
+    /// Returns the cached row of @p item below its parent, or -1 if its siblings have not been fetched
+    int rowOf(QGraphicsItem *item) const;
+    QModelIndex indexForItem(QGraphicsItem *item) const;
+    /// Returns whether @p item is still part of the scene, and thus safe to dereference, without dereferencing it
+    bool isInScene(QGraphicsItem *item) const;
+    /// Applies the differences between the cached and actual children of @p parent, and then of its fetched descendants
+    void syncChildren(QGraphicsItem *parent);
+    /// Forgets everything cached for @p item and its descendants
+    void removeFromCache(QGraphicsItem *item);
     /// Returns a string type name for the given QGV item type id
     QString typeName(int itemType) const;
 
     QGraphicsScene *m_scene;
     QHash<int, QString> m_typeNames;
+
+    // the item tree, fetched lazily per parent, as items() and childItems() are expensive on large scenes
+    // plain QGraphicsItems have no change notification, so this is re-synced shortly after the scene reports changes,
+    // and item pointers are only dereferenced while they are part of the cache and of the scene
+    mutable QHash<QGraphicsItem*, QVector<QGraphicsItem*> > m_children; // parent -> children, key 0 for top-level items
+    mutable QHash<QGraphicsItem*, QGraphicsItem*> m_parents;
+    mutable QHash<QGraphicsItem*, int> m_rows;
+    // for items that are QGraphicsObjects, to find them again when they get destroyed
+    mutable QHash<QObject*, QGraphicsItem*> m_objectItems;
+    mutable QHash<QGraphicsItem*, QObject*> m_itemObjects;
+
+    QTimer *m_syncTimer;
+    // snapshot of the scene items for the current event loop iteration
+    mutable QSet<QGraphicsItem*> m_sceneItems;
+    mutable bool m_sceneItemsValid;
 };
 
 }
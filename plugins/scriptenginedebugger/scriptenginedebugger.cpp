@@ -28,12 +28,12 @@
 
 #include "scriptenginedebugger.h"
 
-#include <core/objecttypefilterproxymodel.h>
 #include <core/probeinterface.h>
 #include <core/singlecolumnobjectproxymodel.h>
 
 #include <QScriptEngine>
 #include <QDebug>
+#include <QStringList>
 #include <QtPlugin>
 
 using namespace GammaRay;
@@ -46,9 +46,8 @@ using namespace GammaRay;
 ScriptEngineDebugger::ScriptEngineDebugger(ProbeInterface *probe, QObject *parent)
   : QObject(parent)
 {
-  ObjectTypeFilterProxyModel<QScriptEngine> *scriptEngineFilter =
-    new ObjectTypeFilterProxyModel<QScriptEngine>(this);
-  scriptEngineFilter->setSourceModel(probe->objectListModel());
+  QAbstractItemModel *scriptEngineFilter =
+    probe->objectTypeModel(QStringList() << QStringLiteral("QScriptEngine"));
   SingleColumnObjectProxyModel *singleColumnProxy =
     new SingleColumnObjectProxyModel(this);
   singleColumnProxy->setSourceModel(scriptEngineFilter);
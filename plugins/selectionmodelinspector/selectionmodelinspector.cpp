@@ -28,11 +28,11 @@
 
 #include "selectionmodelinspector.h"
 
-#include <core/objecttypefilterproxymodel.h>
 #include <core/probeinterface.h>
 
 #include <common/objectbroker.h>
 
+#include <QStringList>
 #include <QtPlugin>
 
 #if QT_VERSION < QT_VERSION_CHECK(4, 8, 0)
@@ -52,9 +52,8 @@ SelectionModelInspector::SelectionModelInspector(ProbeInterface *probe, QObject
   : QObject(parent)
   , m_current(new QIdentityProxyModel(this))
 {
-  ObjectTypeFilterProxyModel<QItemSelectionModel> *selectionModelProxy =
-    new ObjectTypeFilterProxyModel<QItemSelectionModel>(this);
-  selectionModelProxy->setSourceModel(probe->objectListModel());
+  QAbstractItemModel *selectionModelProxy =
+    probe->objectTypeModel(QStringList() << QStringLiteral("QItemSelectionModel"));
   probe->registerModel(QStringLiteral("com.kdab.GammaRay.SelectionModelsModel"), selectionModelProxy);
 
   QItemSelectionModel *selectionModel = ObjectBroker::selectionModel(selectionModelProxy);
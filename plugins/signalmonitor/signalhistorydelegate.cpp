@@ -37,6 +37,7 @@
 #include <QPainter>
 #include <QTimer>
 
+#include <algorithm>
 #include <limits>
 
 using namespace GammaRay;
@@ -87,13 +88,43 @@ void SignalHistoryDelegate::paint(QPainter *painter, const QStyleOptionViewItem
 
   painter->setPen(option.palette.color(QPalette::WindowText));
 
-  foreach (qint64 ev, events) {
-    const qint64 ts = SignalHistoryModel::timestamp(ev);
-    if (ts >= startTime && ts < endTime) {
-      const int x = x0 + dx * (ts - startTime) / interval;
-      painter->drawLine(x, y0 + 1, x, y0 + dy - 2);
+  // Only the most recent events are stored individually, older ones are only available as count per bucket.
+  // When zoomed out so far that a bucket is narrower than a pixel, the buckets are good enough for everything.
+  const qint64 bucketWidth = model->data(index, SignalHistoryModel::EventBucketWidthRole).value<qint64>();
+  const bool bucketsOnly = bucketWidth > 0 && bucketWidth * dx < interval;
+  qint64 bucketsEnd = endTime;
+  if (!bucketsOnly)
+    bucketsEnd = events.isEmpty() ? startTime : qMin(endTime, SignalHistoryModel::timestamp(events.first()));
+
+  if (bucketWidth > 0 && bucketsEnd > startTime) {
+    const QVector<qint64> &buckets = model->data(index, SignalHistoryModel::EventBucketsRole).value<QVector<qint64> >();
+    const qint64 itemStartTime = model->data(index, SignalHistoryModel::StartTimeRole).value<qint64>();
+    const QColor color = option.palette.color(QPalette::WindowText);
+    for (int i = qMax(0LL, (startTime - itemStartTime) / bucketWidth); i < buckets.size(); ++i) {
+      const qint64 bucketStart = qMax(startTime, itemStartTime + i * bucketWidth);
+      const qint64 bucketEnd = qMin(bucketsEnd, itemStartTime + (i + 1) * bucketWidth);
+      if (bucketStart >= bucketsEnd)
+        break;
+      if (buckets.at(i) == 0 || bucketEnd <= bucketStart)
+        continue;
+      const int xa = x0 + dx * (bucketStart - startTime) / interval;
+      const int xb = x0 + dx * (bucketEnd - startTime) / interval;
+      painter->fillRect(xa, y0 + 1, qMax(1, xb - xa), dy - 2, color);
     }
   }
+
+  if (bucketsOnly)
+    return;
+
+  // events are sorted by time, the timestamp being stored in the upper bits
+  QVector<qint64>::const_iterator it = std::lower_bound(events.constBegin(), events.constEnd(), qMax(0LL, startTime) << 16);
+  for (; it != events.constEnd(); ++it) {
+    const qint64 ts = SignalHistoryModel::timestamp(*it);
+    if (ts >= endTime)
+      break;
+    const int x = x0 + dx * (ts - startTime) / interval;
+    painter->drawLine(x, y0 + 1, x, y0 + dy - 2);
+  }
 }
 
 QSize SignalHistoryDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &) const
@@ -38,6 +38,10 @@
 #include <QMutex>
 #include <QSet>
 #include <QThread>
+#include <QThreadStorage>
+#include <QTimer>
+
+#include <algorithm>
 
 using namespace GammaRay;
 
@@ -63,22 +67,139 @@ static T internString(const T &str)
 
 static SignalHistoryModel *s_historyModel = 0;
 
-static void signal_begin_callback(QObject *caller, int method_index, void **argv)
+namespace {
+/// A signal emission captured in a thread other than the one of the model
+struct SignalEvent
+{
+  QObject *sender;
+  int signalIndex;
+  qint64 timestamp;
+};
+
+/**
+ * Single producer/single consumer ring buffer for the emissions in one thread.
+ * Filled by that thread in the spy callback, drained by SignalHistoryModel.
+ * One slot always stays empty to tell a full buffer from an empty one.
+ */
+struct ThreadEventBuffer
+{
+  enum { Capacity = 4096 };
+
+  ThreadEventBuffer() : head(0), tail(0), dropped(0), finished(0), next(0) {}
+
+  SignalEvent events[Capacity];
+  QAtomicInt head; // next slot to write, only changed by the producer
+  QAtomicInt tail; // next slot to read, only changed by the consumer
+  QAtomicInt dropped;
+  QAtomicInt finished; // the thread is gone, can be deleted once drained
+  ThreadEventBuffer *next;
+};
+
+struct ThreadEventBuffers
+{
+  ThreadEventBuffers() : first(0) {}
+  QMutex mutex;
+  ThreadEventBuffer *first;
+};
+
+/// Owned by the thread, marks the buffer for deletion when the thread exits
+struct ThreadEventBufferRef
+{
+  explicit ThreadEventBufferRef(ThreadEventBuffer *b) : buffer(b) {}
+  ~ThreadEventBufferRef()
+  {
+    buffer->finished.fetchAndStoreRelease(1);
+  }
+  ThreadEventBuffer *buffer;
+};
+}
+
+Q_GLOBAL_STATIC(ThreadEventBuffers, s_threadEventBuffers)
+Q_GLOBAL_STATIC(QThreadStorage<ThreadEventBufferRef*>, s_threadEventBufferRef)
+
+static bool signalEventLessThan(const SignalEvent &lhs, const SignalEvent &rhs)
+{
+  return lhs.timestamp < rhs.timestamp;
+}
+
+static inline int loadAcquire(QAtomicInt &value)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+  return value.loadAcquire();
+#else
+  return value.fetchAndAddAcquire(0);
+#endif
+}
+
+static inline int loadRelaxed(const QAtomicInt &value)
 {
-  Q_UNUSED(argv);
-  if (s_historyModel) {
-    const int signalIndex = method_index + 1; // offset 1, so unknown signals end up at 0
-    static const QMetaMethod m = s_historyModel->metaObject()->method(s_historyModel->metaObject()->indexOfMethod("onSignalEmitted(QObject*,int)"));
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-    Q_ASSERT(m.isValid());
+  return value.load();
+#else
+  return value;
 #endif
-    m.invoke(s_historyModel, Qt::AutoConnection, Q_ARG(QObject*, caller), Q_ARG(int, signalIndex));
+}
+
+/// Returns the buffer of the current thread, @p created is set if it was registered by this call.
+static ThreadEventBuffer *threadEventBuffer(bool *created)
+{
+  QThreadStorage<ThreadEventBufferRef*> *storage = s_threadEventBufferRef();
+  ThreadEventBuffers *buffers = s_threadEventBuffers();
+  if (!storage || !buffers) // shutting down
+    return 0;
+
+  if (!storage->hasLocalData()) {
+    // once per thread, afterwards capturing an emission does not allocate anything
+    ThreadEventBuffer *buffer = new ThreadEventBuffer;
+    {
+      QMutexLocker lock(&buffers->mutex);
+      buffer->next = buffers->first;
+      buffers->first = buffer;
+    }
+    storage->setLocalData(new ThreadEventBufferRef(buffer));
+    *created = true;
   }
+  return storage->localData()->buffer;
 }
 
+static void signal_begin_callback(QObject *caller, int method_index, void **argv)
+{
+  Q_UNUSED(argv);
+  SignalHistoryModel *model = s_historyModel;
+  if (!model)
+    return;
+
+  const int signalIndex = method_index + 1; // offset 1, so unknown signals end up at 0
+  const qint64 timestamp = RelativeClock::sinceAppStart()->mSecs();
+  if (QThread::currentThread() == model->thread()) {
+    model->onSignalEmitted(caller, signalIndex, timestamp);
+    return;
+  }
+
+  bool created = false;
+  ThreadEventBuffer *buffer = threadEventBuffer(&created);
+  if (!buffer)
+    return;
+  if (created)
+    QMetaObject::invokeMethod(model, "startDrainTimer", Qt::QueuedConnection);
+  const int head = loadRelaxed(buffer->head);
+  const int nextHead = (head + 1) % ThreadEventBuffer::Capacity;
+  if (nextHead == loadAcquire(buffer->tail)) {
+    buffer->dropped.fetchAndAddRelaxed(1);
+    return;
+  }
+  SignalEvent &event = buffer->events[head];
+  event.sender = caller;
+  event.signalIndex = signalIndex;
+  event.timestamp = timestamp;
+  buffer->head.fetchAndStoreRelease(nextHead);
+}
 
 SignalHistoryModel::SignalHistoryModel(ProbeInterface *probe, QObject *parent)
   : QAbstractTableModel(parent)
+  , m_drainTimer(new QTimer(this))
+  , m_storedEvents(0)
+  , m_droppedEvents(0)
 {
   connect(probe->probe(), SIGNAL(objectCreated(QObject*)), this, SLOT(onObjectAdded(QObject*)));
   connect(probe->probe(), SIGNAL(objectDestroyed(QObject*)), this, SLOT(onObjectRemoved(QObject*)));
@@ -87,6 +208,10 @@ SignalHistoryModel::SignalHistoryModel(ProbeInterface *probe, QObject *parent)
   spy.signalBeginCallback = signal_begin_callback;
   probe->registerSignalSpyCallbackSet(spy);
 
+  // only needed once other threads emit signals, see startDrainTimer()
+  m_drainTimer->setInterval(50);
+  connect(m_drainTimer, SIGNAL(timeout()), this, SLOT(drainEventBuffers()));
+
   s_historyModel = this;
 }
 
@@ -134,13 +259,17 @@ QVariant SignalHistoryModel::data(const QModelIndex &index, int role) const
 
     case EventColumn:
         if (role == EventsRole)
-          return QVariant::fromValue(item(index)->events);
+          return QVariant::fromValue(item(index)->orderedEvents());
         if (role == StartTimeRole)
           return item(index)->startTime;
         if (role == EndTimeRole)
           return item(index)->endTime();
         if (role == SignalMapRole)
           return QVariant::fromValue(item(index)->signalNames);
+        if (role == EventBucketsRole)
+          return QVariant::fromValue(item(index)->eventBuckets);
+        if (role == EventBucketWidthRole)
+          return item(index)->eventBucketWidth;
 
         break;
   }
@@ -160,6 +289,8 @@ QVariant SignalHistoryModel::headerData(int section, Qt::Orientation orientation
         return tr("Events");
     }
   }
+  if (role == Qt::ToolTipRole && orientation == Qt::Horizontal && section == EventColumn && m_droppedEvents > 0)
+    return tr("%1 signal emissions in other threads could not be recorded in time.").arg(m_droppedEvents);
 
   return QVariant();
 }
@@ -171,6 +302,8 @@ QMap< int, QVariant > SignalHistoryModel::itemData(const QModelIndex& index) con
   d.insert(StartTimeRole, data(index, StartTimeRole));
   d.insert(EndTimeRole, data(index, EndTimeRole));
   d.insert(SignalMapRole, data(index, SignalMapRole));
+  d.insert(EventBucketsRole, data(index, EventBucketsRole));
+  d.insert(EventBucketWidthRole, data(index, EventBucketWidthRole));
   return d;
 }
 
@@ -209,14 +342,93 @@ void SignalHistoryModel::onObjectRemoved(QObject* object)
   emit dataChanged(index(itemIndex, EventColumn), index(itemIndex, EventColumn));
 }
 
-void SignalHistoryModel::onSignalEmitted(QObject *sender, int signalIndex)
+void SignalHistoryModel::drainEventBuffers()
+{
+  ThreadEventBuffers *buffers = s_threadEventBuffers();
+  if (!buffers)
+    return;
+
+  // don't hold the mutex while recording, threads registering their buffer would block on us
+  QVector<ThreadEventBuffer*> snapshot;
+  {
+    QMutexLocker lock(&buffers->mutex);
+    for (ThreadEventBuffer *buffer = buffers->first; buffer; buffer = buffer->next)
+      snapshot.push_back(buffer);
+  }
+
+  // only we delete buffers, so the snapshot stays valid
+  bool haveFinishedBuffers = false;
+  qint64 dropped = 0;
+  QVector<SignalEvent> events;
+  foreach (ThreadEventBuffer *buffer, snapshot) {
+    // check this first, so a finished buffer is also completely drained
+    const bool finished = loadAcquire(buffer->finished);
+    const int head = loadAcquire(buffer->head);
+    int tail = loadRelaxed(buffer->tail);
+    while (tail != head) {
+      events.push_back(buffer->events[tail]);
+      tail = (tail + 1) % ThreadEventBuffer::Capacity;
+    }
+    buffer->tail.fetchAndStoreRelease(tail);
+    dropped += buffer->dropped.fetchAndStoreRelaxed(0);
+    haveFinishedBuffers |= finished;
+  }
+
+  // each buffer is ordered already, merge them so every item receives its events in order
+  std::stable_sort(events.begin(), events.end(), signalEventLessThan);
+  QVector<int> changedRows;
+  foreach (const SignalEvent &event, events) {
+    const int row = recordEvent(event.sender, event.signalIndex, event.timestamp);
+    if (row >= 0)
+      changedRows.push_back(row);
+  }
+  std::sort(changedRows.begin(), changedRows.end());
+  changedRows.erase(std::unique(changedRows.begin(), changedRows.end()), changedRows.end());
+  foreach (int row, changedRows)
+    emit dataChanged(index(row, EventColumn), index(row, EventColumn));
+
+  if (haveFinishedBuffers) {
+    QMutexLocker lock(&buffers->mutex);
+    for (ThreadEventBuffer **link = &buffers->first; *link;) {
+      ThreadEventBuffer *buffer = *link;
+      if (loadAcquire(buffer->finished) && loadRelaxed(buffer->tail) == loadAcquire(buffer->head)) {
+        *link = buffer->next;
+        delete buffer;
+      } else {
+        link = &buffer->next;
+      }
+    }
+    // threads registering a new buffer afterwards restart the timer
+    if (!buffers->first)
+      m_drainTimer->stop();
+  }
+
+  if (dropped > 0) {
+    m_droppedEvents += dropped;
+    emit headerDataChanged(Qt::Horizontal, EventColumn, EventColumn);
+  }
+}
+
+void SignalHistoryModel::startDrainTimer()
+{
+  if (!m_drainTimer->isActive())
+    m_drainTimer->start();
+}
+
+void SignalHistoryModel::onSignalEmitted(QObject *sender, int signalIndex, qint64 timestamp)
+{
+  const int itemIndex = recordEvent(sender, signalIndex, timestamp);
+  if (itemIndex >= 0)
+    emit dataChanged(index(itemIndex, EventColumn), index(itemIndex, EventColumn));
+}
+
+int SignalHistoryModel::recordEvent(QObject *sender, int signalIndex, qint64 timestamp)
 {
   Q_ASSERT(thread() == QThread::currentThread());
-  const qint64 timestamp = RelativeClock::sinceAppStart()->mSecs();
 
   const auto it = m_itemIndex.constFind(sender);
   if (it == m_itemIndex.constEnd())
-    return;
+    return -1;
   const int itemIndex = *it;
 
   Item *data = m_tracedObjects.at(itemIndex);
@@ -226,7 +438,7 @@ void SignalHistoryModel::onSignalEmitted(QObject *sender, int signalIndex)
     // protect dereferencing of sender here
     QMutexLocker lock(Probe::objectLock());
     if (!Probe::instance()->isValidObject(sender))
-      return;
+      return -1;
     const QByteArray signalName = sender->metaObject()->method(signalIndex - 1)
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
       .signature();
@@ -236,13 +448,22 @@ void SignalHistoryModel::onSignalEmitted(QObject *sender, int signalIndex)
     data->signalNames.insert(signalIndex, internString(signalName));
   }
 
-  data->events.push_back((timestamp << 16) | signalIndex);
-  emit dataChanged(index(itemIndex, EventColumn), index(itemIndex, EventColumn));
+  const qint64 ev = (timestamp << 16) | signalIndex;
+  const bool withinBudget = m_storedEvents * sizeof(qint64) < EventBudget;
+  const bool grow = data->eventOffset == 0 && data->events.size() < MaximumEventsPerObject
+      && (withinBudget || data->events.size() < MinimumEventsPerObject);
+  if (data->insertEvent(ev, grow))
+    ++m_storedEvents;
+  data->addToBuckets(timestamp);
+
+  return itemIndex;
 }
 
 
 SignalHistoryModel::Item::Item(QObject *obj)
   : object(obj)
+  , eventOffset(0)
+  , eventBucketWidth(InitialEventBucketWidth)
   , startTime(RelativeClock::sinceAppStart()->mSecs())
 {
   objectName = Util::shortDisplayString(object);
@@ -255,7 +476,60 @@ qint64 SignalHistoryModel::Item::endTime() const
   if (object)
     return -1; // still alive
   if (!events.isEmpty())
-    return timestamp(events.size() - 1);
+    return timestamp(eventCount() - 1);
 
   return startTime;
 }
+
+QVector<qint64> SignalHistoryModel::Item::orderedEvents() const
+{
+  if (eventOffset == 0)
+    return events;
+
+  QVector<qint64> ordered;
+  ordered.reserve(events.size());
+  for (int i = 0; i < events.size(); ++i)
+    ordered.push_back(event(i));
+  return ordered;
+}
+
+bool SignalHistoryModel::Item::insertEvent(qint64 ev, bool grow)
+{
+  bool allocated = false;
+  if (grow) {
+    events.push_back(ev);
+    allocated = true;
+  } else {
+    // full, older than anything we keep, so only the buckets see it
+    if (events.isEmpty() || ev < event(0))
+      return false;
+    // overwrite the oldest event, it becomes the newest slot
+    eventOffset = (eventOffset + 1) % events.size();
+  }
+
+  // emissions from other threads arrive late, usually this doesn't move anything though
+  int i = events.size() - 1;
+  for (; i > 0 && event(i - 1) > ev; --i)
+    setEvent(i, event(i - 1));
+  setEvent(i, ev);
+  return allocated;
+}
+
+void SignalHistoryModel::Item::addToBuckets(qint64 timestamp)
+{
+  qint64 bucket = qMax(0LL, timestamp - startTime) / eventBucketWidth;
+  while (bucket >= MaximumEventBuckets) {
+    // halve the resolution by merging neighboring buckets
+    const int mergedCount = (eventBuckets.size() + 1) / 2;
+    for (int i = 0; i < mergedCount; ++i) {
+      const int j = 2 * i + 1;
+      eventBuckets[i] = eventBuckets.at(2 * i) + (j < eventBuckets.size() ? eventBuckets.at(j) : 0);
+    }
+    eventBuckets.resize(mergedCount);
+    eventBucketWidth *= 2;
+    bucket /= 2;
+  }
+  if (bucket >= eventBuckets.size())
+    eventBuckets.resize(bucket + 1);
+  ++eventBuckets[bucket];
+}
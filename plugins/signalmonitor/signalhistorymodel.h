@@ -36,6 +36,9 @@
 #include <QIcon>
 #include <QMetaMethod>
 #include <QByteArray>
+#include <QVector>
+
+class QTimer;
 
 namespace GammaRay {
 
@@ -55,12 +58,27 @@ class SignalHistoryModel : public QAbstractTableModel
       QString objectName;
       QByteArray objectType;
       QIcon decoration;
+      // the most recent events, as ring buffer once it stopped growing
       QVector<qint64> events;
+      int eventOffset; // index of the oldest event in events
+      // number of events per time bucket since startTime, covering the entire lifetime
+      QVector<qint64> eventBuckets;
+      qint64 eventBucketWidth;
       const qint64 startTime; // FIXME: make them all methods
       qint64 endTime() const;
 
-      qint64 timestamp(int i) const { return SignalHistoryModel::timestamp(events.at(i)); }
-      int signalIndex(int i) const { return SignalHistoryModel::signalIndex(events.at(i)); }
+      int eventCount() const { return events.size(); }
+      qint64 event(int i) const { return events.at((eventOffset + i) % events.size()); }
+      void setEvent(int i, qint64 ev) { events[(eventOffset + i) % events.size()] = ev; }
+      /// Returns the events ordered from oldest to newest
+      QVector<qint64> orderedEvents() const;
+      /// Inserts @p ev keeping the events sorted, @p grow tells whether capacity may be added for it.
+      /// Returns @c true if a new slot was allocated.
+      bool insertEvent(qint64 ev, bool grow);
+      void addToBuckets(qint64 timestamp);
+
+      qint64 timestamp(int i) const { return SignalHistoryModel::timestamp(event(i)); }
+      int signalIndex(int i) const { return SignalHistoryModel::signalIndex(event(i)); }
     };
 
   public:
@@ -74,7 +92,19 @@ class SignalHistoryModel : public QAbstractTableModel
       EventsRole = ObjectModel::UserRole + 1,
       StartTimeRole,
       EndTimeRole,
-      SignalMapRole
+      SignalMapRole,
+      EventBucketsRole,
+      EventBucketWidthRole
+    };
+
+    enum {
+      /// Total memory used for storing events of all objects, older events are only kept in the bucket summary.
+      EventBudget = 32 * 1024 * 1024,
+      /// Event capacity each object gets even when the budget is used up.
+      MinimumEventsPerObject = 64,
+      MaximumEventsPerObject = 16384,
+      InitialEventBucketWidth = 100, // ms
+      MaximumEventBuckets = 256
     };
 
     explicit SignalHistoryModel(ProbeInterface *probe, QObject *parent = 0);
@@ -89,17 +119,28 @@ class SignalHistoryModel : public QAbstractTableModel
     static qint64 timestamp(qint64 ev) { return ev >> 16; }
     static int signalIndex(qint64 ev) { return ev & 0xffff; }
 
+    /// Records an emission, must be called in the thread of this model.
+    void onSignalEmitted(QObject *sender, int signalIndex, qint64 timestamp);
+
   private:
     Item *item(const QModelIndex &index) const;
+    /// Stores an emission without notifying about it, returns the row of the sender or -1 if untraced.
+    int recordEvent(QObject *sender, int signalIndex, qint64 timestamp);
 
   private slots:
     void onObjectAdded(QObject *object);
     void onObjectRemoved(QObject *object);
-    void onSignalEmitted(QObject *sender, int signalIndex);
+    /// Records the emissions captured in other threads.
+    void drainEventBuffers();
+    /// Called once a thread other than ours registered its event buffer.
+    void startDrainTimer();
 
   private:
+    QTimer *m_drainTimer;
     QVector<Item *> m_tracedObjects;
     QHash<QObject*, int> m_itemIndex;
+    qint64 m_storedEvents;
+    qint64 m_droppedEvents; // emissions in other threads lost due to full buffers
 };
 
 } // namespace GammaRay
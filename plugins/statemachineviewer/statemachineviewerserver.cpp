@@ -31,7 +31,6 @@
 #include "statemachinewatcher.h"
 #include "transitionmodel.h"
 
-#include <core/objecttypefilterproxymodel.h>
 #include <core/probeinterface.h>
 #include <core/singlecolumnobjectproxymodel.h>
 #include <common/objectbroker.h>
@@ -43,6 +42,7 @@
 #include <QSignalTransition>
 #include <QStateMachine>
 #include <QItemSelectionModel>
+#include <QStringList>
 
 #include <QtPlugin>
 
@@ -104,8 +104,7 @@ StateMachineViewerServer::StateMachineViewerServer(ProbeInterface *probe, QObjec
   connect(stateSelectionModel, SIGNAL(selectionChanged(QItemSelection,QItemSelection)),
           SLOT(stateSelectionChanged()));
 
-  auto stateMachineFilter = new ObjectTypeFilterProxyModel<QStateMachine>(this);
-  stateMachineFilter->setSourceModel(probe->objectListModel());
+  auto stateMachineFilter = probe->objectTypeModel(QStringList() << QStringLiteral("QStateMachine"));
   m_stateMachinesModel = new SingleColumnObjectProxyModel(this);
   m_stateMachinesModel->setSourceModel(stateMachineFilter);
   probe->registerModel(QStringLiteral("com.kdab.GammaRay.StateMachineModel"), m_stateMachinesModel);
@@ -33,7 +33,6 @@
 #include "primitivemodel.h"
 #include "standardiconmodel.h"
 
-#include <core/objecttypefilterproxymodel.h>
 #include <core/probeinterface.h>
 #include <core/singlecolumnobjectproxymodel.h>
 
@@ -42,6 +41,7 @@
 
 #include <QApplication>
 #include <QItemSelectionModel>
+#include <QStringList>
 
 using namespace GammaRay;
 
@@ -54,8 +54,7 @@ StyleInspector::StyleInspector(ProbeInterface *probe, QObject *parent)
     m_standardIconModel(new StandardIconModel(this)),
     m_standardPaletteModel(new PaletteModel(this))
 {
-  ObjectTypeFilterProxyModel<QStyle> *styleFilter = new ObjectTypeFilterProxyModel<QStyle>(this);
-  styleFilter->setSourceModel(probe->objectListModel());
+  QAbstractItemModel *styleFilter = probe->objectTypeModel(QStringList() << QStringLiteral("QStyle"));
   SingleColumnObjectProxyModel *singleColumnProxy = new SingleColumnObjectProxyModel(this);
   singleColumnProxy->setSourceModel(styleFilter);
   probe->registerModel(QStringLiteral("com.kdab.GammaRay.StyleList"), singleColumnProxy);
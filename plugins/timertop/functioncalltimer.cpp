@@ -27,36 +27,62 @@
 */
 #include "functioncalltimer.h"
 
-#ifdef Q_OS_WIN
+#if defined(Q_OS_WIN)
 #include <Windows.h>
+#elif defined(Q_OS_MAC)
+#include <mach/mach_time.h>
+#else
+#include <ctime>
 #endif
 
-#if defined(Q_OS_MAC) && defined(__MACH__)
-#include <mach/clock.h>
-#include <mach/mach.h>
-#endif
+#include <limits>
 
 using namespace GammaRay;
 
-#ifndef Q_OS_WIN
-static void portableGetTimeUnix(timespec &t)
+static const qint64 NSecsPerSec = 1000000000;
+
+qint64 FunctionCallTimer::now()
 {
-#if defined(Q_OS_MAC)
-  clock_serv_t cclock;
-  mach_timespec_t mts;
-  host_get_clock_service(mach_host_self(), CALENDAR_CLOCK, &cclock);
-  clock_get_time(cclock, &mts);
-  mach_port_deallocate(mach_task_self(), cclock);
-  t.tv_sec = mts.tv_sec;
-  t.tv_nsec = mts.tv_nsec;
+#if defined(Q_OS_WIN)
+  static LARGE_INTEGER frequency = { { 0, 0 } };
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  // split up to not overflow for large counter values
+  return (counter.QuadPart / frequency.QuadPart) * NSecsPerSec
+       + (counter.QuadPart % frequency.QuadPart) * NSecsPerSec / frequency.QuadPart;
+#elif defined(Q_OS_MAC)
+  static mach_timebase_info_data_t timebase = { 0, 0 };
+  if (timebase.denom == 0)
+    mach_timebase_info(&timebase);
+  return mach_absolute_time() * timebase.numer / timebase.denom;
 #else
-  clock_gettime(CLOCK_REALTIME, &t);
+  // CLOCK_MONOTONIC_RAW would also be immune to NTP slewing, but is a real syscall
+  // on many kernels, while CLOCK_MONOTONIC is served from the vDSO
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return qint64(t.tv_sec) * NSecsPerSec + t.tv_nsec;
 #endif
 }
-#endif
+
+qint64 FunctionCallTimer::overhead()
+{
+  static qint64 overhead = -1;
+  if (overhead < 0) {
+    // the minimum is the best estimate for the fixed cost, larger values are due to interrupts or preemption
+    qint64 minimum = std::numeric_limits<qint64>::max();
+    for (int i = 0; i < 1000; ++i) {
+      const qint64 start = now();
+      minimum = qMin(minimum, now() - start);
+    }
+    overhead = minimum;
+  }
+  return overhead;
+}
 
 FunctionCallTimer::FunctionCallTimer()
-  : m_startTime()
+  : m_startTime(0)
   , m_active(false)
 {
 }
@@ -67,16 +93,8 @@ bool FunctionCallTimer::start()
     return false;
   }
 
-#if defined(Q_OS_WIN)
-  LARGE_INTEGER startTime;
-  bool ret = QueryPerformanceCounter(&startTime);
-  if (!ret) {
-    return false;
-  }
-  m_startTime = startTime.QuadPart;
-#else
-  portableGetTimeUnix(m_startTime);
-#endif
+  overhead(); // make sure calibration doesn't happen while we measure
+  m_startTime = now();
   m_active = true;
   return true;
 }
@@ -86,22 +104,10 @@ bool FunctionCallTimer::active() const
   return m_active;
 }
 
-int FunctionCallTimer::stop()
+qint64 FunctionCallTimer::stop()
 {
   Q_ASSERT(m_active);
+  const qint64 elapsed = now() - m_startTime;
   m_active = false;
-
-#if defined(Q_OS_WIN)
-  LARGE_INTEGER endTime;
-  LARGE_INTEGER frequency;
-  QueryPerformanceCounter(&endTime);
-  QueryPerformanceFrequency(&frequency);
-  int elapsed = ((endTime.QuadPart - m_startTime) * 1000000) / frequency.QuadPart;
-#else
-  timespec endTime;
-  portableGetTimeUnix(endTime);
-  int elapsed = (endTime.tv_nsec - m_startTime.tv_nsec) / 1000;
-  elapsed += (endTime.tv_sec - m_startTime.tv_sec) * 1000000;
-#endif
-  return elapsed;
+  return qMax<qint64>(0, elapsed - overhead());
 }
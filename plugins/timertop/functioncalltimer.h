@@ -30,24 +30,28 @@
 
 #include <qglobal.h>
 
-#include <ctime>
-
 namespace GammaRay {
 
+/** Measures the duration of a function call with nanosecond resolution,
+ *  excluding the overhead of the measurement itself.
+ */
 class FunctionCallTimer
 {
   public:
     FunctionCallTimer();
     bool start();
     bool active() const;
-    int stop();
+    /** Returns the time since start() in nanoseconds. */
+    qint64 stop();
+
+    /** Monotonic time in nanoseconds, relative to an unspecified starting point. */
+    static qint64 now();
 
   private:
-#ifndef Q_OS_WIN
-    timespec m_startTime;
-#else
+    /** The time a start()/stop() sequence without anything in between takes. */
+    static qint64 overhead();
+
     qint64 m_startTime;
-#endif
     bool m_active;
 };
 
@@ -34,7 +34,8 @@
 using namespace GammaRay;
 
 static const int maxTimeoutEvents = 1000;
-static const int maxTimeSpan = 10000;
+static const qint64 maxTimeSpan = Q_INT64_C(10000000000); // 10s in nanoseconds
+static const double NSecsPerUSec = 1000.0;
 
 TimerInfo::TimerInfo(QObject* timer) :
     m_type(QQmlTimerType),
@@ -97,12 +98,13 @@ FunctionCallTimer *TimerInfo::functionCallTimer()
 
 QString TimerInfo::wakeupsPerSec() const
 {
+  const qint64 now = FunctionCallTimer::now();
   int totalWakeups = 0;
   int start = 0;
   int end = m_timeoutEvents.size() - 1;
   for (int i = end; i >= 0; i--) {
     const TimeoutEvent &event = m_timeoutEvents.at(i);
-    if (event.timeStamp.msecsTo(QTime::currentTime()) > maxTimeSpan) {
+    if (now - event.timeStamp > maxTimeSpan) {
       start = i;
       break;
     }
@@ -110,11 +112,11 @@ QString TimerInfo::wakeupsPerSec() const
   }
 
   if (totalWakeups > 0 && end > start) {
-    const QTime startTime = m_timeoutEvents[start].timeStamp;
-    const QTime endTime = m_timeoutEvents[end].timeStamp;
-    const int timeSpan = startTime.msecsTo(endTime);
-    const float wakeupsPerSec = totalWakeups / (float)timeSpan * 1000.0f;
-    return QString::number(wakeupsPerSec, 'f', 1);
+    const qint64 timeSpan = m_timeoutEvents[end].timeStamp - m_timeoutEvents[start].timeStamp;
+    if (timeSpan > 0) {
+      const double wakeupsPerSec = totalWakeups / (double)timeSpan * 1000000000.0;
+      return QString::number(wakeupsPerSec, 'f', 1);
+    }
   }
   return QStringLiteral("0");
 }
@@ -125,11 +127,12 @@ QString TimerInfo::timePerWakeup() const
     return QStringLiteral("N/A");
   }
 
+  const qint64 now = FunctionCallTimer::now();
   int totalWakeups = 0;
-  int totalTime = 0;
+  qint64 totalTime = 0;
   for (int i = m_timeoutEvents.size() - 1; i >= 0; i--) {
     const TimeoutEvent &event = m_timeoutEvents.at(i);
-    if (event.timeStamp.msecsTo(QTime::currentTime()) > maxTimeSpan) {
+    if (now - event.timeStamp > maxTimeSpan) {
       break;
     }
     totalWakeups++;
@@ -137,7 +140,7 @@ QString TimerInfo::timePerWakeup() const
   }
 
   if (totalWakeups > 0) {
-    return QString::number(totalTime / (float)totalWakeups, 'f', 1);
+    return QString::number(totalTime / NSecsPerUSec / totalWakeups, 'f', 1);
   }
   return QStringLiteral("N/A");
 }
@@ -148,14 +151,14 @@ QString TimerInfo::maxWakeupTime() const
     return QStringLiteral("N/A");
   }
 
-  int max = 0;
+  qint64 max = 0;
   for (int i = 0; i < m_timeoutEvents.size(); i++) {
     const TimeoutEvent &event = m_timeoutEvents.at(i);
     if (event.executionTime > max) {
       max = event.executionTime;
     }
   }
-  return QString::number(max);
+  return QString::number(max / NSecsPerUSec, 'f', 1);
 }
 
 int TimerInfo::totalWakeups() const
@@ -33,7 +33,6 @@
 #include <QSharedPointer>
 #include <QPointer>
 #include <QTimer>
-#include <QTime>
 #include <QMetaType>
 
 namespace GammaRay {
@@ -49,8 +48,8 @@ class TimerInfo
 
     struct TimeoutEvent
     {
-      QTime timeStamp;
-      int executionTime;
+      qint64 timeStamp;     // FunctionCallTimer::now() at the time of the event
+      qint64 executionTime; // in nanoseconds, -1 if unknown
     };
 
     explicit TimerInfo(QObject *timer);
@@ -136,11 +136,7 @@ TimerInfoPtr TimerModel::findOrCreateQTimerTimerInfo(QObject *timer)
 
   QVariant timerInfoVariant = timer->property(timerInfoPropertyName);
   if (!timerInfoVariant.isValid()) {
-    const TimerInfoPtr info = TimerInfoPtr(new TimerInfo(timer));
-    if (m_qmlTimerTriggeredIndex < 0 && info->type() == TimerInfo::QQmlTimerType) {
-      m_qmlTimerTriggeredIndex = timer->metaObject()->indexOfMethod("triggered()");
-    }
-    timerInfoVariant.setValue(info);
+    timerInfoVariant.setValue(TimerInfoPtr(new TimerInfo(timer)));
     if (timer->thread() == QThread::currentThread()) // ### FIXME: we shouldn't use setProperty() in the first place...
       timer->setProperty(timerInfoPropertyName, timerInfoVariant);
   }
@@ -180,6 +176,31 @@ TimerInfoPtr TimerModel::findOrCreateTimerInfo(const QModelIndex &index)
   return TimerInfoPtr();
 }
 
+void TimerModel::checkForQmlTimers(int first, int last)
+{
+  if (m_qmlTimerTriggeredIndex >= 0)
+    return;
+
+  for (int row = first; row <= last; ++row) {
+    QObject *const timer = m_sourceModel->index(row, 0).data(ObjectModel::ObjectRole).value<QObject*>();
+    if (!timer)
+      continue;
+    // we can't link against QtQml, so only now we know which signal to listen to
+    const QMetaObject *mo = timer->metaObject();
+    while (mo && qstrcmp(mo->className(), "QQmlTimer") != 0)
+      mo = mo->superClass();
+    if (!mo)
+      continue;
+
+    m_qmlTimerTriggeredIndex = mo->indexOfMethod("triggered()");
+    if (m_probe && m_qmlTimerTriggeredIndex >= 0) {
+      m_signalSpyCallbacks.addMethodFilter(mo, m_qmlTimerTriggeredIndex);
+      m_probe->registerSignalSpyCallbackSet(m_signalSpyCallbacks);
+    }
+    return;
+  }
+}
+
 int TimerModel::rowFor(QObject *timer)
 {
   for (int i = 0; i < rowCount(); i++) {
@@ -252,8 +273,8 @@ void TimerModel::postSignalActivate(QObject *caller, int methodIndex)
   }
 
   TimerInfo::TimeoutEvent event;
-  event.timeStamp = QTime::currentTime();
   event.executionTime = timerInfo->functionCallTimer()->stop();
+  event.timeStamp = FunctionCallTimer::now();
   timerInfo->addEvent(event);
   const int row = rowFor(timerInfo->timerObject());
   emitTimerObjectChanged(row);
@@ -263,11 +284,11 @@ void TimerModel::setProbe(ProbeInterface *probe)
 {
   m_probe = probe;
 
-  SignalSpyCallbackSet callbacks;
-  callbacks.signalBeginCallback = signal_begin_callback;
-  callbacks.signalEndCallback = signal_end_callback;
+  m_signalSpyCallbacks.signalBeginCallback = signal_begin_callback;
+  m_signalSpyCallbacks.signalEndCallback = signal_end_callback;
+  m_signalSpyCallbacks.addMethodFilter(&QTimer::staticMetaObject, m_timeoutIndex);
 
-  probe->registerSignalSpyCallbackSet(callbacks);
+  probe->registerSignalSpyCallbackSet(m_signalSpyCallbacks);
 }
 
 void TimerModel::setSourceModel(QAbstractItemModel *sourceModel)
@@ -280,7 +301,7 @@ void TimerModel::setSourceModel(QAbstractItemModel *sourceModel)
   connect(m_sourceModel, SIGNAL(rowsAboutToBeInserted(QModelIndex,int,int)),
           this, SLOT(slotBeginInsertRows(QModelIndex,int,int)));
   connect(m_sourceModel, SIGNAL(rowsInserted(QModelIndex,int,int)),
-          this, SLOT(slotEndInsertRows()));
+          this, SLOT(slotEndInsertRows(QModelIndex,int,int)));
   connect(m_sourceModel, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
           this, SLOT(slotBeginRemoveRows(QModelIndex,int,int)));
   connect(m_sourceModel, SIGNAL(rowsRemoved(QModelIndex,int,int)),
@@ -294,6 +315,7 @@ void TimerModel::setSourceModel(QAbstractItemModel *sourceModel)
   connect(m_sourceModel, SIGNAL(layoutChanged()),
           this, SLOT(slotEndReset()));
 
+  checkForQmlTimers(0, m_sourceModel->rowCount() - 1);
   endResetModel();
 }
 
@@ -375,7 +397,7 @@ bool TimerModel::eventFilter(QObject *watched, QEvent *event)
 
     const TimerInfoPtr timerInfo = findOrCreateFreeTimerInfo(timerEvent->timerId());
     TimerInfo::TimeoutEvent timeoutEvent;
-    timeoutEvent.timeStamp = QTime::currentTime();
+    timeoutEvent.timeStamp = FunctionCallTimer::now();
     timeoutEvent.executionTime = -1;
     timerInfo->addEvent(timeoutEvent);
 
@@ -404,8 +426,10 @@ void TimerModel::slotBeginInsertRows(const QModelIndex &parent, int start, int e
   beginInsertRows(QModelIndex(), start, end);
 }
 
-void TimerModel::slotEndInsertRows()
+void TimerModel::slotEndInsertRows(const QModelIndex &parent, int start, int end)
 {
+  Q_UNUSED(parent);
+  checkForQmlTimers(start, end);
   endInsertRows();
 }
 
@@ -418,6 +442,7 @@ void TimerModel::slotBeginReset()
 
 void TimerModel::slotEndReset()
 {
+  checkForQmlTimers(0, m_sourceModel->rowCount() - 1);
   endResetModel();
 }
 
@@ -31,6 +31,7 @@
 #include "timerinfo.h"
 
 #include <common/modelroles.h>
+#include <core/signalspycallbackset.h>
 
 #include <QAbstractTableModel>
 #include <QSet>
@@ -87,7 +88,7 @@ class TimerModel : public QAbstractTableModel
     void slotBeginRemoveRows(const QModelIndex &parent, int start, int end);
     void slotEndRemoveRows();
     void slotBeginInsertRows(const QModelIndex &parent, int start, int end);
-    void slotEndInsertRows();
+    void slotEndInsertRows(const QModelIndex &parent, int start, int end);
     void slotBeginReset();
     void slotEndReset();
     void flushEmitPendingChangedRows();
@@ -107,6 +108,9 @@ class TimerModel : public QAbstractTableModel
     // Finds QObject timers
     TimerInfoPtr findOrCreateFreeTimerInfo(int timerId);
 
+    /// Enables the QQmlTimer::triggered() signal filter once the first QQmlTimer shows up in these source rows.
+    void checkForQmlTimers(int first, int last);
+
     int rowFor(QObject *timer) ;
     void emitTimerObjectChanged(int row);
     void emitFreeTimerChanged(int row);
@@ -123,6 +127,8 @@ class TimerModel : public QAbstractTableModel
     // the method index of the timeout() signal of a QTimer
     const int m_timeoutIndex;
     int m_qmlTimerTriggeredIndex;
+    // registered with a filter for the above signals, so we don't get called for anything else
+    SignalSpyCallbackSet m_signalSpyCallbacks;
 };
 
 }
@@ -30,8 +30,8 @@
 #include "timermodel.h"
 
 #include <core/probeinterface.h>
-#include <core/objecttypefilterproxymodel.h>
 
+#include <QStringList>
 #include <QtPlugin>
 
 using namespace GammaRay;
@@ -63,29 +63,14 @@ using namespace GammaRay;
 // Flash delegate when timer triggered
 // Color cell in view redish, depending on how active the timer is
 
-class TimerFilterModel : public ObjectTypeFilterProxyModel<QTimer>
-{
-  public:
-    explicit TimerFilterModel(QObject *parent) : ObjectTypeFilterProxyModel<QTimer>(parent) {}
-
-    bool filterAcceptsObject(QObject *object) const Q_DECL_OVERRIDE
-    {
-      if (object && object->inherits("QQmlTimer"))
-        return true;
-      return ObjectTypeFilterProxyModel<QTimer>::filterAcceptsObject(object);
-    }
-};
-
-
 TimerTop::TimerTop(ProbeInterface *probe, QObject *parent)
   : QObject(parent),
     m_updateTimer(new QTimer(this))
 {
   Q_ASSERT(probe);
 
-  QSortFilterProxyModel* const filterModel = new TimerFilterModel(this);
-  filterModel->setDynamicSortFilter(true);
-  filterModel->setSourceModel(probe->objectListModel());
+  QAbstractItemModel* const filterModel =
+    probe->objectTypeModel(QStringList() << QStringLiteral("QTimer") << QStringLiteral("QQmlTimer"));
   TimerModel::instance()->setParent(this); // otherwise it's not filtered out
   TimerModel::instance()->setProbe(probe);
   TimerModel::instance()->setSourceModel(filterModel);
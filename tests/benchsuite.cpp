@@ -28,17 +28,214 @@
 
 #include "benchsuite.h"
 #include "core/probe.h"
+#include "core/toolmodel.h"
 #include "core/util.h"
+#include "core/remote/remotemodelserver.h"
+#include "common/message.h"
+#include "common/sharedprobesettings.h"
+#ifdef HAVE_GAMMARAY_CLIENT
+#include "client/remotemodel.h"
+#endif
 
 #include <QtTestGui>
 
+#include <QBuffer>
 #include <QLabel>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSemaphore>
+#include <QSharedMemory>
+#include <QStandardItemModel>
+#include <QThread>
+#include <QTimer>
 #include <QTreeView>
 
+#if defined(HAVE_GAMMARAY_CLIENT) && defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
 QTEST_MAIN(GammaRay::BenchSuite)
 
 using namespace GammaRay;
 
+static void fakeRegisterServer() {}
+
+#ifdef HAVE_GAMMARAY_CLIENT
+/** Currently allocated heap memory in bytes, -1 if unknown. */
+static qint64 allocatedHeapMemory()
+{
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 33)
+  return mallinfo2().uordblks;
+#else
+  return static_cast<unsigned int>(mallinfo().uordblks);
+#endif
+#else
+  return -1;
+#endif
+}
+#endif
+
+static int s_signalCallbackCount = 0;
+static void countingSignalBeginCallback(QObject *, int, void **)
+{
+  ++s_signalCallbackCount;
+}
+
+/** Hands out probe settings over a local socket, like the launcher does. */
+class FakeLauncherThread : public QThread
+{
+  public:
+    FakeLauncherThread(const QString &serverName, const QHash<QByteArray, QByteArray> &settings) :
+      m_serverName(serverName),
+      m_settings(settings)
+    {
+    }
+
+    void waitForListening()
+    {
+      m_listening.acquire();
+    }
+
+    void stop()
+    {
+      m_stop.fetchAndStoreRelaxed(1);
+      wait();
+    }
+
+  protected:
+    void run() Q_DECL_OVERRIDE
+    {
+      QLocalServer server;
+      QLocalServer::removeServer(m_serverName);
+      server.listen(m_serverName);
+      m_listening.release();
+
+      while (m_stop.fetchAndAddAcquire(0) == 0) {
+        if (!server.waitForNewConnection(100))
+          continue;
+        QLocalSocket *socket = server.nextPendingConnection();
+        {
+          Message msg(Protocol::LauncherAddress, Protocol::ServerVersion);
+          msg.payload() << Protocol::version();
+          msg.write(socket);
+        }
+        {
+          Message msg(Protocol::LauncherAddress, Protocol::ProbeSettings);
+          msg.payload() << m_settings;
+          msg.write(socket);
+        }
+        socket->waitForBytesWritten();
+        if (socket->state() == QLocalSocket::ConnectedState)
+          socket->waitForDisconnected();
+        delete socket;
+      }
+    }
+
+  private:
+    QString m_serverName;
+    QHash<QByteArray, QByteArray> m_settings;
+    QSemaphore m_listening;
+    QAtomicInt m_stop;
+};
+
+static QHash<QByteArray, QByteArray> receiveSettingsViaSocket(const QString &serverName)
+{
+  QHash<QByteArray, QByteArray> settings;
+  QLocalSocket socket;
+  socket.connectToServer(serverName);
+  if (!socket.waitForConnected())
+    return settings;
+
+  do {
+    while (Message::canReadMessage(&socket)) {
+      const Message msg = Message::readMessage(&socket);
+      if (msg.type() == Protocol::ProbeSettings) {
+        msg.payload() >> settings;
+        socket.disconnectFromServer();
+        return settings;
+      }
+    }
+  } while (socket.waitForReadyRead());
+  return settings;
+}
+
+namespace GammaRay {
+class FakeRemoteModelServer : public RemoteModelServer
+{
+public:
+    explicit FakeRemoteModelServer(const QString &objectName) : RemoteModelServer(objectName)
+    {
+        m_myAddress = 42;
+    }
+
+    static void setup()
+    {
+        FakeRemoteModelServer::s_registerServerCallback = &fakeRegisterServer;
+    }
+
+private:
+    bool isConnected() const Q_DECL_OVERRIDE { return true; }
+    void sendMessage(const Message &msg) const Q_DECL_OVERRIDE { Q_UNUSED(msg); }
+};
+
+#ifdef HAVE_GAMMARAY_CLIENT
+/** Messages can only be read once, so pass on a serialized copy like the real connection does. */
+static Message copyMessage(const Message &msg)
+{
+  QByteArray ba;
+  QBuffer buffer(&ba);
+  buffer.open(QIODevice::ReadWrite);
+  msg.write(&buffer);
+  buffer.seek(0);
+  return Message::readMessage(&buffer);
+}
+
+class LoopbackRemoteModelServer : public FakeRemoteModelServer
+{
+  public:
+    explicit LoopbackRemoteModelServer(const QString &objectName) : FakeRemoteModelServer(objectName), client(0) {}
+    RemoteModel *client;
+
+  private:
+    void sendMessage(const Message &msg) const Q_DECL_OVERRIDE
+    {
+      if (client)
+        client->newMessage(copyMessage(msg));
+    }
+};
+
+class FakeRemoteModel : public RemoteModel
+{
+  public:
+    FakeRemoteModel(const QString &serverObject, RemoteModelServer *server) : RemoteModel(serverObject), m_server(server)
+    {
+      m_myAddress = 42;
+    }
+
+    static void setup()
+    {
+      FakeRemoteModel::s_registerClientCallback = &fakeRegisterServer;
+    }
+
+  private:
+    void sendMessage(const Message &msg) const Q_DECL_OVERRIDE
+    {
+      m_server->newRequest(copyMessage(msg));
+    }
+
+    RemoteModelServer *m_server;
+};
+
+/** Row cache layout before cells were stored inline, as a reference for the memory benchmark. */
+struct HashPerCellRow {
+  QVector<QHash<int, QVariant> > data;
+  QVector<Qt::ItemFlags> flags;
+  QVector<int> state;
+};
+#endif
+}
+
 void BenchSuite::iconForObject()
 {
   QWidget widget;
@@ -77,3 +274,353 @@ void BenchSuite::probe_objectAdded()
   qDeleteAll(objects);
   delete Probe::instance();
 }
+
+void BenchSuite::objectListModel_churn_data()
+{
+  QTest::addColumn<int>("liveObjects");
+  QTest::newRow("10000") << 10000;
+  QTest::newRow("100000") << 100000;
+}
+
+void BenchSuite::objectListModel_churn()
+{
+  QFETCH(int, liveObjects);
+
+  Probe::createProbe(false);
+  const QAbstractItemModel *model = Probe::instance()->objectListModel();
+
+  QVector<QObject*> objects;
+  objects.reserve(liveObjects);
+  for (int i = 0; i < liveObjects; ++i) {
+    QObject *obj = new QObject;
+    Probe::objectAdded(obj);
+    objects << obj;
+  }
+  const int rowCount = model->rowCount();
+
+  // replace objects all over the model, as an application allocating and freeing lots of short-lived objects would
+  static const int NUM_REPLACEMENTS = 10000;
+  int pos = 0;
+  QBENCHMARK {
+    for (int i = 0; i < NUM_REPLACEMENTS; ++i) {
+      pos = (pos + 7919) % liveObjects;
+      QObject *&obj = objects[pos];
+      Probe::objectRemoved(obj);
+      delete obj;
+      obj = new QObject;
+      Probe::objectAdded(obj);
+    }
+  }
+  QCOMPARE(model->rowCount(), rowCount);
+
+  qDeleteAll(objects);
+  delete Probe::instance();
+}
+
+void BenchSuite::objectTypeModel_churn()
+{
+  Probe::createProbe(false);
+  // what the various tools ask for
+  QStringList types;
+  types << QStringLiteral("QTimer") << QStringLiteral("QStyle") << QStringLiteral("QTextDocument")
+        << QStringLiteral("QItemSelectionModel") << QStringLiteral("QGraphicsScene") << QStringLiteral("QStateMachine");
+  foreach (const QString &type, types) {
+    Probe::instance()->objectTypeModel(QStringList() << type);
+  }
+  const QAbstractItemModel *timerModel = Probe::instance()->objectTypeModel(QStringList() << QStringLiteral("QTimer"));
+  const int timerCount = timerModel->rowCount();
+
+  // one in ten objects is a timer
+  static const int NUM_OBJECTS = 10000;
+  QVector<QObject*> objects;
+  objects.reserve(NUM_OBJECTS);
+  QBENCHMARK {
+    for (int i = 0; i < NUM_OBJECTS; ++i) {
+      QObject *obj = (i % 10 == 0) ? new QTimer : new QObject;
+      Probe::objectAdded(obj);
+      objects << obj;
+    }
+    QCOMPARE(timerModel->rowCount(), timerCount + NUM_OBJECTS / 10);
+    foreach (QObject *obj, objects) {
+      Probe::objectRemoved(obj);
+      delete obj;
+    }
+    objects.clear();
+  }
+  QCOMPARE(timerModel->rowCount(), timerCount);
+
+  delete Probe::instance();
+}
+
+void BenchSuite::toolModel_toolForObject()
+{
+  Probe::createProbe(false);
+  const ToolModel *toolModel = Probe::instance()->toolModel();
+
+  QLabel label;
+  QTreeView treeView;
+  QStandardItemModel model;
+  QTimer timer;
+  QVector<QObject*> objects;
+  objects << this << &label << &treeView << &model << &timer;
+  QVector<QModelIndex> tools;
+  foreach (QObject *obj, objects) {
+    tools << toolModel->toolForObject(obj);
+  }
+
+  QBENCHMARK {
+    for (int i = 0; i < objects.size(); ++i) {
+      QCOMPARE(toolModel->toolForObject(objects.at(i)), tools.at(i));
+    }
+  }
+
+  delete Probe::instance();
+}
+
+void BenchSuite::probeSettings_receive_data()
+{
+  QTest::addColumn<bool>("sharedMemory");
+  QTest::newRow("localSocket") << false;
+  QTest::newRow("sharedMemory") << true;
+}
+
+// startup latency added to the target by waiting for the launcher's probe settings
+void BenchSuite::probeSettings_receive()
+{
+  QFETCH(bool, sharedMemory);
+
+  QHash<QByteArray, QByteArray> settings;
+  settings.insert("ProbePath", QCoreApplication::applicationDirPath().toUtf8());
+  settings.insert("ServerAddress", "tcp://0.0.0.0:11732");
+  settings.insert("RemoteAccessEnabled", "true");
+  const qint64 launcherId = QCoreApplication::applicationPid();
+
+  if (sharedMemory) {
+    const QByteArray nonce = SharedProbeSettings::createNonce();
+    QSharedMemory memory(SharedProbeSettings::key(launcherId));
+    QVERIFY(SharedProbeSettings::publish(&memory, nonce, settings));
+    QBENCHMARK {
+      QHash<QByteArray, QByteArray> received;
+      QVERIFY(SharedProbeSettings::read(launcherId, nonce, &received));
+      QCOMPARE(received, settings);
+    }
+  } else {
+    FakeLauncherThread launcher(QStringLiteral("gammaray-benchsuite-") + QString::number(launcherId), settings);
+    launcher.start();
+    launcher.waitForListening();
+    QBENCHMARK {
+      QCOMPARE(receiveSettingsViaSocket(QStringLiteral("gammaray-benchsuite-") + QString::number(launcherId)), settings);
+    }
+    launcher.stop();
+  }
+}
+
+void BenchSuite::remoteModelServer_modelContentRequest()
+{
+  static const int NUM_ROWS = 100;
+  static const int NUM_COLUMNS = 4;
+
+  QStandardItemModel model(NUM_ROWS, NUM_COLUMNS);
+  for (int row = 0; row < NUM_ROWS; ++row) {
+    for (int column = 0; column < NUM_COLUMNS; ++column) {
+      auto item = new QStandardItem(QStringLiteral("item %1/%2").arg(row).arg(column));
+      item->setData(QVariantList() << row << column << QStringLiteral("nested"), Qt::UserRole);
+      item->setData(QStringList() << QStringLiteral("a") << QStringLiteral("b"), Qt::UserRole + 1);
+      item->setData(QRect(row, column, 10, 10), Qt::UserRole + 2);
+      model.setItem(row, column, item);
+    }
+  }
+
+  FakeRemoteModelServer::setup();
+  FakeRemoteModelServer server(QStringLiteral("com.kdab.GammaRay.Bench.Model"));
+  server.setModel(&model);
+  server.modelMonitored(true);
+
+  // serialized request for all cells, re-read for every iteration as reading consumes the message
+  QByteArray request;
+  {
+    Message msg(42, Protocol::ModelContentRequest);
+    msg.payload() << quint32(NUM_ROWS * NUM_COLUMNS);
+    for (int row = 0; row < NUM_ROWS; ++row) {
+      for (int column = 0; column < NUM_COLUMNS; ++column)
+        msg.payload() << Protocol::fromQModelIndex(model.index(row, column));
+    }
+    QBuffer buffer(&request);
+    buffer.open(QIODevice::WriteOnly);
+    msg.write(&buffer);
+  }
+
+  QBENCHMARK {
+    QBuffer buffer(&request);
+    buffer.open(QIODevice::ReadOnly);
+    server.newRequest(Message::readMessage(&buffer));
+  }
+}
+
+#ifdef HAVE_GAMMARAY_CLIENT
+void BenchSuite::remoteModel_cachedDataMemory_data()
+{
+  QTest::addColumn<bool>("hashPerCell");
+  QTest::newRow("remoteModel") << false;
+  QTest::newRow("hashPerCellReference") << true;
+}
+
+// heap memory used for the cached cell data of a table, both rows measure only the cell storage
+void BenchSuite::remoteModel_cachedDataMemory()
+{
+  QFETCH(bool, hashPerCell);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+  if (allocatedHeapMemory() < 0)
+    QSKIP("Heap usage can't be measured on this platform.");
+#else
+  QSKIP("Reporting heap usage requires Qt 5.", SkipAll);
+#endif
+
+  QStandardItemModel model(5000, 4);
+  for (int row = 0; row < model.rowCount(); ++row) {
+    for (int column = 0; column < model.columnCount(); ++column)
+      model.setItem(row, column, new QStandardItem(QStringLiteral("entry%1%2").arg(row).arg(column)));
+  }
+
+  if (hashPerCell) {
+    // the same content in the previous layout, deserialized like the client does
+    QVector<HashPerCellRow> rows(model.rowCount());
+    const qint64 allocatedBefore = allocatedHeapMemory();
+    for (int row = 0; row < model.rowCount(); ++row) {
+      HashPerCellRow &r = rows[row];
+      r.data.resize(model.columnCount());
+      r.flags.resize(model.columnCount());
+      r.state.resize(model.columnCount());
+      for (int column = 0; column < model.columnCount(); ++column) {
+        const QModelIndex index = model.index(row, column);
+        QByteArray buffer;
+        {
+          QDataStream out(&buffer, QIODevice::WriteOnly);
+          out << model.itemData(index);
+        }
+        QDataStream in(buffer);
+        QMap<int, QVariant> itemData;
+        in >> itemData;
+        for (QMap<int, QVariant>::const_iterator it = itemData.constBegin(); it != itemData.constEnd(); ++it)
+          r.data[column].insert(it.key(), it.value());
+        r.flags[column] = model.flags(index);
+      }
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    QTest::setBenchmarkResult(allocatedHeapMemory() - allocatedBefore, QTest::BytesAllocated);
+#endif
+    return;
+  }
+
+  FakeRemoteModelServer::setup();
+  FakeRemoteModel::setup();
+  LoopbackRemoteModelServer server(QStringLiteral("com.kdab.GammaRay.Bench.MemoryModel"));
+  server.setModel(&model);
+  server.modelMonitored(true);
+  FakeRemoteModel client(QStringLiteral("com.kdab.GammaRay.Bench.MemoryModel"), &server);
+  server.client = &client;
+  client.setPrefetchWindow(0);
+
+  // load the structure first, so only the cells are accounted for
+  QCOMPARE(client.rowCount(), model.rowCount());
+  QCOMPARE(client.columnCount(), model.columnCount());
+  QTest::qWait(1);
+
+  const qint64 allocatedBefore = allocatedHeapMemory();
+  for (int row = 0; row < client.rowCount(); ++row) {
+    for (int column = 0; column < client.columnCount(); ++column)
+      client.index(row, column).data();
+  }
+  QTest::qWait(1);
+  QCOMPARE(client.index(4999, 3).data().toString(), QStringLiteral("entry49993"));
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+  QTest::setBenchmarkResult(allocatedHeapMemory() - allocatedBefore, QTest::BytesAllocated);
+#endif
+}
+#endif
+
+void BenchSuite::message_read_data()
+{
+  QTest::addColumn<bool>("buffered");
+  QTest::newRow("device") << false;
+  QTest::newRow("buffered") << true;
+}
+
+void BenchSuite::message_read()
+{
+  QFETCH(bool, buffered);
+
+  // a burst of small messages as seen e.g. for property or model updates
+  static const int NUM_MESSAGES = 10000;
+  QByteArray stream;
+  {
+    QBuffer buffer(&stream);
+    buffer.open(QIODevice::WriteOnly);
+    for (int i = 0; i < NUM_MESSAGES; ++i) {
+      Message msg(42, Protocol::ModelContentChanged);
+      msg.payload() << Protocol::ModelIndex() << Protocol::ModelIndex() << QVector<int>(1, Qt::DisplayRole) << QStringLiteral("value %1").arg(i);
+      msg.write(&buffer);
+    }
+  }
+
+  QBENCHMARK {
+    int count = 0;
+    if (buffered) {
+      int offset = 0;
+      forever {
+        const int size = Message::messageSize(stream.constData() + offset, stream.size() - offset);
+        if (size < 0)
+          break;
+        const Message msg = Message::fromBuffer(stream, offset);
+        offset += size;
+        count += msg.type();
+      }
+    } else {
+      QBuffer buffer(&stream);
+      buffer.open(QIODevice::ReadOnly);
+      while (Message::canReadMessage(&buffer)) {
+        const Message msg = Message::readMessage(&buffer);
+        count += msg.type();
+      }
+    }
+    QCOMPARE(count, NUM_MESSAGES * Protocol::ModelContentChanged);
+  }
+}
+
+void BenchSuite::signalSpyCallback_emit_data()
+{
+  QTest::addColumn<bool>("withProbe");
+  QTest::addColumn<bool>("filtered");
+  QTest::newRow("no probe") << false << false;
+  QTest::newRow("probe, callback for another signal") << true << true;
+  QTest::newRow("probe, callback for all signals") << true << false;
+}
+
+void BenchSuite::signalSpyCallback_emit()
+{
+  QFETCH(bool, withProbe);
+  QFETCH(bool, filtered);
+
+  if (withProbe) {
+    Probe::createProbe(false);
+    SignalSpyCallbackSet callbacks;
+    callbacks.signalBeginCallback = countingSignalBeginCallback;
+    if (filtered)
+      callbacks.addMethodFilter(&QTimer::staticMetaObject, QTimer::staticMetaObject.indexOfSignal("timeout()"));
+    Probe::instance()->registerSignalSpyCallbackSet(callbacks);
+  }
+
+  static const int NUM_EMISSIONS = 10000;
+  s_signalCallbackCount = 0;
+  QBENCHMARK {
+    for (int i = 0; i < NUM_EMISSIONS; ++i)
+      emit benchSignal();
+  }
+  if (!withProbe || filtered)
+    QCOMPARE(s_signalCallbackCount, 0);
+  else
+    QVERIFY(s_signalCallbackCount >= NUM_EMISSIONS);
+
+  if (withProbe)
+    delete Probe::instance();
+}
@@ -40,6 +40,24 @@ class BenchSuite : public QObject
   private slots:
     void iconForObject();
     void probe_objectAdded();
+    void objectListModel_churn_data();
+    void objectListModel_churn();
+    void objectTypeModel_churn();
+    void toolModel_toolForObject();
+    void probeSettings_receive_data();
+    void probeSettings_receive();
+    void remoteModelServer_modelContentRequest();
+#ifdef HAVE_GAMMARAY_CLIENT
+    void remoteModel_cachedDataMemory_data();
+    void remoteModel_cachedDataMemory();
+#endif
+    void message_read_data();
+    void message_read();
+    void signalSpyCallback_emit_data();
+    void signalSpyCallback_emit();
+
+  signals:
+    void benchSignal();
 };
 
 }
@@ -0,0 +1,175 @@
+/*
+  messagehandlertest.cpp
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <probe/hooks.h>
+#include <probe/probecreator.h>
+#include <core/probe.h>
+#include <common/objectbroker.h>
+#include <common/modelevent.h>
+#include <common/tools/messagehandler/messagemodelroles.h>
+
+#include <QAbstractProxyModel>
+#include <QDebug>
+#include <QSignalSpy>
+#include <QtTest/qtest.h>
+#include <QObject>
+#include <QThread>
+
+using namespace GammaRay;
+
+// the previous handler, keeps the test output readable
+static void silentMessageHandler(QtMsgType, const QMessageLogContext &, const QString &)
+{
+}
+
+class LoggingThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit LoggingThread(int count) : m_count(count) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        for (int i = 0; i < m_count; ++i)
+            qDebug() << "thread message" << i;
+    }
+
+private:
+    int m_count;
+};
+
+class MessageHandlerTest : public QObject
+{
+    Q_OBJECT
+private:
+    void createProbe()
+    {
+        qputenv("GAMMARAY_ProbePath", QCoreApplication::applicationDirPath().toUtf8());
+        qputenv("GAMMARAY_MaxMessages", "10000");
+        qInstallMessageHandler(silentMessageHandler);
+        Hooks::installHooks();
+        Probe::startupHookReceived();
+        new ProbeCreator(ProbeCreator::CreateOnly);
+        QTest::qWait(1); // event loop re-entry
+    }
+
+    QAbstractItemModel *sourceModel() const
+    {
+        QAbstractProxyModel *proxy = qobject_cast<QAbstractProxyModel*>(m_model);
+        return proxy ? proxy->sourceModel() : 0;
+    }
+
+    QString lastMessage() const
+    {
+        return m_model->index(m_model->rowCount() - 1, MessageModelColumn::Message).data().toString();
+    }
+
+    QAbstractItemModel *m_model;
+
+private slots:
+    void initTestCase()
+    {
+        createProbe();
+
+        m_model = ObjectBroker::model(QStringLiteral("com.kdab.GammaRay.MessageModel"));
+        QVERIFY(m_model);
+        Model::used(m_model);
+        QVERIFY(sourceModel());
+    }
+
+    void testGuiThreadMessage()
+    {
+        const int rows = m_model->rowCount();
+        qDebug() << "gui thread message";
+        // inserted synchronously, no event loop re-entry needed
+        QCOMPARE(m_model->rowCount(), rows + 1);
+        QVERIFY(lastMessage().contains(QStringLiteral("gui thread message")));
+    }
+
+    void testBatching()
+    {
+        QTest::qWait(1); // flush anything pending
+        const int rows = m_model->rowCount();
+        QSignalSpy spy(sourceModel(), SIGNAL(rowsInserted(QModelIndex,int,int)));
+        QVERIFY(spy.isValid());
+
+        LoggingThread thread(1000);
+        thread.start();
+        QVERIFY(thread.wait(30000));
+        QCOMPARE(m_model->rowCount(), rows);
+
+        QTest::qWait(1); // event loop re-entry
+        QCOMPARE(m_model->rowCount(), rows + 1000);
+        QCOMPARE(spy.size(), 1);
+        QCOMPARE(spy.at(0).at(2).toInt() - spy.at(0).at(1).toInt() + 1, 1000);
+        QVERIFY(lastMessage().contains(QStringLiteral("999")));
+    }
+
+    void testDropping()
+    {
+        QTest::qWait(1); // flush anything pending
+        const int rows = m_model->rowCount();
+
+        // more than the queue can hold without the GUI thread draining it
+        LoggingThread thread(5000);
+        thread.start();
+        QVERIFY(thread.wait(30000));
+
+        QTest::qWait(1); // event loop re-entry
+        QCOMPARE(m_model->rowCount(), rows + 4096 + 1);
+        QVERIFY(lastMessage().contains(QStringLiteral("904")));
+    }
+
+    void testGuiThreadMessageAfterQueued()
+    {
+        QTest::qWait(1); // flush anything pending
+        const int rows = m_model->rowCount();
+
+        LoggingThread thread(10);
+        thread.start();
+        QVERIFY(thread.wait(30000));
+
+        // picks up what was queued before, in order
+        qDebug() << "gui thread message";
+        QCOMPARE(m_model->rowCount(), rows + 11);
+        QVERIFY(lastMessage().contains(QStringLiteral("gui thread message")));
+    }
+
+    void testMaximumMessageCount()
+    {
+        // enough to exceed the limit by more than 10% on top of the previous tests
+        for (int i = 0; i < 7000; ++i)
+            qDebug() << "gui thread message" << i;
+        QVERIFY(m_model->rowCount() >= 10000);
+        QVERIFY(m_model->rowCount() <= 11000);
+        QVERIFY(lastMessage().contains(QStringLiteral("6999")));
+    }
+};
+
+QTEST_MAIN(MessageHandlerTest)
+
+#include "messagehandlertest.moc"
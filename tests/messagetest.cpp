@@ -0,0 +1,168 @@
+/*
+  messagetest.cpp
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <common/message.h>
+
+#include <QBuffer>
+#include <QtTest/qtest.h>
+#include <QObject>
+#include <qendian.h>
+
+#include <limits>
+
+using namespace GammaRay;
+
+class MessageTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testCompression_data()
+    {
+        QTest::addColumn<QByteArray>("payload");
+        QTest::addColumn<bool>("allowCompression");
+        QTest::addColumn<bool>("compressed");
+
+        QByteArray random(4096, 0);
+        qsrand(42);
+        for (int i = 0; i < random.size(); ++i)
+            random[i] = static_cast<char>(qrand());
+
+        QTest::newRow("empty") << QByteArray() << true << false;
+        QTest::newRow("small") << QByteArray(16, 'a') << true << false;
+        QTest::newRow("large") << QByteArray(4096, 'a') << true << true;
+        QTest::newRow("large, disabled") << QByteArray(4096, 'a') << false << false;
+        QTest::newRow("incompressible") << random << true << false;
+    }
+
+    void testCompression()
+    {
+        QFETCH(QByteArray, payload);
+        QFETCH(bool, allowCompression);
+        QFETCH(bool, compressed);
+
+        Message msg(23, 42);
+        msg.payload() << payload;
+
+        QByteArray ba;
+        QBuffer buffer(&ba);
+        buffer.open(QIODevice::ReadWrite);
+        const Protocol::PayloadSize written = msg.write(&buffer, allowCompression);
+        buffer.seek(0);
+
+        QVERIFY(Message::canReadMessage(&buffer));
+        const auto received = Message::readMessage(&buffer);
+        QCOMPARE(received.address(), Protocol::ObjectAddress(23));
+        QCOMPARE(received.type(), Protocol::MessageType(42));
+        QByteArray receivedPayload;
+        received.payload() >> receivedPayload;
+        QCOMPARE(receivedPayload, payload);
+
+        const Protocol::PayloadSize uncompressedSize = payload.size() + sizeof(quint32); // QByteArray serialization
+        if (compressed)
+            QVERIFY(written < uncompressedSize);
+        else
+            QCOMPARE(written, uncompressedSize);
+    }
+
+    void testFromBuffer()
+    {
+        QByteArray ba;
+        QBuffer buffer(&ba);
+        buffer.open(QIODevice::WriteOnly);
+        for (int i = 0; i < 3; ++i) {
+            Message msg(23, 42 + i);
+            msg.payload() << QByteArray(i * 1024, 'a' + i);
+            msg.write(&buffer, true);
+        }
+
+        // incomplete messages
+        QCOMPARE(Message::messageSize(ba.constData(), 0), -1);
+        QCOMPARE(Message::messageSize(ba.constData(), 5), -1);
+
+        int offset = 0;
+        for (int i = 0; i < 3; ++i) {
+            const int size = Message::messageSize(ba.constData() + offset, ba.size() - offset);
+            QVERIFY(size > 0);
+            QCOMPARE(Message::messageSize(ba.constData() + offset, size - 1), -1);
+
+            const auto msg = Message::fromBuffer(ba, offset);
+            offset += size;
+            QCOMPARE(msg.type(), Protocol::MessageType(42 + i));
+            QCOMPARE(msg.payloadSize(), Protocol::PayloadSize(i * 1024 + sizeof(quint32)));
+            QByteArray payload;
+            msg.payload() >> payload;
+            QCOMPARE(payload, QByteArray(i * 1024, 'a' + i));
+            // the stream must not extend into the following message
+            QVERIFY(msg.payload().atEnd());
+        }
+        QCOMPARE(offset, ba.size());
+    }
+
+    void testMalformedSize_data()
+    {
+        QTest::addColumn<qint32>("payloadSize");
+        QTest::newRow("too large") << qint32(Message::MaximumPayloadSize + 1);
+        QTest::newRow("too large compressed") << qint32(-Message::MaximumPayloadSize - 1);
+        QTest::newRow("minimum") << std::numeric_limits<qint32>::min();
+    }
+
+    void testMalformedSize()
+    {
+        QFETCH(qint32, payloadSize);
+
+        QByteArray ba(sizeof(Protocol::PayloadSize) + sizeof(Protocol::ObjectAddress) + sizeof(Protocol::MessageType), 1);
+        qToBigEndian<Protocol::PayloadSize>(payloadSize, reinterpret_cast<uchar*>(ba.data()));
+        QCOMPARE(Message::messageSize(ba.constData(), ba.size()), int(Message::InvalidMessageSize));
+
+        QBuffer buffer(&ba);
+        buffer.open(QIODevice::ReadOnly);
+        QVERIFY(!Message::canReadMessage(&buffer));
+    }
+
+    void testCorruptUncompressedSize()
+    {
+        QByteArray ba;
+        {
+            QBuffer buffer(&ba);
+            buffer.open(QIODevice::WriteOnly);
+            Message msg(23, 42);
+            msg.payload() << QByteArray(4096, 'a');
+            msg.write(&buffer, true);
+        }
+        QVERIFY(qFromBigEndian<Protocol::PayloadSize>(reinterpret_cast<const uchar*>(ba.constData())) < 0);
+
+        // claim a huge uncompressed size, this must not be allocated
+        const int headerSize = sizeof(Protocol::PayloadSize) + sizeof(Protocol::ObjectAddress) + sizeof(Protocol::MessageType);
+        qToBigEndian<qint32>(std::numeric_limits<qint32>::max(), reinterpret_cast<uchar*>(ba.data() + headerSize));
+        const auto msg = Message::fromBuffer(ba, 0);
+        QCOMPARE(msg.payloadSize(), Protocol::PayloadSize(0));
+    }
+};
+
+QTEST_MAIN(MessageTest)
+
+#include "messagetest.moc"
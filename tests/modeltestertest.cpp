@@ -0,0 +1,129 @@
+/*
+  modeltestertest.cpp
+
+  This file is part of GammaRay, the Qt application inspection and
+  manipulation tool.
+
+  Copyright (C) 2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Author: Volker Krause <volker.krause@kdab.com>
+
+  Licensees holding valid commercial KDAB GammaRay licenses may use this file in
+  accordance with GammaRay Commercial License Agreement provided with the Software.
+
+  Contact info@kdab.com if any conditions of this licensing are not clear to you.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "core/tools/modelinspector/modeltester.h"
+
+#include <QtTest/qtest.h>
+#include <QAbstractListModel>
+#include <QObject>
+#include <QStandardItemModel>
+#include <QStringList>
+
+using namespace GammaRay;
+
+/** Announces one row less than it actually inserts. */
+class BrokenInsertModel : public QAbstractListModel
+{
+  Q_OBJECT
+public:
+  explicit BrokenInsertModel(QObject *parent = 0) : QAbstractListModel(parent)
+  {
+    m_rows << QLatin1String("a") << QLatin1String("b");
+  }
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE
+  {
+    return parent.isValid() ? 0 : m_rows.size();
+  }
+
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE
+  {
+    if (!index.isValid() || index.row() >= m_rows.size() || role != Qt::DisplayRole)
+      return QVariant();
+    return m_rows.at(index.row());
+  }
+
+  void insertTwoRows(int row)
+  {
+    beginInsertRows(QModelIndex(), row, row);
+    m_rows.insert(row, QLatin1String("x"));
+    m_rows.insert(row, QLatin1String("y"));
+    endInsertRows();
+  }
+
+private:
+  QStringList m_rows;
+};
+
+class ModelTesterTest : public QObject
+{
+  Q_OBJECT
+private slots:
+  void testCorrectModel()
+  {
+    QStandardItemModel model;
+    model.appendRow(new QStandardItem(QLatin1String("a")));
+
+    ModelTester tester;
+    QVERIFY(tester.attach(&model));
+    QVERIFY(tester.isAttached(&model));
+    QCOMPARE(tester.checkedChanges(&model), 0);
+
+    model.appendRow(new QStandardItem(QLatin1String("b")));
+    model.insertRow(0, new QStandardItem(QLatin1String("c")));
+    model.item(1)->appendRow(new QStandardItem(QLatin1String("child")));
+    model.removeRow(2);
+    model.item(0)->setText(QLatin1String("d"));
+
+    QVERIFY(tester.checkedChanges(&model) >= 5);
+    QCOMPARE(tester.failures(&model), QStringList());
+  }
+
+  void testBrokenModel()
+  {
+    BrokenInsertModel model;
+
+    ModelTester tester;
+    QVERIFY(tester.attach(&model));
+    QCOMPARE(tester.failures(&model), QStringList());
+
+    model.insertTwoRows(1);
+
+    QCOMPARE(tester.checkedChanges(&model), 1);
+    QVERIFY(!tester.failures(&model).isEmpty());
+  }
+
+  void testDetach()
+  {
+    BrokenInsertModel model;
+
+    ModelTester tester;
+    QVERIFY(tester.attach(&model));
+    tester.detach(&model);
+    QVERIFY(!tester.isAttached(&model));
+
+    model.insertTwoRows(0);
+
+    QCOMPARE(tester.checkedChanges(&model), 0);
+    QVERIFY(tester.failures(&model).isEmpty());
+  }
+};
+
+QTEST_MAIN(ModelTesterTest)
+
+#include "modeltestertest.moc"
@@ -32,7 +32,8 @@
 #include <QtTest/qtest.h>
 #include <QObject>
 #include <QThread>
-#include <QSignalSpy>
+
+#include <algorithm>
 
 using namespace GammaRay;
 
@@ -77,35 +78,46 @@ private:
 private slots:
     void testCreateDestroy_data()
     {
+        QTest::addColumn<int>("threadCount");
         QTest::addColumn<int>("batchSize");
         QTest::addColumn<int>("delay");
         QTest::addColumn<int>("iterations");
 
-        QTest::newRow("10-0-1000") << 10 << 0 << 1000;
-        QTest::newRow("100-1-100") << 100 << 1 << 100;
-        QTest::newRow("1000-10-100") << 1000 << 10 << 100;
+        QTest::newRow("10-0-1000") << 1 << 10 << 0 << 1000;
+        QTest::newRow("100-1-100") << 1 << 100 << 1 << 100;
+        QTest::newRow("1000-10-100") << 1 << 1000 << 10 << 100;
+        QTest::newRow("4x100-0-100") << 4 << 100 << 0 << 100;
+        QTest::newRow("8x1000-0-10") << 8 << 1000 << 0 << 10;
     }
 
     void testCreateDestroy()
     {
+        QFETCH(int, threadCount);
         QFETCH(int, batchSize);
         QFETCH(int, delay);
         QFETCH(int, iterations);
 
         createProbe();
 
-        Thread t;
-        t.batchSize = batchSize;
-        t.delay = delay;
-        t.iterations = iterations;
+        QVector<Thread*> threads;
+        for (int i = 0; i < threadCount; ++i) {
+            Thread *t = new Thread;
+            t->batchSize = batchSize;
+            t->delay = delay;
+            t->iterations = iterations;
+            threads.push_back(t);
+        }
         QTest::qWait(1);
 
-        QSignalSpy spy(&t, SIGNAL(finished()));
-        QVERIFY(spy.isValid());
-
         // this mainly aims at not triggering any of the sanity checks in the object models or Probe
-        t.start();
-        QVERIFY(spy.wait(30000));
+        // keep the event loop running, so that the queued object changes are processed concurrently
+        QBENCHMARK_ONCE {
+            foreach (Thread *t, threads)
+                t->start();
+            QTRY_VERIFY_WITH_TIMEOUT(std::all_of(threads.constBegin(), threads.constEnd(), [](Thread *t) { return t->isFinished(); }), 30000);
+        }
+
+        qDeleteAll(threads);
     }
 };
 
@@ -244,6 +244,11 @@ private slots:
         QCOMPARE(img.height(), 160);
         QCOMPARE(img.pixel(1,1), QColor(QStringLiteral("lightsteelblue")).rgb());
 
+        // the first frame is always sent in full
+        QVERIFY(remoteView->property("framesSent").toULongLong() >= 1);
+        QVERIFY(remoteView->property("keyFramesSent").toULongLong() >= 1);
+        QVERIFY(remoteView->property("imageBytesSent").toULongLong() >= (quint64)img.bytesPerLine() * img.height());
+
         remoteView->setViewActive(false);
     }
 
@@ -56,6 +56,9 @@ public:
         FakeRemoteModelServer::s_registerServerCallback = &fakeRegisterServer;
     }
 
+    // types of all messages sent so far
+    mutable QVector<Protocol::MessageType> sentMessageTypes;
+
 signals:
     void message(const GammaRay::Message &msg);
 
@@ -63,6 +66,7 @@ private:
     bool isConnected() const Q_DECL_OVERRIDE { return true; }
     void sendMessage(const Message& msg) const Q_DECL_OVERRIDE
     {
+        sentMessageTypes.push_back(msg.type());
         QByteArray ba;
         QBuffer buffer(&ba);
         buffer.open(QIODevice::ReadWrite);
@@ -161,14 +165,14 @@ private slots:
         QCOMPARE(client.rowCount(index), 0);
 
         listModel->insertRow(1, new QStandardItem(QStringLiteral("entry1")));
-        QCOMPARE(client.rowCount(), 5);
+        QTRY_COMPARE(client.rowCount(), 5);
         index = client.index(1, 0);
         index.data(); // need an event loop entry for the data retrieval
         QTest::qWait(1);
         QCOMPARE(index.data().toString(), QStringLiteral("entry1"));
 
         listModel->takeRow(3);
-        QCOMPARE(client.rowCount(), 4);
+        QTRY_COMPARE(client.rowCount(), 4);
     }
 
     void testTreeRemoteModel()
@@ -210,7 +214,7 @@ private slots:
         QCOMPARE(client.rowCount(i12), 0);
 
         e1->insertRow(1, new QStandardItem(QStringLiteral("entry11")));
-        QCOMPARE(client.rowCount(i1), 3);
+        QTRY_COMPARE(client.rowCount(i1), 3);
         auto i11 = client.index(1, 0, i1);
         i11.data(); // need an event loop entry for the data retrieval
         QTest::qWait(1);
@@ -218,11 +222,101 @@ private slots:
         QCOMPARE(client.rowCount(i11), 0);
 
         e1->takeRow(0);
-        QCOMPARE(client.rowCount(i1), 2);
+        QTRY_COMPARE(client.rowCount(i1), 2);
         i11 = client.index(0, 0, i1);
         QCOMPARE(i11.data().toString(), QStringLiteral("entry11"));
     }
 
+    void testBatchedChanges()
+    {
+        auto listModel = new QStandardItemModel(this);
+        listModel->appendRow(new QStandardItem(QStringLiteral("entry0")));
+
+        FakeRemoteModelServer server(QStringLiteral("com.kdab.GammaRay.UnitTest.BatchModel"), this);
+        server.setModel(listModel);
+        server.modelMonitored(true);
+
+        FakeRemoteModel client(QStringLiteral("com.kdab.GammaRay.UnitTest.BatchModel"), this);
+        connect(&server, SIGNAL(message(GammaRay::Message)), &client, SLOT(newMessage(GammaRay::Message)));
+        connect(&client, SIGNAL(message(GammaRay::Message)), &server, SLOT(newRequest(GammaRay::Message)));
+
+        ModelTest modelTest(&client);
+        QTest::qWait(10);
+        QCOMPARE(client.rowCount(), 1);
+
+        server.sentMessageTypes.clear();
+        for (int i = 1; i <= 10; ++i)
+            listModel->appendRow(new QStandardItem(QStringLiteral("entry%1").arg(i)));
+        listModel->item(5)->setText(QStringLiteral("changed"));
+        listModel->item(6)->setText(QStringLiteral("changed"));
+        listModel->removeRows(5, 2);
+        QVERIFY(server.sentMessageTypes.isEmpty());
+
+        QTRY_COMPARE(client.rowCount(), 9);
+        // one compound message with the inserted rows and the removal, the data changes are dropped
+        QCOMPARE(server.sentMessageTypes.count(Protocol::ModelChangeBatch), 1);
+        QCOMPARE(server.sentMessageTypes.count(Protocol::ModelRowsAdded), 0);
+        QCOMPARE(server.sentMessageTypes.count(Protocol::ModelRowsRemoved), 0);
+        QCOMPARE(server.sentMessageTypes.count(Protocol::ModelContentChanged), 0);
+
+        auto index = client.index(5, 0);
+        index.data(); // need an event loop entry for the data retrieval
+        QTest::qWait(1);
+        QCOMPARE(index.data().toString(), QStringLiteral("entry7"));
+    }
+
+    void testColumns()
+    {
+        auto tableModel = new QStandardItemModel(2, 3, this);
+        for (int row = 0; row < 2; ++row) {
+            for (int column = 0; column < 3; ++column) {
+                auto item = new QStandardItem(QStringLiteral("entry%1%2").arg(row).arg(column));
+                item->setToolTip(QStringLiteral("tooltip"));
+                item->setStatusTip(QStringLiteral("statustip"));
+                item->setWhatsThis(QStringLiteral("whatsthis"));
+                tableModel->setItem(row, column, item);
+            }
+        }
+
+        FakeRemoteModelServer server(QStringLiteral("com.kdab.GammaRay.UnitTest.TableModel"), this);
+        server.setModel(tableModel);
+        server.modelMonitored(true);
+
+        FakeRemoteModel client(QStringLiteral("com.kdab.GammaRay.UnitTest.TableModel"), this);
+        connect(&server, SIGNAL(message(GammaRay::Message)), &client, SLOT(newMessage(GammaRay::Message)));
+        connect(&client, SIGNAL(message(GammaRay::Message)), &server, SLOT(newRequest(GammaRay::Message)));
+        client.setPrefetchWindow(0);
+
+        QCOMPARE(client.rowCount(), 2);
+        QCOMPARE(client.columnCount(), 3);
+
+        // only the right-most column is loaded first
+        auto index = client.index(1, 2);
+        index.data();
+        QTest::qWait(1);
+        QCOMPARE(index.data().toString(), QStringLiteral("entry12"));
+        // more roles than fit into the inline storage of a cell
+        QCOMPARE(index.data(Qt::ToolTipRole).toString(), QStringLiteral("tooltip"));
+        QCOMPARE(index.data(Qt::StatusTipRole).toString(), QStringLiteral("statustip"));
+        QCOMPARE(index.data(Qt::WhatsThisRole).toString(), QStringLiteral("whatsthis"));
+
+        tableModel->insertColumn(1);
+        QTRY_COMPARE(client.columnCount(), 4);
+        index = client.index(1, 3);
+        index.data();
+        QTest::qWait(1);
+        QCOMPARE(index.data().toString(), QStringLiteral("entry12"));
+
+        tableModel->removeColumns(0, 2);
+        QTRY_COMPARE(client.columnCount(), 2);
+        index = client.index(1, 0);
+        index.data();
+        QTest::qWait(1);
+        QCOMPARE(index.data().toString(), QStringLiteral("entry11"));
+        index = client.index(1, 1);
+        QCOMPARE(index.data().toString(), QStringLiteral("entry12"));
+    }
+
     // this should not make a difference if the above works, however it broke massively with Qt 5.4...
     void testSortProxy()
     {
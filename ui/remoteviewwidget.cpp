@@ -97,6 +97,7 @@ void RemoteViewWidget::setName(const QString& name)
     m_interface = ObjectBroker::object<RemoteViewInterface*>(name);
     connect(m_interface, SIGNAL(reset()), this, SLOT(reset()));
     connect(m_interface, SIGNAL(frameUpdated(GammaRay::RemoteViewFrame)), this, SLOT(frameUpdated(GammaRay::RemoteViewFrame)));
+    m_interface->setTileEncodingEnabled(true);
     m_interface->clientViewUpdated();
 }
 
@@ -170,7 +171,16 @@ const RemoteViewFrame& RemoteViewWidget::frame() const
 
 void RemoteViewWidget::frameUpdated(const RemoteViewFrame& frame)
 {
-    if (!m_frame.isValid()) {
+    if (!frame.isValid() && frame.isDelta()) {
+        RemoteViewFrame f(frame);
+        if (!f.applyDelta(m_frame)) {
+            m_interface->requestKeyFrame();
+            QMetaObject::invokeMethod(m_interface, "clientViewUpdated", Qt::QueuedConnection);
+            return;
+        }
+        m_frame = f;
+        update();
+    } else if (!m_frame.isValid()) {
         m_frame = frame;
         fitToView();
     } else {
@@ -28,6 +28,8 @@
 
 #include "messagehandlerclient.h"
 
+#include <common/endpoint.h>
+
 using namespace GammaRay;
 
 MessageHandlerClient::MessageHandlerClient(QObject *parent)
@@ -36,3 +38,8 @@ MessageHandlerClient::MessageHandlerClient(QObject *parent)
 
 }
 
+void MessageHandlerClient::requestBacktrace(qint64 id)
+{
+  Endpoint::instance()->invokeObject(objectName(), "requestBacktrace", QVariantList() << id);
+}
+
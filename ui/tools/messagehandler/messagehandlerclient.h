@@ -39,6 +39,9 @@ class MessageHandlerClient : public MessageHandlerInterface
   Q_INTERFACES(GammaRay::MessageHandlerInterface)
   public:
     explicit MessageHandlerClient(QObject *parent = 0);
+
+  public slots:
+    void requestBacktrace(qint64 id) Q_DECL_OVERRIDE;
 };
 
 }
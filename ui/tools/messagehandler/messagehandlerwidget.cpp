@@ -43,6 +43,7 @@
 #include <QDialogButtonBox>
 #include <QLabel>
 #include <QListWidget>
+#include <QAction>
 #include <QMenu>
 #include <QTime>
 #include <QPushButton>
@@ -61,13 +62,17 @@ static QObject *createClientMessageHandler(const QString &/*name*/, QObject *par
 MessageHandlerWidget::MessageHandlerWidget(QWidget *parent)
   : QWidget(parent),
     ui(new Ui::MessageHandlerWidget),
-    m_backtraceModel(new QStringListModel(this))
+    m_backtraceModel(new QStringListModel(this)),
+    m_backtraceId(-1),
+    m_copyBacktraceId(-1)
 {
   ObjectBroker::registerClientObjectFactoryCallback<MessageHandlerInterface*>(createClientMessageHandler);
   MessageHandlerInterface *handler = ObjectBroker::object<MessageHandlerInterface*>();
 
   connect(handler, SIGNAL(fatalMessageReceived(QString,QString,QTime,QStringList)),
           this, SLOT(fatalMessageReceived(QString,QString,QTime,QStringList)));
+  connect(handler, SIGNAL(backtraceAvailable(qint64,QStringList)),
+          this, SLOT(backtraceAvailable(qint64,QStringList)));
 
   ui->setupUi(this);
 
@@ -161,14 +166,27 @@ void MessageHandlerWidget::messageContextMenu(const QPoint &pos)
     return;
 
   const auto fileName = index.data(MessageModelRole::File).toString();
-  if (fileName.isEmpty())
-    return;
   const auto line = index.data(MessageModelRole::Line).toInt();
 
   QMenu contextMenu;
-  contextMenu.addAction(tr("Show source: %1:%2").arg(fileName).arg(line));
-  if (contextMenu.exec(ui->messageView->viewport()->mapToGlobal(pos)))
+  QAction *showSourceAction = 0;
+  if (!fileName.isEmpty())
+    showSourceAction = contextMenu.addAction(tr("Show source: %1:%2").arg(fileName).arg(line));
+  QAction *copyBacktraceAction = contextMenu.addAction(tr("Copy Backtrace"));
+
+  QAction *action = contextMenu.exec(ui->messageView->viewport()->mapToGlobal(pos));
+  if (!action)
+    return;
+  if (action == showSourceAction) {
     UiIntegration::requestNavigateToCode(fileName, line, 0);
+  } else if (action == copyBacktraceAction) {
+    bool ok = false;
+    const qint64 id = index.sibling(index.row(), 0).data(MessageModelRole::Id).toLongLong(&ok);
+    if (!ok)
+      return;
+    m_copyBacktraceId = id;
+    ObjectBroker::object<MessageHandlerInterface*>()->requestBacktrace(id);
+  }
 }
 
 void MessageHandlerWidget::messageSelected(const QItemSelection& selection)
@@ -180,11 +198,27 @@ void MessageHandlerWidget::messageSelected(const QItemSelection& selection)
   if (!index.isValid())
     return;
 
-  const auto bt = index.sibling(index.row(), 0).data(MessageModelRole::Backtrace).toStringList();
-  if (bt.isEmpty()) {
-    ui->backtraceView->hide();
-  } else {
-    ui->backtraceView->show();
-    m_backtraceModel->setStringList(bt);
+  // symbolizing is expensive, so this is only fetched for the selected message
+  ui->backtraceView->hide();
+  bool ok = false;
+  const qint64 id = index.sibling(index.row(), 0).data(MessageModelRole::Id).toLongLong(&ok);
+  if (!ok)
+    return;
+  m_backtraceId = id;
+  ObjectBroker::object<MessageHandlerInterface*>()->requestBacktrace(id);
+}
+
+void MessageHandlerWidget::backtraceAvailable(qint64 id, const QStringList &backtrace)
+{
+  if (m_backtraceId >= 0 && m_backtraceId == id) {
+    m_backtraceId = -1;
+    if (!backtrace.isEmpty()) {
+      ui->backtraceView->show();
+      m_backtraceModel->setStringList(backtrace);
+    }
+  }
+  if (m_copyBacktraceId >= 0 && m_copyBacktraceId == id) {
+    m_copyBacktraceId = -1;
+    copyToClipboard(backtrace.join(QStringLiteral("\n")));
   }
 }
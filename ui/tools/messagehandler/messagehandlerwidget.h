@@ -53,10 +53,14 @@ class MessageHandlerWidget : public QWidget
     void copyToClipboard(const QString &message);
     void messageContextMenu(const QPoint &pos);
     void messageSelected(const QItemSelection &selection);
+    void backtraceAvailable(qint64 id, const QStringList &backtrace);
 
   private:
     QScopedPointer<Ui::MessageHandlerWidget> ui;
     QStringListModel *m_backtraceModel;
+    // MessageModelRole::Id of the messages we requested the backtrace for, to show it or to copy it to the clipboard, -1 if none
+    qint64 m_backtraceId;
+    qint64 m_copyBacktraceId;
 };
 
 }
@@ -28,6 +28,8 @@
 
 #include "modelinspectorclient.h"
 
+#include <common/endpoint.h>
+
 using namespace GammaRay;
 
 ModelInspectorClient::ModelInspectorClient(QObject *parent)
@@ -41,3 +43,7 @@ ModelInspectorClient::~ModelInspectorClient()
 
 }
 
+void ModelInspectorClient::setModelTestEnabled(bool enabled)
+{
+  Endpoint::instance()->invokeObject(objectName(), "setModelTestEnabled", QVariantList() << enabled);
+}
@@ -40,6 +40,8 @@ class ModelInspectorClient : public ModelInspectorInterface
   public:
     explicit ModelInspectorClient(QObject *parent = 0);
     virtual ~ModelInspectorClient();
+
+    void setModelTestEnabled(bool enabled) Q_DECL_OVERRIDE;
 };
 
 }
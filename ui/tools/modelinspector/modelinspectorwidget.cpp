@@ -56,6 +56,10 @@ ModelInspectorWidget::ModelInspectorWidget(QWidget *parent)
   m_interface = ObjectBroker::object<ModelInspectorInterface*>();
   connect(m_interface, SIGNAL(cellSelected(int,int,QString,QString)),
           SLOT(cellSelected(int,int,QString,QString)));
+  connect(m_interface, SIGNAL(modelTestResult(bool,QString,QStringList)),
+          SLOT(modelTestResult(bool,QString,QStringList)));
+  connect(ui->modelTestCheckBox, SIGNAL(clicked(bool)),
+          m_interface, SLOT(setModelTestEnabled(bool)));
 
   auto modelModel = ObjectBroker::model(QStringLiteral("com.kdab.GammaRay.ModelModel"));
   ui->modelView->setModel(modelModel);
@@ -103,6 +107,7 @@ void ModelInspectorWidget::modelSelected(const QItemSelection& selected)
   } else {
     ui->modelContentView->setModel(0);
   }
+  ui->modelTestCheckBox->setEnabled(index.isValid());
 
   // clear the cell info box
   cellSelected(-1, -1, QString(), QString());
@@ -132,3 +137,9 @@ void ModelInspectorWidget::setupModelContentSelectionModel()
   ui->modelContentView->setSelectionModel(ObjectBroker::selectionModel(ui->modelContentView->model()));
 }
 
+void ModelInspectorWidget::modelTestResult(bool enabled, const QString &summary, const QStringList &failures)
+{
+  ui->modelTestCheckBox->setChecked(enabled);
+  ui->modelTestLabel->setText(summary);
+  ui->modelTestLabel->setToolTip(failures.join(QStringLiteral("\n")));
+}
@@ -29,6 +29,7 @@
 #ifndef GAMMARAY_MODELINSPECTOR_MODELINSPECTORWIDGET_H
 #define GAMMARAY_MODELINSPECTOR_MODELINSPECTORWIDGET_H
 
+#include <QStringList>
 #include <QWidget>
 
 class QItemSelection;
@@ -54,6 +55,7 @@ class ModelInspectorWidget : public QWidget
     void objectRegistered(const QString &objectName);
     void modelSelected(const QItemSelection& selected);
     void setupModelContentSelectionModel();
+    void modelTestResult(bool enabled, const QString &summary, const QStringList &failures);
 
   private:
     QScopedPointer<Ui::ModelInspectorWidget> ui;